@@ -0,0 +1,128 @@
+// Compares the per-request latency of the three ways to wait for a request:
+// blocking on a std::future, awaiting a completion token which hops to the
+// client's I/O thread, and awaiting the coroutine directly on the caller's
+// executor.
+//
+// Usage: bench_await_latency <apiUrl> [requests]
+
+#include "outline/OutlineClient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void report(const std::string& name, std::vector<double> micros) {
+  std::sort(micros.begin(), micros.end());
+  auto percentile = [&micros](double p) {
+    return micros[static_cast<std::size_t>(p * (micros.size() - 1))];
+  };
+  double total = 0;
+  for (double value : micros) {
+    total += value;
+  }
+  std::cout << std::setw(12) << name << std::fixed << std::setprecision(1)
+            << std::setw(12) << total / micros.size() << std::setw(12)
+            << percentile(0.5) << std::setw(12) << percentile(0.99)
+            << std::endl;
+}
+
+std::vector<double> measureFuture(outline::OutlineClient& client,
+                                  int requests) {
+  std::vector<double> micros;
+  for (int i = 0; i < requests; ++i) {
+    auto started = Clock::now();
+    client.getServerInformationAsync().get();
+    micros.push_back(std::chrono::duration<double, std::micro>(
+                         Clock::now() - started)
+                         .count());
+  }
+  return micros;
+}
+
+// Runs the measuring coroutine on the calling thread's own io_context, the
+// way a service built on Asio would call the client.
+std::vector<double> measureOnCaller(
+    boost::asio::io_context& caller,
+    const std::function<boost::asio::awaitable<void>()>& request,
+    int requests) {
+  std::vector<double> micros;
+  auto done = boost::asio::co_spawn(
+      caller,
+      [&]() -> boost::asio::awaitable<void> {
+        // Connections are pooled per io_context, so this one needs its own.
+        co_await request();
+        for (int i = 0; i < requests; ++i) {
+          auto started = Clock::now();
+          co_await request();
+          micros.push_back(std::chrono::duration<double, std::micro>(
+                               Clock::now() - started)
+                               .count());
+        }
+      },
+      boost::asio::use_future);
+  caller.restart();
+  caller.run();
+  done.get();
+  return micros;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <apiUrl> [requests]" << std::endl;
+    return 1;
+  }
+  const std::string apiUrl = argv[1];
+  const int requests = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  try {
+    // Pooled connections opened by the coroutine path belong to this
+    // io_context, so it has to outlive the client.
+    boost::asio::io_context caller(1);
+    // Concurrent identical GETs must each be sent, not share one request.
+    outline::OutlineClientOptions options;
+    options.coalescing.enabled = false;
+    auto client = outline::OutlineClient::create(apiUrl, "", 10, options);
+    // Opens the connections and resolves the host for all three runs.
+    measureFuture(*client, 10);
+
+    std::cout << std::setw(12) << "path" << std::setw(12) << "mean us"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+              << std::endl;
+    report("future", measureFuture(*client, requests));
+    report("token",
+           measureOnCaller(
+               caller,
+               [&client]() -> boost::asio::awaitable<void> {
+                 co_await client->getServerInformationAsync(
+                     boost::asio::use_awaitable);
+               },
+               requests));
+    report("coroutine",
+           measureOnCaller(
+               caller,
+               [&client]() -> boost::asio::awaitable<void> {
+                 co_await client->coGetServerInformation();
+               },
+               requests));
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
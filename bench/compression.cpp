@@ -0,0 +1,104 @@
+// Compares the bytes on the wire and the latency of the /access-keys and
+// /metrics/transfer responses with and without gzip, against an in-process
+// MockOutlineServer whose responses are throttled like a slow cross-region
+// link.
+//
+// Usage: bench_compression [keys] [bytesPerSecond] [latencyMs] [requests]
+
+#include "outline/OutlineClient.h"
+#include "outline/metrics/LatencyHistogram.h"
+#include "outline/testing/MockOutlineServer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Sends the request `requests` times on a fresh client and prints
+ *        the body bytes per request as received and as parsed.
+ */
+void measure(const std::string& apiUrl, const std::string& name,
+             bool compression, int requests,
+             const std::function<std::string(outline::OutlineClient&)>& get) {
+  outline::OutlineClientOptions options;
+  options.compression.enabled = compression;
+  auto client = outline::OutlineClient::create(apiUrl, "", 60, options);
+  // Opens the connection, so every measured request reuses it.
+  get(*client);
+  const auto warmup = client->compressionStats();
+
+  outline::metrics::LatencyHistogram latency;
+  std::uint64_t bodyBytes = 0;
+  for (int i = 0; i < requests; ++i) {
+    auto started = Clock::now();
+    bodyBytes += get(*client).size();
+    latency.record(Clock::now() - started);
+  }
+  const auto stats = client->compressionStats();
+  const std::uint64_t wireBytes =
+      compression ? stats.compressedBytes - warmup.compressedBytes
+                  : bodyBytes;
+
+  auto snapshot = latency.snapshot();
+  std::cout << std::setw(10) << name << std::setw(10)
+            << (compression ? "gzip" : "identity") << std::fixed
+            << std::setprecision(1) << std::setw(12)
+            << wireBytes / 1024.0 / requests << std::setw(12)
+            << bodyBytes / 1024.0 / requests << std::setw(12)
+            << snapshot.sumMicros / 1000.0 / snapshot.count << std::setw(12)
+            << snapshot.percentile(0.5).count() / 1000.0 << std::setw(12)
+            << snapshot.percentile(0.99).count() / 1000.0 << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t keys = argc > 1 ? std::atoi(argv[1]) : 5000;
+  const std::size_t bytesPerSecond =
+      argc > 2 ? std::atoi(argv[2]) : 2 * 1024 * 1024;
+  const int latencyMs = argc > 3 ? std::atoi(argv[3]) : 80;
+  const int requests = argc > 4 ? std::atoi(argv[4]) : 20;
+  if (requests <= 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [keys] [bytesPerSecond] [latencyMs] [requests]"
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    outline::testing::MockServerOptions mockOptions;
+    mockOptions.initialKeys = keys;
+    mockOptions.compression = true;
+    mockOptions.bytesPerSecond = bytesPerSecond;
+    mockOptions.latency = std::chrono::milliseconds(latencyMs);
+    outline::testing::MockOutlineServer server(mockOptions);
+
+    std::cout << keys << " keys, " << bytesPerSecond / 1024
+              << " KiB/s, " << latencyMs << " ms latency" << std::endl;
+    std::cout << std::setw(10) << "request" << std::setw(10) << "encoding"
+              << std::setw(12) << "wire KiB" << std::setw(12) << "body KiB"
+              << std::setw(12) << "mean ms" << std::setw(12) << "p50 ms"
+              << std::setw(12) << "p99 ms" << std::endl;
+    for (bool compression : {false, true}) {
+      measure(server.apiUrl(), "list", compression, requests,
+              [](outline::OutlineClient& client) {
+                return client.getAccessKeys();
+              });
+      measure(server.apiUrl(), "metrics", compression, requests,
+              [](outline::OutlineClient& client) {
+                return client.getMetrics();
+              });
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
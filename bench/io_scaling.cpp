@@ -0,0 +1,102 @@
+// Measures how request throughput of a single OutlineClient scales with the
+// number of I/O threads.
+//
+// Usage: bench_io_scaling <apiUrl> [maxThreads] [requests] [concurrency]
+
+#include "outline/OutlineClient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+double run(const std::string& apiUrl,
+           const outline::network::IoRuntimeOptions& runtime, int requests,
+           int concurrency) {
+  outline::OutlineClientOptions options;
+  options.runtime = runtime;
+  // The same GET is sent concurrently; every one has to reach the server.
+  options.coalescing.enabled = false;
+  options.connectionPool.maxIdleConnections =
+      static_cast<std::size_t>(concurrency);
+  auto client = outline::OutlineClient::create(apiUrl, "", 10, options);
+
+  // Warm up the connection pool and the DNS cache.
+  std::deque<std::future<std::string>> inFlight;
+  for (int i = 0; i < concurrency; ++i) {
+    inFlight.push_back(client->getAccessKeysAsync());
+  }
+  while (!inFlight.empty()) {
+    inFlight.front().get();
+    inFlight.pop_front();
+  }
+
+  auto started = std::chrono::steady_clock::now();
+  for (int sent = 0; sent < requests; ++sent) {
+    if (static_cast<int>(inFlight.size()) >= concurrency) {
+      inFlight.front().get();
+      inFlight.pop_front();
+    }
+    inFlight.push_back(client->getAccessKeysAsync());
+  }
+  while (!inFlight.empty()) {
+    inFlight.front().get();
+    inFlight.pop_front();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - started;
+  return requests / elapsed.count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " <apiUrl> [maxThreads] [requests] [concurrency]"
+              << std::endl;
+    return 1;
+  }
+  const std::string apiUrl = argv[1];
+  const std::size_t maxThreads =
+      argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+               : std::max(1u, std::thread::hardware_concurrency());
+  const int requests = argc > 3 ? std::atoi(argv[3]) : 5000;
+  const int concurrency = argc > 4 ? std::atoi(argv[4]) : 64;
+
+  std::cout << std::setw(8) << "threads" << std::setw(16) << "pool req/s"
+            << std::setw(20) << "per-thread req/s" << std::endl;
+  // Powers of two, then maxThreads itself when it is not one of them.
+  std::vector<std::size_t> counts;
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    counts.push_back(threads);
+  }
+  if (!counts.empty() && counts.back() < maxThreads) {
+    counts.push_back(maxThreads);
+  }
+  for (std::size_t threads : counts) {
+    try {
+      double pool =
+          run(apiUrl, {threads, outline::network::IoRuntimeMode::ThreadPool},
+              requests, concurrency);
+      double perThread = run(
+          apiUrl, {threads, outline::network::IoRuntimeMode::ContextPerThread},
+          requests, concurrency);
+      std::cout << std::setw(8) << threads << std::setw(16) << std::fixed
+                << std::setprecision(0) << pool << std::setw(20) << perThread
+                << std::endl;
+    } catch (const std::exception& e) {
+      std::cerr << "Benchmark failed: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,301 @@
+// Drives an OutlineClient with a mix of management requests and reports the
+// throughput and the p50/p99/p999 latency of every request type.
+//
+// Without --url the requests go to an in-process MockOutlineServer, whose
+// latency and error rate can be injected. The mix creates keys, so --url
+// must only point at a test server.
+//
+// Usage: bench_load [--url <apiUrl>] [--rps N | --concurrency N]
+//                   [--duration seconds] [--threads N] [--keys N]
+//                   [--latency-ms N] [--error-rate fraction]
+//                   [--coalescing on|off]
+//
+// --rps sends an open-loop stream at a fixed rate and measures every request
+// from the moment it was due, so a stalled client shows up in the latency.
+// --concurrency keeps N requests in flight back to back (the default, 16).
+// Identical GETs are not coalesced unless --coalescing on is given, so every
+// request of the mix reaches the server.
+
+#include "outline/OutlineClient.h"
+#include "outline/metrics/LatencyHistogram.h"
+#include "outline/testing/MockOutlineServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Settings {
+  std::string apiUrl;
+  double rps = 0;
+  int concurrency = 16;
+  std::chrono::seconds duration{10};
+  std::size_t threads = 2;
+  std::size_t keys = 100;
+  std::chrono::milliseconds latency{0};
+  double errorRate = 0;
+  bool coalescing = false;
+};
+
+/**
+ * @brief One request type of the mix with its results.
+ */
+struct Operation {
+  std::string name;
+  /// Share of the requests, relative to the other operations.
+  int weight = 1;
+  std::function<boost::asio::awaitable<void>(outline::OutlineClient&)> run;
+  outline::metrics::LatencyHistogram latency;
+  std::atomic<std::uint64_t> errors{0};
+};
+
+std::vector<std::unique_ptr<Operation>> makeMix() {
+  std::vector<std::unique_ptr<Operation>> mix;
+  auto add = [&mix](std::string name, int weight, auto run) {
+    auto operation = std::make_unique<Operation>();
+    operation->name = std::move(name);
+    operation->weight = weight;
+    operation->run = std::move(run);
+    mix.push_back(std::move(operation));
+  };
+  add("server", 4,
+      [](outline::OutlineClient& client) -> boost::asio::awaitable<void> {
+        co_await client.coGetServerInformation();
+      });
+  add("metrics", 2,
+      [](outline::OutlineClient& client) -> boost::asio::awaitable<void> {
+        co_await client.coGetMetrics();
+      });
+  add("list", 2,
+      [](outline::OutlineClient& client) -> boost::asio::awaitable<void> {
+        co_await client.coGetAccessKeys();
+      });
+  add("create", 1,
+      [](outline::OutlineClient& client) -> boost::asio::awaitable<void> {
+        outline::CreateAccessKeyParams params;
+        params.name = "load";
+        co_await client.coCreateAccessKey(params);
+      });
+  return mix;
+}
+
+/**
+ * @brief Picks the operations in proportion to their weights.
+ */
+class Schedule {
+ public:
+  explicit Schedule(const std::vector<std::unique_ptr<Operation>>& mix) {
+    for (const auto& operation : mix) {
+      for (int i = 0; i < operation->weight; ++i) {
+        m_slots.push_back(operation.get());
+      }
+    }
+  }
+
+  Operation& next() {
+    return *m_slots[m_next.fetch_add(1, std::memory_order_relaxed) %
+                    m_slots.size()];
+  }
+
+ private:
+  std::vector<Operation*> m_slots;
+  std::atomic<std::size_t> m_next{0};
+};
+
+boost::asio::awaitable<void> measure(outline::OutlineClient& client,
+                                     Operation& operation,
+                                     Clock::time_point started) {
+  try {
+    co_await operation.run(client);
+    operation.latency.record(Clock::now() - started);
+  } catch (const std::exception&) {
+    operation.errors.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Returns once the counter of unfinished requests drops to zero.
+ */
+boost::asio::awaitable<void> waitUntilDone(
+    const std::shared_ptr<std::atomic<std::size_t>>& remaining) {
+  boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor);
+  while (remaining->load(std::memory_order_acquire) > 0) {
+    timer.expires_after(std::chrono::milliseconds(10));
+    co_await timer.async_wait(boost::asio::use_awaitable);
+  }
+}
+
+boost::asio::awaitable<void> runClosedLoop(outline::OutlineClient& client,
+                                           Schedule& schedule,
+                                           Clock::time_point deadline,
+                                           int concurrency) {
+  auto executor = co_await boost::asio::this_coro::executor;
+  auto running = std::make_shared<std::atomic<std::size_t>>(concurrency);
+  auto worker = [&]() -> boost::asio::awaitable<void> {
+    while (Clock::now() < deadline) {
+      co_await measure(client, schedule.next(), Clock::now());
+    }
+  };
+  for (int i = 0; i < concurrency; ++i) {
+    boost::asio::co_spawn(executor, worker, [running](std::exception_ptr) {
+      running->fetch_sub(1, std::memory_order_release);
+    });
+  }
+  co_await waitUntilDone(running);
+}
+
+boost::asio::awaitable<void> runOpenLoop(outline::OutlineClient& client,
+                                         Schedule& schedule,
+                                         Clock::time_point deadline,
+                                         double rps) {
+  auto executor = co_await boost::asio::this_coro::executor;
+  auto inFlight = std::make_shared<std::atomic<std::size_t>>(0);
+  const auto period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / rps));
+  const auto started = Clock::now();
+  boost::asio::steady_timer timer(executor);
+  for (std::uint64_t i = 0;; ++i) {
+    const auto due = started + period * i;
+    if (due >= deadline) {
+      break;
+    }
+    timer.expires_at(due);
+    co_await timer.async_wait(boost::asio::use_awaitable);
+    inFlight->fetch_add(1, std::memory_order_relaxed);
+    boost::asio::co_spawn(
+        executor, measure(client, schedule.next(), due),
+        [inFlight](std::exception_ptr) {
+          inFlight->fetch_sub(1, std::memory_order_release);
+        });
+  }
+  co_await waitUntilDone(inFlight);
+}
+
+void report(const std::vector<std::unique_ptr<Operation>>& mix,
+            std::chrono::duration<double> elapsed) {
+  auto millis = [](std::chrono::microseconds value) {
+    return value.count() / 1000.0;
+  };
+  std::cout << std::setw(10) << "operation" << std::setw(10) << "requests"
+            << std::setw(8) << "errors" << std::setw(10) << "rps"
+            << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms"
+            << std::setw(10) << "p999 ms" << std::endl;
+  std::uint64_t total = 0;
+  std::uint64_t errors = 0;
+  for (const auto& operation : mix) {
+    auto latency = operation->latency.snapshot();
+    const std::uint64_t failed = operation->errors.load();
+    total += latency.count + failed;
+    errors += failed;
+    std::cout << std::setw(10) << operation->name << std::setw(10)
+              << latency.count + failed << std::setw(8) << failed
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << (latency.count + failed) / elapsed.count()
+              << std::setprecision(2) << std::setw(10)
+              << millis(latency.percentile(0.5)) << std::setw(10)
+              << millis(latency.percentile(0.99)) << std::setw(10)
+              << millis(latency.percentile(0.999)) << std::endl;
+  }
+  std::cout << std::setw(10) << "total" << std::setw(10) << total
+            << std::setw(8) << errors << std::setprecision(1)
+            << std::setw(10) << total / elapsed.count() << std::endl;
+}
+
+bool parse(int argc, char** argv, Settings& settings) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const char* value = argv[i + 1];
+    if (flag == "--url") {
+      settings.apiUrl = value;
+    } else if (flag == "--rps") {
+      settings.rps = std::atof(value);
+    } else if (flag == "--concurrency") {
+      settings.concurrency = std::atoi(value);
+    } else if (flag == "--duration") {
+      settings.duration = std::chrono::seconds(std::atoi(value));
+    } else if (flag == "--threads") {
+      settings.threads = static_cast<std::size_t>(std::atoi(value));
+    } else if (flag == "--keys") {
+      settings.keys = static_cast<std::size_t>(std::atoi(value));
+    } else if (flag == "--latency-ms") {
+      settings.latency = std::chrono::milliseconds(std::atoi(value));
+    } else if (flag == "--error-rate") {
+      settings.errorRate = std::atof(value);
+    } else if (flag == "--coalescing") {
+      settings.coalescing = std::string(value) == "on";
+    } else {
+      return false;
+    }
+  }
+  return argc % 2 == 1 && settings.concurrency > 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Settings settings;
+  if (!parse(argc, argv, settings)) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--url <apiUrl>] [--rps N | --concurrency N]"
+                 " [--duration seconds] [--threads N] [--keys N]"
+                 " [--latency-ms N] [--error-rate fraction]"
+                 " [--coalescing on|off]"
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    std::unique_ptr<outline::testing::MockOutlineServer> server;
+    if (settings.apiUrl.empty()) {
+      outline::testing::MockServerOptions mockOptions;
+      mockOptions.threads = settings.threads;
+      mockOptions.initialKeys = settings.keys;
+      mockOptions.latency = settings.latency;
+      mockOptions.errorRate = settings.errorRate;
+      server = std::make_unique<outline::testing::MockOutlineServer>(
+          mockOptions);
+      settings.apiUrl = server->apiUrl();
+    }
+
+    outline::OutlineClientOptions options;
+    options.runtime.threads = settings.threads;
+    options.connectionPool.maxIdleConnections =
+        static_cast<std::size_t>(std::max(settings.concurrency, 64));
+    options.coalescing.enabled = settings.coalescing;
+    auto client =
+        outline::OutlineClient::create(settings.apiUrl, "", 10, options);
+
+    auto mix = makeMix();
+    Schedule schedule(mix);
+    const auto started = Clock::now();
+    const auto deadline = started + settings.duration;
+    auto run = settings.rps > 0
+                   ? runOpenLoop(*client, schedule, deadline, settings.rps)
+                   : runClosedLoop(*client, schedule, deadline,
+                                   settings.concurrency);
+    boost::asio::co_spawn(client->executor(), std::move(run),
+                          boost::asio::use_future)
+        .get();
+    report(mix, Clock::now() - started);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
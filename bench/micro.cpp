@@ -0,0 +1,214 @@
+// CPU-only microbenchmarks of the request hot paths: URL building, request
+// body serialization and response parsing. No network is involved.
+//
+// Every benchmark reports allocs/op, the global operator new calls per
+// iteration, so allocation regressions show up next to time regressions.
+//
+// Usage: bench_micro [--benchmark_filter=<regex>]
+
+#include "outline/OutlineClient.h"
+#include "outline/constants/ApiEndpoint.h"
+#include "outline/models/AccessKey.h"
+#include "outline/models/TransferMetrics.h"
+#include "outline/utils/JsonUtils.h"
+#include "outline/utils/JsonWriter.h"
+#include "outline/utils/RequestArena.h"
+#include "outline/utils/RequestBody.h"
+#include "outline/utils/UrlUtils.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/span_body.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/json.hpp>
+
+namespace {
+
+std::atomic<std::uint64_t> g_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+namespace http = boost::beast::http;
+
+/**
+ * @brief Reports the allocations made between construction and destruction
+ *        as allocs/op.
+ */
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State& state)
+      : m_state(state),
+        m_start(g_allocations.load(std::memory_order_relaxed)) {}
+  ~AllocationCounter() {
+    m_state.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(g_allocations.load(std::memory_order_relaxed) -
+                            m_start),
+        benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  benchmark::State& m_state;
+  std::uint64_t m_start;
+};
+
+std::string accessKeysPayload(std::int64_t keys) {
+  std::string body = R"({"accessKeys":[)";
+  for (std::int64_t i = 0; i < keys; ++i) {
+    const std::string id = std::to_string(i);
+    if (i != 0) {
+      body += ',';
+    }
+    body += R"({"id":")" + id + R"(","name":"user-)" + id +
+            R"(","password":"Xk3vQ9pL2mN8rT5w","port":48213,)"
+            R"("method":"chacha20-ietf-poly1305",)";
+    if (i % 2 == 0) {
+      body += R"("dataLimit":{"bytes":10000000000},)";
+    }
+    body += R"("accessUrl":"ss://Y2hhY2hhMjAtaWV0Zi1wb2x5MTMwNTpYazN2)"
+            R"(UTlwTDJtTjhyVDV3@203.0.113.7:48213/?outline=1"})";
+  }
+  body += "]}";
+  return body;
+}
+
+std::string transferMetricsPayload(std::int64_t keys) {
+  std::string body = R"({"bytesTransferredByUserId":{)";
+  for (std::int64_t i = 0; i < keys; ++i) {
+    if (i != 0) {
+      body += ',';
+    }
+    body += '"' + std::to_string(i) + R"(":)" +
+            std::to_string(1000003 * (i + 1));
+  }
+  body += "}}";
+  return body;
+}
+
+void BM_BuildTarget(benchmark::State& state) {
+  const std::string basePath = "/Wz3kQ8pR2mN";
+  const std::string accessKeyId = "12345";
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        outline::utils::buildTarget<outline::api::Endpoints::AddDataLimit,
+                                    outline::api::UrlParams::KeyId>(
+            basePath, {accessKeyId}));
+  }
+}
+BENCHMARK(BM_BuildTarget);
+
+template <typename Params>
+void serializeParams(benchmark::State& state) {
+  outline::utils::ArenaPool arenas({});
+  Params params;
+  params.name = "user-12345";
+  params.password = "Xk3vQ9pL2mN8rT5w";
+  params.method = "chacha20-ietf-poly1305";
+  params.data_limit_bytes = 1000000000;
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    // Acquired per request, as the client does.
+    auto arena = arenas.acquire();
+    benchmark::DoNotOptimize(
+        outline::utils::serializeAccessKeyParams(params, *arena).data());
+  }
+}
+
+void BM_SerializeCreateAccessKeyParams(benchmark::State& state) {
+  serializeParams<outline::CreateAccessKeyParams>(state);
+}
+BENCHMARK(BM_SerializeCreateAccessKeyParams);
+
+void BM_SerializeUpdateAccessKeyParams(benchmark::State& state) {
+  serializeParams<outline::UpdateAccessKeyParams>(state);
+}
+BENCHMARK(BM_SerializeUpdateAccessKeyParams);
+
+// The body of a rename as it was built before JsonWriter: a JSON object in
+// the arena, serialized and then copied into a string_body request.
+void BM_RenameBodyJsonValue(benchmark::State& state) {
+  outline::utils::ArenaPool arenas({});
+  const std::string name = "user \"12345\"";
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    auto arena = arenas.acquire();
+    boost::json::object obj({{"name", name}}, arena->storage());
+    http::request<http::string_body> req{http::verb::put, "/", 11};
+    req.body() = arena->serialize(obj);
+    req.prepare_payload();
+    benchmark::DoNotOptimize(req.body().data());
+  }
+}
+BENCHMARK(BM_RenameBodyJsonValue);
+
+// The same body written by JsonWriter into the arena and sent from there.
+void BM_RenameBodyJsonWriter(benchmark::State& state) {
+  outline::utils::ArenaPool arenas({});
+  const std::string name = "user \"12345\"";
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    auto arena = arenas.acquire();
+    outline::utils::JsonWriter body = arena->writeBody();
+    body.beginObject().field("name", name).endObject();
+    http::request<http::span_body<const char>> req{http::verb::put, "/", 11};
+    req.body() =
+        boost::beast::span<const char>(body.str().data(), body.str().size());
+    req.prepare_payload();
+    benchmark::DoNotOptimize(req.body().data());
+  }
+}
+BENCHMARK(BM_RenameBodyJsonWriter);
+
+void BM_ParseAccessKeys(benchmark::State& state) {
+  const std::string body = accessKeysPayload(state.range(0));
+  outline::utils::ArenaPool arenas({});
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    auto arena = arenas.acquire();
+    benchmark::DoNotOptimize(outline::accessKeysFromJson(
+        outline::utils::parseJson(body, "access keys", arena->storage())));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(body.size()));
+}
+BENCHMARK(BM_ParseAccessKeys)->Arg(10)->Arg(1000)->Arg(100000);
+
+void BM_ParseTransferMetrics(benchmark::State& state) {
+  const std::string body = transferMetricsPayload(state.range(0));
+  outline::utils::ArenaPool arenas({});
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    auto arena = arenas.acquire();
+    benchmark::DoNotOptimize(
+        outline::utils::parseJsonAs<outline::TransferMetrics>(
+            body, "metrics", arena->storage()));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(body.size()));
+}
+BENCHMARK(BM_ParseTransferMetrics)->Arg(10)->Arg(1000)->Arg(100000);
+
+}  // namespace
+
+BENCHMARK_MAIN();
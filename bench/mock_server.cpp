@@ -0,0 +1,43 @@
+// Serves the Outline management API from memory until interrupted, for
+// trying out clients and load tests without a real server.
+//
+// Usage: mock_server [port] [keys] [latencyMs] [errorRate]
+
+#include "outline/testing/MockOutlineServer.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
+
+int main(int argc, char** argv) {
+  outline::testing::MockServerOptions options;
+  options.port = argc > 1 ? static_cast<unsigned short>(std::atoi(argv[1]))
+                          : 0;
+  options.initialKeys = argc > 2 ? std::atoi(argv[2]) : 10;
+  options.latency = std::chrono::milliseconds(argc > 3 ? std::atoi(argv[3])
+                                                       : 0);
+  options.errorRate = argc > 4 ? std::atof(argv[4]) : 0;
+
+  try {
+    outline::testing::MockOutlineServer server(options);
+    std::cout << server.apiUrl() << std::endl;
+
+    boost::asio::io_context context;
+    boost::asio::signal_set signals(context, SIGINT, SIGTERM);
+    signals.async_wait([](const boost::system::error_code&, int) {});
+    context.run();
+
+    auto stats = server.stats();
+    std::cout << stats.requests << " requests, " << stats.injectedErrors
+              << " injected errors, " << stats.droppedConnections
+              << " dropped" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
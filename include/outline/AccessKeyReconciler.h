@@ -0,0 +1,117 @@
+#ifndef OUTLINE_ACCESS_KEY_RECONCILER_H
+#define OUTLINE_ACCESS_KEY_RECONCILER_H
+
+#include <cstddef>
+#include <future>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/asio/awaitable.hpp>
+
+#include "outline/OutlineClient.h"
+
+namespace outline {
+
+/**
+ * @brief An access key as it should exist on the server.
+ */
+struct DesiredAccessKey {
+  /// Matches the key by id, which allows renaming it, and creates a missing
+  /// key under this id. Keys without an id are matched by name. A second
+  /// desired key with the same id is ignored.
+  std::optional<std::string> id;
+  std::string name;
+  /// No data limit if not set.
+  std::optional<int> dataLimitBytes;
+};
+
+/**
+ * @brief Settings of AccessKeyReconciler.
+ */
+struct ReconcileOptions {
+  /// Deletes the keys of the server which match no desired key.
+  bool deleteUnlisted = true;
+  /// Number of requests in flight while the plan is applied.
+  std::size_t concurrency = 16;
+};
+
+/**
+ * @brief The calls which bring the server to the desired state.
+ */
+struct ReconcilePlan {
+  std::vector<AccessKeyOperation> operations;
+  /// Desired keys which already match the server.
+  std::size_t unchanged = 0;
+
+  bool empty() const { return operations.empty(); }
+  /**
+   * @brief Returns one line per call, e.g. for a dry run.
+   */
+  std::string describe() const;
+};
+
+/**
+ * @brief Outcome of an applied plan.
+ */
+struct ReconcileResult {
+  ReconcilePlan plan;
+  /// One result per operation of the plan, in plan order.
+  std::vector<AccessKeyOperationResult> results;
+};
+
+/**
+ * @brief Diffs the current keys of a server against the desired ones.
+ *
+ * Both sides are indexed by hash, so the plan takes linear time. A desired
+ * key matches at most one current key and vice versa; duplicate names are
+ * matched pairwise.
+ */
+ReconcilePlan planReconcile(const std::vector<AccessKey>& current,
+                            const std::vector<DesiredAccessKey>& desired,
+                            const ReconcileOptions& options = {});
+
+/**
+ * @brief Applies a desired set of access keys with the fewest calls.
+ *
+ * The current keys are read with a single request, bypassing the access
+ * key cache, so a run which changes
+ * nothing costs one round trip however many keys there are:
+ * @code
+ * AccessKeyReconciler reconciler(*client);
+ * std::cout << reconciler.plan(users).describe();  // dry run
+ * auto result = reconciler.apply(users);
+ * @endcode
+ */
+class AccessKeyReconciler {
+ public:
+  /**
+   * @param client - must outlive the reconciler.
+   */
+  explicit AccessKeyReconciler(OutlineClient& client,
+                               const ReconcileOptions& options = {});
+
+  boost::asio::awaitable<ReconcilePlan> coPlan(
+      std::vector<DesiredAccessKey> desired);
+  /**
+   * @brief Plans and runs the calls through the bulk API. A failed call
+   *        does not stop the others.
+   */
+  boost::asio::awaitable<ReconcileResult> coApply(
+      std::vector<DesiredAccessKey> desired);
+
+  std::future<ReconcilePlan> planAsync(std::vector<DesiredAccessKey> desired);
+  std::future<ReconcileResult> applyAsync(
+      std::vector<DesiredAccessKey> desired);
+
+  ReconcilePlan plan(std::vector<DesiredAccessKey> desired);
+  ReconcileResult apply(std::vector<DesiredAccessKey> desired);
+
+ private:
+  OutlineClient& m_client;
+  ReconcileOptions m_options;
+};
+
+}  // namespace outline
+
+#endif  // OUTLINE_ACCESS_KEY_RECONCILER_H
@@ -1,17 +1,48 @@
 #ifndef OUTLINECLIENT_H
 #define OUTLINECLIENT_H
 
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <future>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
 #include <boost/asio/ssl.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/span_body.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/beast/http/verb.hpp>
 #include <boost/url.hpp>
 
+#include "outline/OutlineClientOptions.h"
+#include "outline/cache/AccessKeyCache.h"
+#include "outline/constants/ApiEndpoint.h"
+#include "outline/exceptions/OutlineExceptions.h"
+#include "outline/models/AccessKey.h"
+#include "outline/models/AccessKeyStreamParser.h"
+#include "outline/models/ServerInformation.h"
+#include "outline/metrics/ClientStats.h"
+#include "outline/metrics/RequestMetrics.h"
+#include "outline/models/TransferMetrics.h"
+#include "outline/network/CircuitBreaker.h"
+#include "outline/network/ConnectionPool.h"
+#include "outline/network/IoRuntime.h"
+#include "outline/network/HappyEyeballs.h"
+#include "outline/network/ResolverCache.h"
+#include "outline/network/RetryPolicy.h"
+#include "outline/network/TlsSessionCache.h"
+#include "outline/utils/RequestArena.h"
+#include "outline/utils/UrlUtils.h"
+
 namespace outline {
 
 struct CreateAccessKeyParams {
@@ -28,6 +59,50 @@ struct UpdateAccessKeyParams {
   std::optional<int> data_limit_bytes;
 };
 
+enum class AccessKeyOperationType {
+  Create,
+  Rename,
+  AddDataLimit,
+  DeleteDataLimit,
+  Delete,
+};
+
+/**
+ * @brief A single access key mutation of a bulk request.
+ */
+struct AccessKeyOperation {
+  AccessKeyOperationType type = AccessKeyOperationType::Create;
+  /// The key to change. For Create, the id to create the key under with
+  /// PUT /access-keys/{id}; the server picks one if empty.
+  std::string accessKeyId;
+  /// Used by Create.
+  CreateAccessKeyParams params;
+  /// Used by Rename.
+  std::string name;
+  /// Used by AddDataLimit.
+  int dataLimitBytes = 0;
+
+  static AccessKeyOperation create(CreateAccessKeyParams params);
+  static AccessKeyOperation rename(std::string accessKeyId, std::string name);
+  static AccessKeyOperation addDataLimit(std::string accessKeyId,
+                                         int dataLimitBytes);
+  static AccessKeyOperation deleteDataLimit(std::string accessKeyId);
+  static AccessKeyOperation remove(std::string accessKeyId);
+};
+
+/**
+ * @brief Outcome of one operation of a bulk request.
+ */
+struct AccessKeyOperationResult {
+  bool success = false;
+  /// HTTP status of a rejected operation, 0 if the server was not reached.
+  int status = 0;
+  /// The created key of a successful Create.
+  std::optional<AccessKey> accessKey;
+  /// Why the operation failed.
+  std::exception_ptr error;
+};
+
 /**
  * @brief Класс OutlineClient отвечает за подключение к Outline-серверу.
  */
@@ -36,24 +111,28 @@ class OutlineClient : public std::enable_shared_from_this<OutlineClient> {
   /**
      * apiUrl - url for server API
      * cert - certificate after apiUrl
-     * timeout - request timeout
+     * timeout - deadline in seconds of each phase of a request: resolve,
+     *           connect, TLS handshake, write and read. 0 disables it.
+     *           An exceeded deadline raises OutlineTimeoutException.
+     * options - connection pool and other optional settings
      */
   OutlineClient(std::string_view apiUrl, std::string_view cert,
-                int timeout = 5);
+                int timeout = 5, const OutlineClientOptions& options = {});
 
   /**
-     * @brief Destructor. Stops the io_context and joins the io_thread.
+     * @brief Destructor. Stops the io_contexts and joins the I/O threads
+     *        unless they belong to a shared runtime.
      */
   ~OutlineClient();
 
   /**
     * @brief Creates a shared_ptr for handling the lifetime issues
    */
-  static std::shared_ptr<OutlineClient> create(std::string_view apiUrl,
-                                               std::string_view cert,
-                                               int timeout = 5) {
+  static std::shared_ptr<OutlineClient> create(
+      std::string_view apiUrl, std::string_view cert, int timeout = 5,
+      const OutlineClientOptions& options = {}) {
     return std::shared_ptr<OutlineClient>(
-        new OutlineClient(apiUrl, cert, timeout));
+        new OutlineClient(apiUrl, cert, timeout, options));
   }
 
   /**
@@ -149,6 +228,242 @@ class OutlineClient : public std::enable_shared_from_this<OutlineClient> {
      */
   std::future<void> deleteDataLimitForAllAccessKeysAsync();
 
+  /**
+   * @brief Typed counterparts of the methods above. The response is converted
+   *        into the model directly instead of being returned as JSON text.
+   */
+  std::future<std::vector<AccessKey>> getAccessKeysTypedAsync();
+  std::future<AccessKey> getAccessKeyTypedAsync(const std::string& accessKeyId);
+  std::future<AccessKey> createAccessKeyTypedAsync(
+      const CreateAccessKeyParams& params);
+  std::future<AccessKey> updateAccessKeyTypedAsync(
+      const std::string& accessKeyId, const UpdateAccessKeyParams& params);
+  /**
+   * @brief Streams the access keys without buffering the whole response.
+   * @param onAccessKey - called on the I/O thread for every parsed key.
+   * @return the number of access keys.
+   */
+  std::future<std::size_t> getAccessKeysStreamAsync(
+      AccessKeyStreamParser::Callback onAccessKey);
+  std::future<TransferMetrics> getMetricsTypedAsync();
+  std::future<ServerInformation> getServerInformationTypedAsync();
+  /**
+   * @brief Applies the operations with at most `concurrency` requests in
+   *        flight. A failed operation does not stop the others.
+   * @param operations - the mutations, e.g. AccessKeyOperation::create(...).
+   * @param concurrency - the maximum number of parallel requests.
+   * @return one result per operation, in the same order.
+   */
+  std::future<std::vector<AccessKeyOperationResult>>
+  applyAccessKeyOperationsAsync(std::vector<AccessKeyOperation> operations,
+                                std::size_t concurrency = 16);
+
+  /**
+   * @brief Coroutine counterparts of the *Async methods.
+   *
+   * The request runs on the executor of the awaiting coroutine, without a
+   * std::future or a switch to the client's I/O threads:
+   * @code
+   * std::string key = co_await client->coGetAccessKey("1");
+   * @endcode
+   * The client must outlive the returned awaitable. Connections opened on
+   * the caller's executor are pooled for later requests on it, so its
+   * execution context must outlive the client.
+   */
+  boost::asio::awaitable<std::string> coGetAccessKeys();
+  boost::asio::awaitable<std::string> coGetAccessKey(std::string accessKeyId);
+  boost::asio::awaitable<std::string> coCreateAccessKey(
+      CreateAccessKeyParams params);
+  boost::asio::awaitable<std::string> coUpdateAccessKey(
+      std::string accessKeyId, UpdateAccessKeyParams params);
+  boost::asio::awaitable<void> coDeleteAccessKey(std::string accessKeyId);
+  boost::asio::awaitable<void> coRenameAccessKey(
+      std::string accessKeyId, std::string newName);
+  boost::asio::awaitable<void> coAddDataLimit(
+      std::string accessKeyId, int dataLimitBytes);
+  boost::asio::awaitable<void> coDeleteDataLimit(std::string accessKeyId);
+  boost::asio::awaitable<std::string> coGetMetrics();
+  boost::asio::awaitable<std::string> coGetServerInformation();
+  boost::asio::awaitable<void> coSetServerName(std::string serverName);
+  boost::asio::awaitable<void> coSetHostName(std::string hostName);
+  boost::asio::awaitable<bool> coGetMetricsStatus();
+  boost::asio::awaitable<void> coSetMetricsStatus(bool status);
+  boost::asio::awaitable<void> coSetDefaultPort(int port);
+  boost::asio::awaitable<void> coSetDataLimitForAllAccessKeys(
+      int dataLimitBytes);
+  boost::asio::awaitable<void> coDeleteDataLimitForAllAccessKeys();
+  boost::asio::awaitable<std::vector<AccessKey>> coGetAccessKeysTyped();
+  /**
+   * @brief Reads the keys from the server even if the access key cache
+   *        holds them, e.g. to diff against the current state. The answer
+   *        replaces the cached list.
+   */
+  boost::asio::awaitable<std::vector<AccessKey>>
+  coGetAccessKeysTypedUncached();
+  boost::asio::awaitable<AccessKey> coGetAccessKeyTyped(
+      std::string accessKeyId);
+  boost::asio::awaitable<AccessKey> coCreateAccessKeyTyped(
+      CreateAccessKeyParams params);
+  boost::asio::awaitable<AccessKey> coUpdateAccessKeyTyped(
+      std::string accessKeyId, UpdateAccessKeyParams params);
+  boost::asio::awaitable<std::size_t> coGetAccessKeysStream(
+      AccessKeyStreamParser::Callback onAccessKey);
+  boost::asio::awaitable<TransferMetrics> coGetMetricsTyped();
+  boost::asio::awaitable<ServerInformation> coGetServerInformationTyped();
+  boost::asio::awaitable<std::vector<AccessKeyOperationResult>>
+  coApplyAccessKeyOperations(std::vector<AccessKeyOperation> operations,
+                             std::size_t concurrency = 16);
+
+  /**
+   * @brief Completion token overloads of the *Async methods.
+   *
+   * The request is started on one of the client's I/O threads and completes
+   * with (std::exception_ptr, result), so any Asio completion token works:
+   * a callback, boost::asio::use_awaitable, boost::asio::deferred or
+   * boost::asio::use_future, which the overloads above use.
+   */
+  template <typename CompletionToken>
+  auto getAccessKeysAsync(CompletionToken&& token) {
+    return spawn(coGetAccessKeys(), std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getAccessKeyAsync(
+      const std::string& accessKeyId, CompletionToken&& token) {
+    return spawn(coGetAccessKey(accessKeyId),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto createAccessKeyAsync(
+      const CreateAccessKeyParams& params, CompletionToken&& token) {
+    return spawn(coCreateAccessKey(params),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto updateAccessKeyAsync(
+      const std::string& accessKeyId,
+      const UpdateAccessKeyParams& params,
+      CompletionToken&& token) {
+    return spawn(coUpdateAccessKey(accessKeyId, params),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto deleteAccessKeyAsync(
+      const std::string& accessKeyId, CompletionToken&& token) {
+    return spawn(coDeleteAccessKey(accessKeyId),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto renameAccessKeyAsync(
+      const std::string& accessKeyId,
+      const std::string& newName,
+      CompletionToken&& token) {
+    return spawn(coRenameAccessKey(accessKeyId, newName),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto addDataLimitAsync(
+      const std::string& accessKeyId,
+      int dataLimitBytes,
+      CompletionToken&& token) {
+    return spawn(coAddDataLimit(accessKeyId, dataLimitBytes),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto deleteDataLimitAsync(
+      const std::string& accessKeyId, CompletionToken&& token) {
+    return spawn(coDeleteDataLimit(accessKeyId),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getMetricsAsync(CompletionToken&& token) {
+    return spawn(coGetMetrics(), std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getServerInformationAsync(CompletionToken&& token) {
+    return spawn(coGetServerInformation(),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto setServerNameAsync(
+      const std::string& serverName, CompletionToken&& token) {
+    return spawn(coSetServerName(serverName),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto setHostNameAsync(const std::string& hostName, CompletionToken&& token) {
+    return spawn(coSetHostName(hostName), std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getMetricsStatusAsync(CompletionToken&& token) {
+    return spawn(coGetMetricsStatus(), std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto setMetricsStatusAsync(bool status, CompletionToken&& token) {
+    return spawn(coSetMetricsStatus(status),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto setDefaultPortAsync(int port, CompletionToken&& token) {
+    return spawn(coSetDefaultPort(port), std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto setDataLimitForAllAccessKeysAsync(
+      int dataLimitBytes, CompletionToken&& token) {
+    return spawn(coSetDataLimitForAllAccessKeys(dataLimitBytes),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto deleteDataLimitForAllAccessKeysAsync(CompletionToken&& token) {
+    return spawn(coDeleteDataLimitForAllAccessKeys(),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getAccessKeysTypedAsync(CompletionToken&& token) {
+    return spawn(coGetAccessKeysTyped(), std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getAccessKeyTypedAsync(
+      const std::string& accessKeyId, CompletionToken&& token) {
+    return spawn(coGetAccessKeyTyped(accessKeyId),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto createAccessKeyTypedAsync(
+      const CreateAccessKeyParams& params, CompletionToken&& token) {
+    return spawn(coCreateAccessKeyTyped(params),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto updateAccessKeyTypedAsync(
+      const std::string& accessKeyId,
+      const UpdateAccessKeyParams& params,
+      CompletionToken&& token) {
+    return spawn(coUpdateAccessKeyTyped(accessKeyId, params),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getAccessKeysStreamAsync(
+      AccessKeyStreamParser::Callback onAccessKey, CompletionToken&& token) {
+    return spawn(coGetAccessKeysStream(std::move(onAccessKey)),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getMetricsTypedAsync(CompletionToken&& token) {
+    return spawn(coGetMetricsTyped(), std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto getServerInformationTypedAsync(CompletionToken&& token) {
+    return spawn(coGetServerInformationTyped(),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename CompletionToken>
+  auto applyAccessKeyOperationsAsync(std::vector<AccessKeyOperation> operations,
+                                     std::size_t concurrency,
+                                     CompletionToken&& token) {
+    return spawn(coApplyAccessKeyOperations(std::move(operations), concurrency),
+                 std::forward<CompletionToken>(token));
+  }
+
   std::string getAccessKeys();
   std::string getAccessKey(const std::string& accessKeyId);
   std::string createAccessKey(const CreateAccessKeyParams& params);
@@ -169,25 +484,255 @@ class OutlineClient : public std::enable_shared_from_this<OutlineClient> {
   void setDataLimitForAllAccessKeys(int dataLimitBytes);
   void deleteDataLimitForAllAccessKeys();
 
+  std::vector<AccessKey> getAccessKeysTyped();
+  AccessKey getAccessKeyTyped(const std::string& accessKeyId);
+  std::size_t getAccessKeysStream(AccessKeyStreamParser::Callback onAccessKey);
+  AccessKey createAccessKeyTyped(const CreateAccessKeyParams& params);
+  AccessKey updateAccessKeyTyped(const std::string& accessKeyId,
+                                 const UpdateAccessKeyParams& params);
+  TransferMetrics getMetricsTyped();
+  ServerInformation getServerInformationTyped();
+  std::vector<AccessKeyOperationResult> applyAccessKeyOperations(
+      std::vector<AccessKeyOperation> operations, std::size_t concurrency = 16);
+
+  /**
+   * @brief Bounds a single call by its own deadline, e.g. a short budget for
+   *        a health check. The per-phase deadlines of the client still apply.
+   *
+   * On expiry the operation is cancelled, its connection is closed and
+   * OutlineTimeoutException is raised. A GET which shares a request with
+   * other calls only stops waiting; the shared request keeps its connection
+   * until it completes or a per-phase deadline expires, so the other callers
+   * still get the response:
+   * @code
+   * auto keys = client->withTimeoutAsync(client->coGetAccessKeys(),
+   *                                      std::chrono::milliseconds(500)).get();
+   * @endcode
+   */
+  template <typename T>
+  boost::asio::awaitable<T> coWithTimeout(boost::asio::awaitable<T> operation,
+                                          std::chrono::milliseconds timeout) {
+    using namespace boost::asio::experimental::awaitable_operators;
+    boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor,
+                                    timeout);
+    auto result = co_await (std::move(operation) ||
+                            timer.async_wait(boost::asio::use_awaitable));
+    if (result.index() == 1) {
+      throw OutlineTimeoutException("call did not complete within " +
+                                    std::to_string(timeout.count()) + " ms");
+    }
+    if constexpr (!std::is_void_v<T>) {
+      co_return std::get<0>(std::move(result));
+    }
+  }
+  template <typename T, typename CompletionToken>
+  auto withTimeoutAsync(boost::asio::awaitable<T> operation,
+                        std::chrono::milliseconds timeout,
+                        CompletionToken&& token) {
+    return spawn(coWithTimeout(std::move(operation), timeout),
+                 std::forward<CompletionToken>(token));
+  }
+  template <typename T>
+  std::future<T> withTimeoutAsync(boost::asio::awaitable<T> operation,
+                                  std::chrono::milliseconds timeout) {
+    return withTimeoutAsync(std::move(operation), timeout,
+                            boost::asio::use_future);
+  }
+
+  /**
+   * @brief Returns the hit/miss counters of the keep-alive connection pool.
+   */
+  network::ConnectionPoolStats connectionPoolStats() const;
+  /**
+   * @brief Returns the number and duration of full and resumed handshakes.
+   */
+  network::TlsHandshakeStats tlsHandshakeStats() const;
+  /**
+   * @brief Returns the counters of the DNS resolution cache.
+   */
+  network::ResolverCacheStats resolverCacheStats() const;
+  /**
+   * @brief Returns how connections were raced across the server's addresses
+   *        and how often the first address lost.
+   */
+  network::HappyEyeballsStats happyEyeballsStats() const;
+  /**
+   * @brief Returns how many responses arrived compressed and how many bytes
+   *        compression saved on the wire.
+   */
+  network::CompressionStats compressionStats() const;
+  /**
+   * @brief Returns how many request arenas were leased and how often they
+   *        ran out of memory.
+   */
+  utils::ArenaStats arenaStats() const;
+  /**
+   * @brief Returns how often requests were retried or gave up.
+   */
+  network::RetryStats retryStats() const;
+  /**
+   * @brief Returns the circuit breaker state of the server.
+   */
+  network::CircuitBreakerStats circuitBreakerStats() const;
+  /**
+   * @brief Returns how many requests waited for the rate limiter, and for
+   *        how long.
+   */
+  network::RateLimiterStats rateLimiterStats() const;
+  /**
+   * @brief Returns how many GETs were sent and how many shared a request
+   *        which was already in flight.
+   */
+  network::CoalescingStats coalescingStats() const;
+  /**
+   * @brief Returns the hit/miss counters of the access key cache.
+   */
+  cache::AccessKeyCacheStats accessKeyCacheStats() const;
+  /**
+   * @brief Returns a snapshot of every counter of the client, including the
+   *        latency histogram of each endpoint. Safe to call from any
+   *        thread while requests are running.
+   */
+  metrics::ClientStats stats() const;
+  /**
+   * @brief Returns stats() in the Prometheus text exposition format.
+   */
+  std::string prometheusMetrics() const;
+  /**
+   * @brief Drops every cached access key, e.g. after the keys were changed
+   *        by another client.
+   */
+  void clearAccessKeyCache();
+  /**
+   * @brief Resolves the API host again and replaces the cached addresses,
+   *        e.g. after the server moved to another address.
+   */
+  std::future<void> refreshResolution();
+  /**
+   * @brief Closes the idle keep-alive connections.
+   */
+  void closeIdleConnections();
+  /**
+   * @brief Returns an executor of the client's I/O threads, e.g. to
+   *        co_spawn a coroutine which awaits several co* methods.
+   */
+  boost::asio::any_io_executor executor() { return m_runtime->nextExecutor(); }
+
  private:
+  /**
+   * @brief Returns the deadline of each phase of a request.
+   */
+  std::chrono::milliseconds requestTimeout() const;
+  /**
+   * @brief Runs one operation of a bulk request and captures its outcome.
+   */
+  boost::asio::awaitable<AccessKeyOperationResult> coApplyAccessKeyOperation(
+      AccessKeyOperation operation);
+  template <typename T, typename CompletionToken>
+  auto spawn(boost::asio::awaitable<T> operation, CompletionToken&& token) {
+    return boost::asio::co_spawn(m_runtime->nextExecutor(),
+                                 std::move(operation),
+                                 std::forward<CompletionToken>(token));
+  }
+
   boost::urls::url m_apiUrl;
+  /// Path of m_apiUrl without a trailing '/', the prefix of every target.
+  std::string m_basePath;
   std::string m_cert;
   int m_timeout;
 
+  network::TlsSessionCache m_tlsSessionCache;
   boost::asio::ssl::context m_sslContext;
-  boost::asio::io_context m_ioContext;
-  boost::asio::executor_work_guard<boost::asio::io_context::executor_type>
-      m_workGuard;
-  std::thread m_ioThread;
+  utils::ArenaPool m_arenas;
+  std::shared_ptr<network::IoRuntime> m_runtime;
+  bool m_ownsRuntime;
+  network::ConnectionPool m_connectionPool;
+  network::ResolverCache m_resolverCache;
+  network::HappyEyeballs m_happyEyeballs;
+  network::ResponseCompression m_compression;
+  network::RetryPolicy m_retryPolicy;
+  network::CircuitBreaker m_circuitBreaker;
+  network::RateLimiter m_rateLimiter;
+  network::RequestCoalescer m_coalescer;
+  cache::AccessKeyCache m_accessKeyCache;
+  metrics::RequestMetrics m_requestMetrics;
+
+  /**
+   * @brief Returns the request target of a route without placeholders.
+   */
+  template <const api::Route& route>
+  std::string routeTarget() const {
+    return utils::buildTarget<route>(m_basePath);
+  }
+  /**
+   * @brief Returns the request target of a route of one access key, such as
+   *        "/access-keys/{key_id}/name".
+   */
+  template <const api::Route& route>
+  std::string keyTarget(std::string_view accessKeyId) const {
+    return utils::buildTarget<route, api::UrlParams::KeyId>(m_basePath,
+                                                            {accessKeyId});
+  }
 
+  /// The body refers to the caller's arena, which outlives the request, so
+  /// it is sent without being copied.
+  using Request = boost::beast::http::request<
+      boost::beast::http::span_body<const char>>;
+
+  boost::asio::awaitable<std::unique_ptr<network::PooledConnection>>
+  connectAsync();
+  Request makeRequest(boost::beast::http::verb verb, const std::string& target,
+                      const std::string& body);
+  boost::asio::awaitable<void> releaseConnectionAsync(
+      std::unique_ptr<network::PooledConnection> connection, bool keepAlive);
+  /**
+   * @brief Sends the request once, replacing a stale pooled connection.
+   */
+  boost::asio::awaitable<std::pair<int, std::string>> doAttemptAsync(
+      const Request& req);
+  /**
+   * @brief Sends the request through the circuit breaker and retries
+   *        failed idempotent requests with backoff.
+   */
+  boost::asio::awaitable<std::pair<int, std::string>> doRequestAsync(
+      api::EndpointId endpoint, boost::beast::http::verb verb,
+      const std::string& target, const std::string& body);
+  /**
+   * @brief Sends a GET request and passes the body of a 2xx response to
+   *        onChunk piece by piece as it is read from the socket.
+   * @return the status code.
+   */
+  boost::asio::awaitable<int> doGetStreamAsync(
+      api::EndpointId endpoint, const std::string& target,
+      const std::function<void(std::string_view)>& onChunk);
+  boost::asio::awaitable<int> doGetStreamAttemptAsync(
+      const std::string& target,
+      const std::function<void(std::string_view)>& onChunk);
+  /**
+   * @brief Sends a GET request, or shares the response of an identical one
+   *        which is already in flight.
+   */
   boost::asio::awaitable<std::pair<int, std::string>> doGetAsync(
-      const boost::urls::url& url);
+      api::EndpointId endpoint, const std::string& target);
+  /**
+   * @brief Serves a GET of the key, or of the list for
+   *        AccessKeyCache::kAllKeys, from the access key cache and fetches
+   *        it on a miss.
+   * @param refresh - fetches it even on a hit and caches the answer.
+   */
+  boost::asio::awaitable<std::pair<int, std::string>> doCachedGetAsync(
+      api::EndpointId endpoint, const std::string& target,
+      const std::string& accessKeyId, bool refresh = false);
+  boost::asio::awaitable<std::vector<AccessKey>> coReadAccessKeysTyped(
+      bool refresh);
   boost::asio::awaitable<std::pair<int, std::string>> doPostAsync(
-      const boost::urls::url& url, const std::string& body);
+      api::EndpointId endpoint, const std::string& target,
+      const std::string& body);
   boost::asio::awaitable<std::pair<int, std::string>> doPutAsync(
-      const boost::urls::url& url, const std::string& body);
+      api::EndpointId endpoint, const std::string& target,
+      const std::string& body);
   boost::asio::awaitable<std::pair<int, std::string>> doDeleteAsync(
-      const boost::urls::url& url);
+      api::EndpointId endpoint, const std::string& target);
 };
 
 }  // namespace outline
@@ -0,0 +1,55 @@
+#ifndef OUTLINE_CLIENT_OPTIONS_H
+#define OUTLINE_CLIENT_OPTIONS_H
+
+#include "outline/cache/AccessKeyCache.h"
+#include "outline/network/CircuitBreaker.h"
+#include "outline/network/Compression.h"
+#include "outline/network/ConnectionPool.h"
+#include "outline/network/HappyEyeballs.h"
+#include "outline/network/IoRuntime.h"
+#include "outline/network/RateLimiter.h"
+#include "outline/network/RequestCoalescer.h"
+#include "outline/network/ResolverCache.h"
+#include "outline/network/RetryPolicy.h"
+#include "outline/network/TlsSessionCache.h"
+#include "outline/utils/RequestArena.h"
+
+#include <memory>
+
+namespace outline {
+
+/**
+ * @brief Optional settings of OutlineClient. Defaults are suitable for most
+ *        deployments.
+ */
+struct OutlineClientOptions {
+  network::IoRuntimeOptions runtime;
+  /// Runs the requests on this runtime instead of starting own threads, e.g.
+  /// to serve many clients from one thread pool. `runtime` is ignored then.
+  /// Before the client is destroyed the owner has to stop the runtime, call
+  /// closeIdleConnections() and shut the runtime down, as OutlineFleet does.
+  std::shared_ptr<network::IoRuntime> sharedRuntime;
+  network::ConnectionPoolOptions connectionPool;
+  network::TlsSessionOptions tls;
+  network::ResolverCacheOptions dns;
+  /// Races the resolved addresses of the server instead of trying them one
+  /// after another.
+  network::HappyEyeballsOptions happyEyeballs;
+  /// Off by default. Pays off for large key lists over slow links.
+  network::CompressionOptions compression;
+  utils::ArenaOptions arena;
+  network::RetryOptions retry;
+  network::CircuitBreakerOptions circuitBreaker;
+  /// Disabled by default. Keeps large bulk runs from flooding a small
+  /// server.
+  network::RateLimiterOptions rateLimit;
+  /// Concurrent identical GETs share one request.
+  network::CoalescingOptions coalescing;
+  /// Disabled by default, since other clients of the server may change
+  /// keys behind this one's back for up to the TTL.
+  cache::AccessKeyCacheOptions accessKeyCache;
+};
+
+}  // namespace outline
+
+#endif  // OUTLINE_CLIENT_OPTIONS_H
@@ -0,0 +1,118 @@
+#ifndef OUTLINE_FLEET_H
+#define OUTLINE_FLEET_H
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "outline/OutlineClient.h"
+#include "outline/OutlineClientOptions.h"
+#include "outline/network/IoRuntime.h"
+
+namespace outline {
+
+/**
+ * @brief One Outline server of a fleet.
+ */
+struct FleetServer {
+  FleetServer(std::string apiUrl, std::string cert = "")
+      : apiUrl(std::move(apiUrl)), cert(std::move(cert)) {}
+
+  std::string apiUrl;
+  std::string cert;
+};
+
+/**
+ * @brief Settings of OutlineFleet.
+ */
+struct FleetOptions {
+  /// Threads shared by the clients of all servers.
+  network::IoRuntimeOptions runtime{4};
+  /// Settings of every client. Its runtime settings are ignored.
+  OutlineClientOptions client;
+  /// Deadline of each phase of a request, see OutlineClient.
+  int timeout = 5;
+  /// Time a server has to answer a fan-out request before it is reported
+  /// as timed out, so one slow node does not hold up the others.
+  std::chrono::milliseconds serverTimeout{std::chrono::seconds(5)};
+};
+
+/**
+ * @brief Answer of one server to a fan-out request.
+ */
+template <typename T>
+struct FleetResult {
+  /// Position of the server in the fleet.
+  std::size_t index = 0;
+  std::string apiUrl;
+  /// Set if the server answered.
+  std::optional<T> value;
+  /// Why the server did not answer, e.g. OutlineTimeoutException.
+  std::exception_ptr error;
+};
+
+/**
+ * @brief Queries many Outline servers at once from one shared runtime.
+ */
+class OutlineFleet {
+ public:
+  /// Called on an I/O thread as soon as a server has answered. Calls are
+  /// never concurrent.
+  template <typename T>
+  using ResultCallback = std::function<void(const FleetResult<T>&)>;
+
+  explicit OutlineFleet(const std::vector<FleetServer>& servers,
+                        const FleetOptions& options = {});
+  /**
+   * @brief Destructor. Stops the runtime and abandons unfinished requests.
+   */
+  ~OutlineFleet();
+
+  OutlineFleet(const OutlineFleet&) = delete;
+  OutlineFleet& operator=(const OutlineFleet&) = delete;
+
+  std::size_t size() const { return m_clients.size(); }
+  /**
+   * @brief Returns the client of the server at the index, e.g. to change
+   *        a single server.
+   */
+  OutlineClient& client(std::size_t index) { return *m_clients.at(index); }
+
+  /**
+   * @brief Sends the request to all servers at once.
+   * @param onResult - optionally receives every answer as it arrives.
+   * @return the answers of all servers in fleet order, once the last one
+   *         has answered or timed out.
+   */
+  std::future<std::vector<FleetResult<ServerInformation>>>
+  getServerInformationAsync(ResultCallback<ServerInformation> onResult = {});
+  std::future<std::vector<FleetResult<TransferMetrics>>> getMetricsAsync(
+      ResultCallback<TransferMetrics> onResult = {});
+  std::future<std::vector<FleetResult<std::vector<AccessKey>>>>
+  getAccessKeysAsync(ResultCallback<std::vector<AccessKey>> onResult = {});
+
+  std::vector<FleetResult<ServerInformation>> getServerInformation();
+  std::vector<FleetResult<TransferMetrics>> getMetrics();
+  std::vector<FleetResult<std::vector<AccessKey>>> getAccessKeys();
+
+ private:
+  template <typename T>
+  std::future<std::vector<FleetResult<T>>> fanOut(
+      boost::asio::awaitable<T> (OutlineClient::*operation)(),
+      ResultCallback<T> onResult);
+
+  FleetOptions m_options;
+  std::shared_ptr<network::IoRuntime> m_runtime;
+  std::vector<std::string> m_apiUrls;
+  std::vector<std::unique_ptr<OutlineClient>> m_clients;
+};
+
+}  // namespace outline
+
+#endif  // OUTLINE_FLEET_H
@@ -0,0 +1,111 @@
+#ifndef OUTLINE_CACHE_ACCESS_KEY_CACHE_H
+#define OUTLINE_CACHE_ACCESS_KEY_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace outline {
+namespace cache {
+
+/**
+ * @brief Settings of the read-through access key cache.
+ */
+struct AccessKeyCacheOptions {
+  /// Every read goes to the server when false.
+  bool enabled = false;
+  /// A key or the list of keys is served from memory for this long.
+  std::chrono::milliseconds ttl{std::chrono::seconds(30)};
+  /// A 404 for a key is served from memory for this long.
+  std::chrono::milliseconds negativeTtl{std::chrono::seconds(5)};
+  /// Responses are no longer added while this many are cached.
+  std::size_t maxEntries = 10000;
+};
+
+/**
+ * @brief Snapshot of the access key cache counters.
+ */
+struct AccessKeyCacheStats {
+  /// Reads served by a cached key or list.
+  std::uint64_t hits = 0;
+  /// Reads served by a cached 404.
+  std::uint64_t negativeHits = 0;
+  /// Reads which went to the server.
+  std::uint64_t misses = 0;
+  /// Writes which dropped cached responses.
+  std::uint64_t invalidations = 0;
+  /// Responses cached right now, including expired ones.
+  std::size_t entries = 0;
+};
+
+/**
+ * @brief Caches the responses to GET /access-keys and GET /access-keys/{id}.
+ *
+ * Only 200 and 404 responses are kept. A write through the client drops the
+ * key and the list; a read which started before the write never stores its
+ * now outdated response.
+ */
+class AccessKeyCache {
+ public:
+  /// The id under which the list of all keys is cached.
+  static constexpr const char* kAllKeys = "";
+
+  explicit AccessKeyCache(const AccessKeyCacheOptions& options);
+
+  bool enabled() const { return m_options.enabled; }
+
+  /**
+   * @brief Returns the cached status and body of the key, or of the list
+   *        for kAllKeys, unless it is missing or expired.
+   */
+  std::optional<std::pair<int, std::string>> find(
+      const std::string& accessKeyId);
+  /**
+   * @brief Returns the value to pass to store() for a read starting now.
+   */
+  std::uint64_t generation() const;
+  /**
+   * @brief Caches a response unless a write has invalidated the cache since
+   *        the read started.
+   */
+  void store(const std::string& accessKeyId, int status,
+             const std::string& body, std::uint64_t generation);
+  /**
+   * @brief Drops the key and the list after a write to the key. kAllKeys
+   *        only drops the list, e.g. after a key was created.
+   */
+  void invalidate(const std::string& accessKeyId);
+  void clear();
+
+  AccessKeyCacheStats stats() const;
+
+ private:
+  struct Entry {
+    int status = 0;
+    /// Shared, so a hit copies the body outside the lock.
+    std::shared_ptr<const std::string> body;
+    std::chrono::steady_clock::time_point expiresAt;
+  };
+
+  AccessKeyCacheOptions m_options;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::uint64_t m_generation = 0;
+
+  std::atomic<std::uint64_t> m_hits{0};
+  std::atomic<std::uint64_t> m_negativeHits{0};
+  std::atomic<std::uint64_t> m_misses{0};
+  std::atomic<std::uint64_t> m_invalidations{0};
+};
+
+}  // namespace cache
+}  // namespace outline
+
+#endif  // OUTLINE_CACHE_ACCESS_KEY_CACHE_H
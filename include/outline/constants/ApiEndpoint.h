@@ -2,6 +2,10 @@
 #ifndef API_ENDPOINTS_H
 #define API_ENDPOINTS_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 
@@ -12,26 +16,165 @@ struct UrlParams {
   static constexpr std::string_view KeyId = "key_id";
 };
 
+/**
+ * @brief Path of an endpoint with {name} placeholders, parsed at compile
+ *        time.
+ *
+ * A malformed pattern does not compile. utils::buildTarget checks the
+ * placeholder names the caller passes against the route, also at compile
+ * time.
+ */
+class Route {
+ public:
+  static constexpr std::size_t kMaxPlaceholders = 2;
+
+  consteval Route(std::string_view pattern) : m_pattern(pattern) {
+    std::size_t literalStart = 0;
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+      if (pattern[i] == '}') {
+        throw std::invalid_argument("Unmatched '}' in route");
+      }
+      if (pattern[i] != '{') {
+        continue;
+      }
+      const std::size_t close = pattern.find('}', i);
+      if (close == std::string_view::npos) {
+        throw std::invalid_argument("Unmatched '{' in route");
+      }
+      const std::string_view name = pattern.substr(i + 1, close - i - 1);
+      if (name.empty() || name.find('{') != std::string_view::npos) {
+        throw std::invalid_argument("Invalid placeholder in route");
+      }
+      if (m_placeholderCount == kMaxPlaceholders) {
+        throw std::invalid_argument("Too many placeholders in route");
+      }
+      m_literals[m_placeholderCount] =
+          pattern.substr(literalStart, i - literalStart);
+      m_placeholders[m_placeholderCount++] = name;
+      literalStart = close + 1;
+      i = close;
+    }
+    m_literals[m_placeholderCount] = pattern.substr(literalStart);
+  }
+
+  constexpr std::string_view pattern() const { return m_pattern; }
+  constexpr std::size_t placeholderCount() const { return m_placeholderCount; }
+  constexpr std::string_view placeholder(std::size_t index) const {
+    return m_placeholders[index];
+  }
+  /**
+   * @brief Returns the text before placeholder `index`, or after the last
+   *        one for index == placeholderCount().
+   */
+  constexpr std::string_view literal(std::size_t index) const {
+    return m_literals[index];
+  }
+  /**
+   * @brief Returns the length of the pattern without its placeholders.
+   */
+  constexpr std::size_t literalSize() const {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i <= m_placeholderCount; ++i) {
+      size += m_literals[i].size();
+    }
+    return size;
+  }
+  /**
+   * @brief Returns true if the route has exactly these placeholders, in
+   *        this order.
+   */
+  template <std::size_t N>
+  constexpr bool hasPlaceholders(
+      const std::array<std::string_view, N>& names) const {
+    if (N != m_placeholderCount) {
+      return false;
+    }
+    for (std::size_t i = 0; i < N; ++i) {
+      if (names[i] != m_placeholders[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::string_view m_pattern;
+  std::array<std::string_view, kMaxPlaceholders + 1> m_literals{};
+  std::array<std::string_view, kMaxPlaceholders> m_placeholders{};
+  std::size_t m_placeholderCount = 0;
+};
+
 struct Endpoints {
-  static constexpr std::string_view GetAccessKeys = "/access-keys";
-  static constexpr std::string_view GetAccessKeyById = "/access-keys/{key_id}";
-  static constexpr std::string_view CreateAccessKey = "/access-keys";
-  static constexpr std::string_view UpdateAccessKey = "/access-keys/{key_id}";
-  static constexpr std::string_view DeleteAccessKey = "/access-keys/{key_id}";
-  static constexpr std::string_view RenameAccessKey = "/access-keys/{key_id}/name";
-  static constexpr std::string_view AddDataLimit = "/access-keys/{key_id}/data-limit";
-  static constexpr std::string_view DeleteDataLimit = "/access-keys/{key_id}/data-limit";
-  static constexpr std::string_view GetMetrics = "/metrics/transfer";
-  static constexpr std::string_view GetServerInformation = "/server";
-  static constexpr std::string_view SetServerName = "/name";
-  static constexpr std::string_view SetHostName = "/server/hostname-for-access-keys";
-  static constexpr std::string_view GetMetricsStatus = "/metrics/enabled";
-  static constexpr std::string_view SetMetricsStatus = "/metrics/enabled";
-  static constexpr std::string_view SetDefaultPort = "/server/port-for-new-access-keys";
-  static constexpr std::string_view SetDataLimitForAllAccessKeys = "/server/access-key-data-limit";
-  static constexpr std::string_view DeleteDataLimitForAllAccessKeys = "/server/access-key-data-limit";
+  static constexpr Route GetAccessKeys{"/access-keys"};
+  static constexpr Route GetAccessKeyById{"/access-keys/{key_id}"};
+  static constexpr Route CreateAccessKey{"/access-keys"};
+  static constexpr Route UpdateAccessKey{"/access-keys/{key_id}"};
+  static constexpr Route DeleteAccessKey{"/access-keys/{key_id}"};
+  static constexpr Route RenameAccessKey{"/access-keys/{key_id}/name"};
+  static constexpr Route AddDataLimit{"/access-keys/{key_id}/data-limit"};
+  static constexpr Route DeleteDataLimit{"/access-keys/{key_id}/data-limit"};
+  static constexpr Route GetMetrics{"/metrics/transfer"};
+  static constexpr Route GetServerInformation{"/server"};
+  static constexpr Route SetServerName{"/name"};
+  static constexpr Route SetHostName{"/server/hostname-for-access-keys"};
+  static constexpr Route GetMetricsStatus{"/metrics/enabled"};
+  static constexpr Route SetMetricsStatus{"/metrics/enabled"};
+  static constexpr Route SetDefaultPort{"/server/port-for-new-access-keys"};
+  static constexpr Route SetDataLimitForAllAccessKeys{
+      "/server/access-key-data-limit"};
+  static constexpr Route DeleteDataLimitForAllAccessKeys{
+      "/server/access-key-data-limit"};
 };
 
+/**
+ * @brief Identifies the route of a request in per-endpoint statistics.
+ */
+enum class EndpointId : std::uint8_t {
+  GetAccessKeys,
+  GetAccessKeyById,
+  CreateAccessKey,
+  UpdateAccessKey,
+  DeleteAccessKey,
+  RenameAccessKey,
+  AddDataLimit,
+  DeleteDataLimit,
+  GetMetrics,
+  GetServerInformation,
+  SetServerName,
+  SetHostName,
+  GetMetricsStatus,
+  SetMetricsStatus,
+  SetDefaultPort,
+  SetDataLimitForAllAccessKeys,
+  DeleteDataLimitForAllAccessKeys,
+};
+
+inline constexpr std::size_t kEndpointCount = 17;
+
+inline constexpr std::array<std::string_view, kEndpointCount> kEndpointNames = {
+    "GetAccessKeys",
+    "GetAccessKeyById",
+    "CreateAccessKey",
+    "UpdateAccessKey",
+    "DeleteAccessKey",
+    "RenameAccessKey",
+    "AddDataLimit",
+    "DeleteDataLimit",
+    "GetMetrics",
+    "GetServerInformation",
+    "SetServerName",
+    "SetHostName",
+    "GetMetricsStatus",
+    "SetMetricsStatus",
+    "SetDefaultPort",
+    "SetDataLimitForAllAccessKeys",
+    "DeleteDataLimitForAllAccessKeys",
+};
+
+constexpr std::string_view endpointName(EndpointId endpoint) {
+  return kEndpointNames[static_cast<std::size_t>(endpoint)];
+}
+
 }  // namespace api
 }  // namespace outline
 
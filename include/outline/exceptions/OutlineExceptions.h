@@ -33,6 +33,36 @@ class OutlineTimeoutException : public OutlineException {
       : OutlineException("Timeout Error: " + message) {}
 };
 
+/**
+ * @brief Исключение, которое говорит о том, что запрос не был отправлен,
+ *        так как сервер недавно многократно не отвечал (circuit breaker).
+ */
+class OutlineCircuitOpenException : public OutlineNetworkException {
+ public:
+  explicit OutlineCircuitOpenException(const std::string& message)
+      : OutlineNetworkException(message) {}
+};
+
+/**
+ * @brief Исключение, которое говорит о том, что запрос не был отправлен,
+ *        так как очередь ограничителя частоты запросов переполнена.
+ */
+class OutlineRateLimitedException : public OutlineException {
+ public:
+  explicit OutlineRateLimitedException(const std::string& message)
+      : OutlineException("Rate Limited: " + message) {}
+};
+
+/**
+ * @brief Исключение, возникающее при ошибках чтения или записи архива
+ *        метрик, а также если файл не является архивом.
+ */
+class OutlineArchiveException : public OutlineException {
+ public:
+  explicit OutlineArchiveException(const std::string& message)
+      : OutlineException("Archive Error: " + message) {}
+};
+
 /**
  * @brief Исключение, возникающее при ошибках парсинга входных данных (JSON, XML, и т.д.).
  */
@@ -48,8 +78,17 @@ class OutlineParseException : public OutlineException {
  */
 class OutlineServerErrorException : public OutlineException {
  public:
-  explicit OutlineServerErrorException(const std::string& message)
-      : OutlineException("Server Error: " + message) {}
+  explicit OutlineServerErrorException(const std::string& message,
+                                       int status = 0)
+      : OutlineException("Server Error: " + message), m_status(status) {}
+
+  /**
+   * @brief HTTP-статус ответа сервера или 0, если он неизвестен.
+   */
+  int status() const { return m_status; }
+
+ private:
+  int m_status;
 };
 
 }  // namespace outline
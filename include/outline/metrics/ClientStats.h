@@ -0,0 +1,55 @@
+#ifndef OUTLINE_METRICS_CLIENT_STATS_H
+#define OUTLINE_METRICS_CLIENT_STATS_H
+
+#include <string>
+#include <vector>
+
+#include "outline/cache/AccessKeyCache.h"
+#include "outline/metrics/RequestMetrics.h"
+#include "outline/network/CircuitBreaker.h"
+#include "outline/network/Compression.h"
+#include "outline/network/ConnectionPool.h"
+#include "outline/network/HappyEyeballs.h"
+#include "outline/network/RateLimiter.h"
+#include "outline/network/RequestCoalescer.h"
+#include "outline/network/ResolverCache.h"
+#include "outline/network/RetryPolicy.h"
+#include "outline/network/TlsSessionCache.h"
+#include "outline/utils/RequestArena.h"
+
+namespace outline {
+namespace metrics {
+
+/**
+ * @brief Snapshot of every counter of an OutlineClient.
+ */
+struct ClientStats {
+  /// One entry per api::EndpointId, in that order.
+  std::vector<EndpointStats> endpoints;
+  network::ConnectionPoolStats connectionPool;
+  network::TlsHandshakeStats tls;
+  network::ResolverCacheStats dns;
+  network::HappyEyeballsStats connect;
+  network::CompressionStats compression;
+  network::RetryStats retry;
+  network::CircuitBreakerStats circuitBreaker;
+  network::RateLimiterStats rateLimiter;
+  network::CoalescingStats coalescing;
+  cache::AccessKeyCacheStats accessKeyCache;
+  utils::ArenaStats arena;
+};
+
+/**
+ * @brief Renders the snapshot in the Prometheus text exposition format.
+ *
+ * Latencies are exported as a histogram in seconds. Its buckets are summed
+ * from the finer buckets of LatencyHistogram, so a sample close to a bound
+ * may be counted in the next bucket. Endpoints which were never called are
+ * left out.
+ */
+std::string toPrometheus(const ClientStats& stats);
+
+}  // namespace metrics
+}  // namespace outline
+
+#endif  // OUTLINE_METRICS_CLIENT_STATS_H
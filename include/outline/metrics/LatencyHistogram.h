@@ -0,0 +1,69 @@
+#ifndef OUTLINE_METRICS_LATENCY_HISTOGRAM_H
+#define OUTLINE_METRICS_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace outline {
+namespace metrics {
+
+/**
+ * @brief Copy of the counters of a LatencyHistogram.
+ */
+struct HistogramSnapshot {
+  /// Number of samples per bucket, see LatencyHistogram::bucketUpperBound.
+  std::vector<std::uint64_t> buckets;
+  std::uint64_t count = 0;
+  std::uint64_t sumMicros = 0;
+  std::uint64_t maxMicros = 0;
+
+  /**
+   * @brief Returns the latency below which the fraction q of the samples
+   *        lies, e.g. 0.99, accurate to the bucket width.
+   */
+  std::chrono::microseconds percentile(double q) const;
+  /**
+   * @brief Returns the number of samples in buckets which end at or below
+   *        the bound.
+   */
+  std::uint64_t countAtOrBelow(std::chrono::microseconds bound) const;
+};
+
+/**
+ * @brief Lock-free latency histogram with HDR-style log-linear buckets.
+ *
+ * Every power of two is split into 16 linear buckets, so a bucket is at
+ * most 1/16 of its value wide, from 1 us up to about 12 days. Recording is
+ * a few relaxed atomic increments.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr std::size_t kSubBucketBits = 4;
+  static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+  /// Samples of 2^kMaxBits us and more land in the last bucket.
+  static constexpr std::size_t kMaxBits = 40;
+  static constexpr std::size_t kBucketCount =
+      (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+  void record(std::chrono::nanoseconds latency);
+  HistogramSnapshot snapshot() const;
+
+  static std::size_t bucketIndex(std::uint64_t micros);
+  /// The largest latency in us which falls into the bucket.
+  static std::uint64_t bucketUpperBound(std::size_t index);
+
+ private:
+  std::array<std::atomic<std::uint64_t>, kBucketCount> m_buckets{};
+  std::atomic<std::uint64_t> m_count{0};
+  std::atomic<std::uint64_t> m_sumMicros{0};
+  std::atomic<std::uint64_t> m_maxMicros{0};
+};
+
+}  // namespace metrics
+}  // namespace outline
+
+#endif  // OUTLINE_METRICS_LATENCY_HISTOGRAM_H
@@ -0,0 +1,191 @@
+#ifndef OUTLINE_METRICS_METRICS_ARCHIVE_H
+#define OUTLINE_METRICS_METRICS_ARCHIVE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "outline/models/TransferMetrics.h"
+
+namespace outline {
+namespace metrics {
+
+/**
+ * @brief Settings of MetricsArchiveWriter.
+ */
+struct MetricsArchiveOptions {
+  /// Samples per block. A block also ends early when a new key appears,
+  /// since its columns are laid out when it is opened.
+  std::uint32_t samplesPerBlock = 256;
+};
+
+/**
+ * @brief Appends transfer metrics snapshots to a memory-mapped columnar
+ *        file, for usage history of months rather than a window.
+ *
+ * The file is a header followed by records, each only ever appended:
+ * dictionary records assign the next key numbers to access key ids, and
+ * block records hold up to samplesPerBlock samples as a column of
+ * timestamps plus one contiguous column per key. A column holds the bytes
+ * the key transferred since the previous sample, so a range of samples is
+ * summed with one pass over adjacent uint64 values. Blocks are written in
+ * place through the mapping and a sample counts once the block's sample
+ * count covers it, so a crash loses at most the sample being written.
+ *
+ * Counters follow UsageSeries: the first sample of an empty archive only
+ * sets the baseline, a key which appears later is counted from zero, and a
+ * counter which went down is counted from zero again. Reopening an archive
+ * continues from its last sample. Not thread-safe.
+ */
+class MetricsArchiveWriter {
+ public:
+  using Clock = std::chrono::system_clock;
+
+  /**
+   * @brief Opens the archive at path, creating it if it does not exist.
+   * @throws OutlineArchiveException if the file cannot be opened or is not
+   *         an archive.
+   */
+  explicit MetricsArchiveWriter(const std::string& path,
+                                const MetricsArchiveOptions& options = {});
+  /**
+   * @brief Destructor. Trims the space reserved for later records and
+   *        closes the file.
+   */
+  ~MetricsArchiveWriter();
+
+  MetricsArchiveWriter(const MetricsArchiveWriter&) = delete;
+  MetricsArchiveWriter& operator=(const MetricsArchiveWriter&) = delete;
+
+  /**
+   * @brief Appends a snapshot of the cumulative counters of the server. A
+   *        time before the last sample is stored as the last sample's time,
+   *        so the timestamps stay sorted.
+   * @throws OutlineArchiveException if the file cannot grow.
+   */
+  void append(const TransferMetrics& snapshot,
+              Clock::time_point time = Clock::now());
+  /**
+   * @brief Writes the appended samples to disk.
+   */
+  void flush();
+
+  std::uint64_t sampleCount() const { return m_samples; }
+  std::size_t keyCount() const { return m_lastCounters.size(); }
+
+ private:
+  void map(std::size_t size);
+  void unmap();
+  /// Makes room for a record of `size` bytes after the used part.
+  void reserve(std::size_t size);
+  void load();
+  void appendKeys(const std::vector<std::string>& keyIds);
+  void openBlock();
+
+  std::string m_path;
+  MetricsArchiveOptions m_options;
+  int m_fd = -1;
+  char* m_data = nullptr;
+  std::size_t m_mapped = 0;
+  /// End of the last complete record.
+  std::size_t m_used = 0;
+  /// Offset of the block being filled, 0 if there is none.
+  std::size_t m_block = 0;
+  std::unordered_map<std::string, std::uint32_t> m_keyNumbers;
+  /// Last cumulative counter of every key, by key number.
+  std::vector<std::uint64_t> m_lastCounters;
+  std::int64_t m_lastTimestamp = 0;
+  std::uint64_t m_samples = 0;
+};
+
+/**
+ * @brief Answers usage queries from a MetricsArchiveWriter file.
+ *
+ * Maps the file read-only and indexes its records once, so it sees the
+ * samples which existed when it was opened. Queries skip the blocks
+ * outside the range, binary search the timestamps of the blocks at its
+ * edges and sum whole columns in between. Safe to use from many threads.
+ *
+ * @code
+ * metrics::MetricsArchiveReader archive("usage.oma");
+ * auto march = archive.bytesBetween(keyId, marchStart, aprilStart);
+ * @endcode
+ */
+class MetricsArchiveReader {
+ public:
+  using Clock = std::chrono::system_clock;
+
+  /**
+   * @throws OutlineArchiveException if the file cannot be opened or is not
+   *         an archive.
+   */
+  explicit MetricsArchiveReader(const std::string& path);
+  ~MetricsArchiveReader();
+
+  MetricsArchiveReader(const MetricsArchiveReader&) = delete;
+  MetricsArchiveReader& operator=(const MetricsArchiveReader&) = delete;
+
+  /// Access key ids in the order of their key numbers.
+  const std::vector<std::string>& keys() const { return m_keys; }
+  std::uint64_t sampleCount() const { return m_samples; }
+  std::optional<Clock::time_point> firstSample() const;
+  std::optional<Clock::time_point> lastSample() const;
+
+  /**
+   * @brief Returns the bytes the key transferred in the intervals ending
+   *        with the samples taken in [from, to). 0 for an unknown key.
+   */
+  std::uint64_t bytesBetween(const std::string& keyId, Clock::time_point from,
+                             Clock::time_point to) const;
+  /**
+   * @brief Returns bytesBetween() of every key, indexed like keys().
+   */
+  std::vector<std::uint64_t> bytesByKeyBetween(Clock::time_point from,
+                                               Clock::time_point to) const;
+  /**
+   * @brief Returns the time and the bytes of every sample of the key taken
+   *        in [from, to).
+   */
+  std::vector<std::pair<Clock::time_point, std::uint64_t>> series(
+      const std::string& keyId, Clock::time_point from,
+      Clock::time_point to) const;
+
+ private:
+  /**
+   * @brief A block as it was when the reader was opened.
+   */
+  struct Block {
+    const std::int64_t* timestamps = nullptr;
+    /// Column-major: `capacity` values per key.
+    const std::uint64_t* deltas = nullptr;
+    std::uint32_t capacity = 0;
+    std::uint32_t keys = 0;
+    std::uint32_t samples = 0;
+  };
+
+  /**
+   * @brief Calls visit(block, first, last) for the samples of every block
+   *        taken in [from, to).
+   */
+  template <typename Visit>
+  void forEachRange(Clock::time_point from, Clock::time_point to,
+                    Visit&& visit) const;
+
+  int m_fd = -1;
+  const char* m_data = nullptr;
+  std::size_t m_mapped = 0;
+  std::vector<std::string> m_keys;
+  std::unordered_map<std::string, std::uint32_t> m_keyNumbers;
+  std::vector<Block> m_blocks;
+  std::uint64_t m_samples = 0;
+};
+
+}  // namespace metrics
+}  // namespace outline
+
+#endif  // OUTLINE_METRICS_METRICS_ARCHIVE_H
@@ -0,0 +1,108 @@
+#ifndef OUTLINE_METRICS_REQUEST_METRICS_H
+#define OUTLINE_METRICS_REQUEST_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "outline/constants/ApiEndpoint.h"
+#include "outline/metrics/LatencyHistogram.h"
+
+namespace outline {
+namespace metrics {
+
+/**
+ * @brief Snapshot of the requests sent to one endpoint.
+ */
+struct EndpointStats {
+  api::EndpointId endpoint = api::EndpointId::GetAccessKeys;
+  std::string_view name;
+  /// Responses received, by HTTP status code. Only codes seen are listed.
+  std::vector<std::pair<int, std::uint64_t>> responsesByStatus;
+  /// Attempts which ran out of time before a response arrived.
+  std::uint64_t timeouts = 0;
+  /// Attempts which failed or were cancelled before a response arrived.
+  std::uint64_t failures = 0;
+  /// Request and response body bytes.
+  std::uint64_t bytesSent = 0;
+  std::uint64_t bytesReceived = 0;
+  /// Attempts in flight right now.
+  std::int64_t inFlight = 0;
+  /// Time from sending an attempt to its response or failure.
+  HistogramSnapshot latency;
+
+  std::uint64_t responses() const;
+};
+
+/**
+ * @brief Per-endpoint request counters of one client.
+ *
+ * Every counter is a relaxed atomic in a table indexed by endpoint, so
+ * requests on any number of threads record without taking a lock.
+ */
+class RequestMetrics {
+ public:
+  class Recording;
+
+  /**
+   * @brief Starts timing an attempt and counts it as in flight until the
+   *        returned recording is destroyed.
+   */
+  Recording start(api::EndpointId endpoint, std::size_t bytesSent);
+  /**
+   * @brief Returns the stats of every endpoint in EndpointId order.
+   */
+  std::vector<EndpointStats> snapshot() const;
+
+ private:
+  static constexpr int kMinStatus = 100;
+  static constexpr int kMaxStatus = 599;
+
+  struct Endpoint {
+    std::array<std::atomic<std::uint64_t>, kMaxStatus - kMinStatus + 1>
+        responsesByStatus{};
+    std::atomic<std::uint64_t> otherResponses{0};
+    std::atomic<std::uint64_t> timeouts{0};
+    std::atomic<std::uint64_t> failures{0};
+    std::atomic<std::uint64_t> bytesSent{0};
+    std::atomic<std::uint64_t> bytesReceived{0};
+    std::atomic<std::int64_t> inFlight{0};
+    LatencyHistogram latency;
+  };
+
+  std::array<Endpoint, api::kEndpointCount> m_endpoints;
+};
+
+/**
+ * @brief Records the outcome of one attempt. An attempt which is neither
+ *        answered nor timed out by destruction counts as failed.
+ */
+class RequestMetrics::Recording {
+ public:
+  Recording(Recording&& other) noexcept;
+  Recording& operator=(Recording&&) = delete;
+  ~Recording();
+
+  void responded(int status, std::size_t bytesReceived);
+  void timedOut();
+  void failed();
+
+ private:
+  friend class RequestMetrics;
+
+  explicit Recording(Endpoint& endpoint);
+  void finish();
+
+  Endpoint* m_endpoint;
+  std::chrono::steady_clock::time_point m_started;
+};
+
+}  // namespace metrics
+}  // namespace outline
+
+#endif  // OUTLINE_METRICS_REQUEST_METRICS_H
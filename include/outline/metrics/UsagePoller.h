@@ -0,0 +1,118 @@
+#ifndef OUTLINE_METRICS_USAGE_POLLER_H
+#define OUTLINE_METRICS_USAGE_POLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "outline/OutlineClient.h"
+#include "outline/metrics/MetricsArchive.h"
+#include "outline/metrics/UsageSeries.h"
+
+namespace outline {
+namespace metrics {
+
+/**
+ * @brief Settings of UsagePoller.
+ */
+struct UsagePollerOptions {
+  /// Time between two snapshots of /metrics/transfer. A poll which takes
+  /// longer is abandoned and counted as failed.
+  std::chrono::milliseconds interval{std::chrono::seconds(60)};
+  /// Number of intervals kept per key.
+  std::size_t window = 60;
+  /// Also appends every snapshot to this archive, for history beyond the
+  /// window. Must outlive the poller.
+  MetricsArchiveWriter* archive = nullptr;
+};
+
+/**
+ * @brief Counters of a UsagePoller.
+ */
+struct UsagePollerStats {
+  /// Snapshots added to the series.
+  std::uint64_t polls = 0;
+  /// Polls which failed, timed out or could not be archived. The next
+  /// snapshot covers their interval as well.
+  std::uint64_t failures = 0;
+  /// Keys tracked by the series.
+  std::size_t keys = 0;
+};
+
+/**
+ * @brief Samples the transfer metrics of a server in the background and
+ *        answers usage queries from memory.
+ *
+ * @code
+ * metrics::UsagePoller poller(*client, {std::chrono::seconds(10), 360});
+ * poller.start();
+ * // ...
+ * auto lastHour = poller.bytesOverLast(keyId, std::chrono::hours(1));
+ * @endcode
+ */
+class UsagePoller {
+ public:
+  /**
+   * @param client - must outlive the poller.
+   */
+  explicit UsagePoller(OutlineClient& client,
+                       const UsagePollerOptions& options = {});
+  /**
+   * @brief Destructor. Stops polling.
+   */
+  ~UsagePoller();
+
+  UsagePoller(const UsagePoller&) = delete;
+  UsagePoller& operator=(const UsagePoller&) = delete;
+
+  /**
+   * @brief Takes the first snapshot now and then one every interval.
+   */
+  void start();
+  /**
+   * @brief Cancels the poll in flight and waits for polling to end. Must
+   *        not be called from an I/O thread of the client.
+   */
+  void stop();
+
+  /**
+   * @brief Returns the bytes the key transferred during the period, rounded
+   *        up to whole intervals and clamped to the recorded window.
+   */
+  std::uint64_t bytesOverLast(const std::string& keyId,
+                              std::chrono::milliseconds period) const;
+  /**
+   * @brief Returns the bytes per second of the key during the last interval.
+   */
+  double currentRate(const std::string& keyId) const;
+
+  const UsageSeries& series() const { return m_series; }
+  UsagePollerStats stats() const;
+
+ private:
+  boost::asio::awaitable<void> run();
+
+  OutlineClient& m_client;
+  UsagePollerOptions m_options;
+  UsageSeries m_series;
+  boost::asio::any_io_executor m_executor;
+  /// Never expires; cancelling it wakes the polling loop up for good.
+  boost::asio::steady_timer m_stopTimer;
+  /// Only accessed on m_executor.
+  bool m_stopped = false;
+  std::future<void> m_done;
+  std::atomic<std::uint64_t> m_polls{0};
+  std::atomic<std::uint64_t> m_failures{0};
+};
+
+}  // namespace metrics
+}  // namespace outline
+
+#endif  // OUTLINE_METRICS_USAGE_POLLER_H
@@ -0,0 +1,90 @@
+#ifndef OUTLINE_METRICS_USAGE_SERIES_H
+#define OUTLINE_METRICS_USAGE_SERIES_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "outline/models/TransferMetrics.h"
+
+namespace outline {
+namespace metrics {
+
+/**
+ * @brief Transfer per access key over a sliding window of snapshots.
+ *
+ * Every key owns one row of a flat table with a slot per snapshot in the
+ * window. A slot holds the bytes the key has transferred since it was first
+ * seen, so the transfer between any two snapshots is a single subtraction
+ * and queries take O(1) regardless of the window length. Memory is bounded
+ * by keys x window; a key missing from a whole window of snapshots frees
+ * its row.
+ */
+class UsageSeries {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @param window - the number of intervals which can be queried.
+   */
+  explicit UsageSeries(std::size_t window);
+
+  /**
+   * @brief Adds a snapshot of the cumulative counters of the server.
+   *
+   * The first snapshot only sets the baseline. A key which appears later is
+   * counted from zero, and a counter which went down, e.g. after a server
+   * restart, is counted from zero again.
+   */
+  void record(const TransferMetrics& snapshot, Clock::time_point time);
+
+  /**
+   * @brief Returns the bytes the key transferred during the last intervals.
+   * @param intervals - clamped to the number of recorded intervals.
+   */
+  std::uint64_t bytesOverLast(const std::string& keyId,
+                              std::size_t intervals) const;
+  /**
+   * @brief Returns the bytes per second of the key during the last interval.
+   */
+  double currentRate(const std::string& keyId) const;
+
+  /// Number of intervals which can be queried right now.
+  std::size_t recordedIntervals() const;
+  /// Number of keys with a row.
+  std::size_t keyCount() const;
+
+ private:
+  struct Row {
+    std::size_t index = 0;
+    /// Last cumulative counter reported by the server.
+    std::uint64_t lastCounter = 0;
+    /// Snapshot number the key was last reported in.
+    std::uint64_t lastSeen = 0;
+  };
+
+  std::uint64_t& slot(std::size_t row, std::uint64_t snapshot);
+  std::uint64_t slot(std::size_t row, std::uint64_t snapshot) const;
+  std::size_t allocateRow();
+
+  /// The window plus the slot holding the baseline of its first interval.
+  std::size_t m_capacity;
+  mutable std::shared_mutex m_mutex;
+  std::unordered_map<std::string, Row> m_rows;
+  std::vector<std::size_t> m_freeRows;
+  /// Row-major table of capacity slots per row.
+  std::vector<std::uint64_t> m_totals;
+  /// Time of each snapshot in the window.
+  std::vector<Clock::time_point> m_times;
+  /// Number of snapshots recorded so far.
+  std::uint64_t m_snapshots = 0;
+};
+
+}  // namespace metrics
+}  // namespace outline
+
+#endif  // OUTLINE_METRICS_USAGE_SERIES_H
@@ -0,0 +1,43 @@
+#ifndef OUTLINE_MODELS_ACCESS_KEY_H
+#define OUTLINE_MODELS_ACCESS_KEY_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/json/value_to.hpp>
+
+namespace outline {
+
+struct DataLimit {
+  std::int64_t bytes = 0;
+};
+
+/**
+ * @brief Access key as returned by the /access-keys endpoints.
+ */
+struct AccessKey {
+  std::string id;
+  std::string name;
+  std::string password;
+  int port = 0;
+  std::string method;
+  std::optional<DataLimit> dataLimit;
+  std::string accessUrl;
+};
+
+DataLimit tag_invoke(boost::json::value_to_tag<DataLimit>,
+                     const boost::json::value& jv);
+AccessKey tag_invoke(boost::json::value_to_tag<AccessKey>,
+                     const boost::json::value& jv);
+
+/**
+ * @brief Reads the keys of a GET /access-keys response ({"accessKeys": [...]}).
+ * @throws OutlineParseException if the document has another structure.
+ */
+std::vector<AccessKey> accessKeysFromJson(const boost::json::value& jv);
+
+}  // namespace outline
+
+#endif  // OUTLINE_MODELS_ACCESS_KEY_H
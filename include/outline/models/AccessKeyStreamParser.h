@@ -0,0 +1,53 @@
+#ifndef OUTLINE_MODELS_ACCESS_KEY_STREAM_PARSER_H
+#define OUTLINE_MODELS_ACCESS_KEY_STREAM_PARSER_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "outline/models/AccessKey.h"
+
+namespace outline {
+
+/**
+ * @brief Incremental parser of a GET /access-keys response.
+ *
+ * The body may be written in chunks of any size. Every access key is passed
+ * to the callback as soon as its closing brace has been parsed, so memory use
+ * does not depend on the number of keys in the response.
+ */
+class AccessKeyStreamParser {
+ public:
+  using Callback = std::function<void(AccessKey&&)>;
+
+  explicit AccessKeyStreamParser(Callback onAccessKey);
+  ~AccessKeyStreamParser();
+
+  AccessKeyStreamParser(const AccessKeyStreamParser&) = delete;
+  AccessKeyStreamParser& operator=(const AccessKeyStreamParser&) = delete;
+
+  /**
+   * @brief Parses the next chunk of the body.
+   * @throws OutlineParseException if the chunk is not valid JSON.
+   */
+  void write(std::string_view chunk);
+  /**
+   * @brief Completes parsing after the last chunk.
+   * @throws OutlineParseException if the document is incomplete or has no
+   *         accessKeys array.
+   */
+  void finish();
+  /**
+   * @brief Returns the number of access keys passed to the callback.
+   */
+  std::size_t count() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace outline
+
+#endif  // OUTLINE_MODELS_ACCESS_KEY_STREAM_PARSER_H
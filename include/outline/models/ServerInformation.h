@@ -0,0 +1,33 @@
+#ifndef OUTLINE_MODELS_SERVER_INFORMATION_H
+#define OUTLINE_MODELS_SERVER_INFORMATION_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include <boost/json/value_to.hpp>
+
+#include "outline/models/AccessKey.h"
+
+namespace outline {
+
+/**
+ * @brief Server information as returned by GET /server.
+ */
+struct ServerInformation {
+  std::string name;
+  std::string serverId;
+  bool metricsEnabled = false;
+  std::int64_t createdTimestampMs = 0;
+  std::string version;
+  std::optional<DataLimit> accessKeyDataLimit;
+  int portForNewAccessKeys = 0;
+  std::string hostnameForAccessKeys;
+};
+
+ServerInformation tag_invoke(boost::json::value_to_tag<ServerInformation>,
+                             const boost::json::value& jv);
+
+}  // namespace outline
+
+#endif  // OUTLINE_MODELS_SERVER_INFORMATION_H
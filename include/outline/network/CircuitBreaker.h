@@ -0,0 +1,85 @@
+#ifndef OUTLINE_CIRCUIT_BREAKER_H
+#define OUTLINE_CIRCUIT_BREAKER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace outline {
+namespace network {
+
+enum class CircuitState {
+  /// Requests are sent.
+  Closed,
+  /// The server failed repeatedly. Requests fail fast until the cool-down
+  /// has passed.
+  Open,
+  /// The cool-down has passed. A single probe request decides whether the
+  /// circuit closes or opens again.
+  HalfOpen,
+};
+
+/**
+ * @brief Settings of the circuit breaker of a server.
+ */
+struct CircuitBreakerOptions {
+  /// Sends every request regardless of earlier failures when false.
+  bool enabled = true;
+  /// Consecutive failed attempts which open the circuit.
+  int failureThreshold = 5;
+  /// How long an open circuit rejects requests before a probe is let through.
+  std::chrono::milliseconds coolDown{std::chrono::seconds(30)};
+};
+
+/**
+ * @brief Snapshot of the circuit breaker state and counters.
+ */
+struct CircuitBreakerStats {
+  CircuitState state = CircuitState::Closed;
+  /// Failed attempts since the last successful one.
+  int consecutiveFailures = 0;
+  /// Times the circuit has opened.
+  std::uint64_t opened = 0;
+  /// Requests rejected without contacting the server.
+  std::uint64_t rejected = 0;
+};
+
+/**
+ * @brief Stops sending requests to a server which keeps failing.
+ *
+ * Network errors, timeouts and 5xx responses count as failures. Any other
+ * response proves the server is reachable and closes the circuit.
+ */
+class CircuitBreaker {
+ public:
+  explicit CircuitBreaker(const CircuitBreakerOptions& options);
+
+  /**
+   * @brief Returns true if a request may be sent now. Every allowed request
+   *        must be followed by one of the record calls.
+   */
+  bool allow();
+  void recordSuccess();
+  void recordFailure();
+  /**
+   * @brief Records an attempt which was cancelled before it had a result.
+   */
+  void recordAbandoned();
+
+  CircuitBreakerStats stats() const;
+
+ private:
+  CircuitBreakerOptions m_options;
+  mutable std::mutex m_mutex;
+  CircuitState m_state = CircuitState::Closed;
+  int m_consecutiveFailures = 0;
+  bool m_probeInFlight = false;
+  std::chrono::steady_clock::time_point m_openedAt;
+  std::uint64_t m_opened = 0;
+  std::uint64_t m_rejected = 0;
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_CIRCUIT_BREAKER_H
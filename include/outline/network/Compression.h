@@ -0,0 +1,103 @@
+#ifndef OUTLINE_COMPRESSION_H
+#define OUTLINE_COMPRESSION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Settings of compressed responses.
+ */
+struct CompressionOptions {
+  /// Asks for gzip or deflate encoded GET responses. Off by default, since
+  /// inflating costs CPU which a fast link does not pay back.
+  bool enabled = false;
+};
+
+/**
+ * @brief Snapshot of the compressed responses of a client.
+ */
+struct CompressionStats {
+  /// Responses which arrived gzip or deflate encoded.
+  std::uint64_t compressedResponses = 0;
+  /// Body bytes of those responses as received.
+  std::uint64_t compressedBytes = 0;
+  /// Body bytes of those responses after inflating.
+  std::uint64_t inflatedBytes = 0;
+};
+
+enum class ContentEncoding { Identity, Gzip, Deflate };
+
+/**
+ * @brief Parses a Content-Encoding header value.
+ * @throws OutlineParseException for an encoding other than identity, gzip
+ *         or deflate.
+ */
+ContentEncoding parseContentEncoding(std::string_view value);
+
+/**
+ * @brief Inflates a gzip or deflate body piece by piece as it is read.
+ *
+ * Only a fixed output buffer is held, so neither the compressed nor the
+ * inflated body has to fit in memory at once.
+ */
+class Inflater {
+ public:
+  using Sink = std::function<void(std::string_view)>;
+
+  Inflater();
+  ~Inflater();
+  Inflater(Inflater&&) noexcept;
+  Inflater& operator=(Inflater&&) noexcept;
+
+  /**
+   * @brief Inflates the next piece of the body and passes the output to
+   *        onOutput, possibly in several calls.
+   * @throws OutlineParseException if the body is corrupt.
+   */
+  void write(std::string_view input, const Sink& onOutput);
+  /**
+   * @brief Checks that the body ended where the compressed stream did.
+   * @throws OutlineParseException if the body was cut off.
+   */
+  void finish();
+
+  std::size_t compressedBytes() const;
+  std::size_t inflatedBytes() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+/**
+ * @brief Counts the compressed responses of a client.
+ */
+class ResponseCompression {
+ public:
+  explicit ResponseCompression(const CompressionOptions& options);
+
+  const CompressionOptions& options() const { return m_options; }
+  /**
+   * @brief Counts a response which was inflated completely.
+   */
+  void record(const Inflater& inflater);
+  CompressionStats stats() const;
+
+ private:
+  CompressionOptions m_options;
+  std::atomic<std::uint64_t> m_responses{0};
+  std::atomic<std::uint64_t> m_compressedBytes{0};
+  std::atomic<std::uint64_t> m_inflatedBytes{0};
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_COMPRESSION_H
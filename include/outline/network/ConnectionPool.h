@@ -0,0 +1,125 @@
+#ifndef OUTLINE_CONNECTION_POOL_H
+#define OUTLINE_CONNECTION_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <boost/beast/ssl/ssl_stream.hpp>
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Settings of the keep-alive connection pool.
+ */
+struct ConnectionPoolOptions {
+  /// Keeps connections open between requests when true.
+  bool enabled = true;
+  /// Maximum number of idle connections kept by the pool.
+  std::size_t maxIdleConnections = 8;
+  /// Idle connections older than this are closed instead of being reused.
+  std::chrono::milliseconds idleTimeout{std::chrono::seconds(30)};
+};
+
+/**
+ * @brief Snapshot of the connection pool counters.
+ */
+struct ConnectionPoolStats {
+  /// Requests served by an idle connection.
+  std::uint64_t hits = 0;
+  /// Requests that had to open a new connection.
+  std::uint64_t misses = 0;
+  /// Idle connections closed because of the idle timeout.
+  std::uint64_t evictions = 0;
+  /// Idle connections closed because the peer had closed them.
+  std::uint64_t failedHealthChecks = 0;
+  /// Connections closed on release because the pool was full.
+  std::uint64_t discarded = 0;
+  /// Connections currently idle in the pool.
+  std::size_t idle = 0;
+};
+
+/**
+ * @brief TLS connection which can be kept alive between requests.
+ */
+struct PooledConnection {
+  PooledConnection(const boost::asio::any_io_executor& executor,
+                   boost::asio::ssl::context& sslContext)
+      : stream(executor, sslContext) {}
+
+  boost::beast::ssl_stream<boost::beast::tcp_stream> stream;
+  /// host:port of the server, also the TLS session cache key.
+  std::string peer;
+  std::chrono::steady_clock::time_point lastUsed;
+};
+
+/**
+ * @brief Pool of idle keep-alive connections to a single server.
+ *
+ * A connection is owned exclusively by a request between acquire() and
+ * release(), so only the idle list is shared and guarded by a mutex. With
+ * one io_context per thread a connection is only handed to requests running
+ * on the io_context its socket is registered with.
+ */
+class ConnectionPool {
+ public:
+  explicit ConnectionPool(const ConnectionPoolOptions& options);
+
+  /**
+   * @brief Takes the most recently used healthy idle connection which runs
+   *        on the same execution context as the executor.
+   * @param executor - the executor of the request.
+   * @return the connection or nullptr if a new one has to be opened.
+   */
+  std::unique_ptr<PooledConnection> acquire(
+      const boost::asio::any_io_executor& executor);
+  /**
+   * @brief Returns the connection to the pool after a completed request.
+   * @param connection - connection whose response was read completely.
+   */
+  void release(std::unique_ptr<PooledConnection> connection);
+  /**
+   * @brief Closes the idle connections which exceeded the idle timeout.
+   * @return the number of closed connections.
+   */
+  std::size_t evictIdle();
+  /**
+   * @brief Closes all idle connections.
+   */
+  void clear();
+
+  ConnectionPoolStats stats() const;
+  const ConnectionPoolOptions& options() const { return m_options; }
+
+ private:
+  static bool sameContext(const boost::asio::any_io_executor& lhs,
+                          const boost::asio::any_io_executor& rhs);
+  static bool isHealthy(PooledConnection& connection);
+  std::size_t evictExpiredLocked(
+      std::chrono::steady_clock::time_point now,
+      std::deque<std::unique_ptr<PooledConnection>>& expired);
+
+  ConnectionPoolOptions m_options;
+  mutable std::mutex m_mutex;
+  std::deque<std::unique_ptr<PooledConnection>> m_idle;
+
+  std::atomic<std::uint64_t> m_hits{0};
+  std::atomic<std::uint64_t> m_misses{0};
+  std::atomic<std::uint64_t> m_evictions{0};
+  std::atomic<std::uint64_t> m_failedHealthChecks{0};
+  std::atomic<std::uint64_t> m_discarded{0};
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_CONNECTION_POOL_H
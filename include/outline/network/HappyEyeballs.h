@@ -0,0 +1,121 @@
+#ifndef OUTLINE_HAPPY_EYEBALLS_H
+#define OUTLINE_HAPPY_EYEBALLS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Settings of the connection race across resolved endpoints.
+ */
+struct HappyEyeballsOptions {
+  /// Tries the endpoints one after another, in resolver order, when false.
+  bool enabled = true;
+  /// Time an attempt gets before the next endpoint is tried alongside it.
+  /// RFC 8305 recommends 250 ms.
+  std::chrono::milliseconds attemptDelay{250};
+  /// The endpoint which won a race is tried first for this long.
+  std::chrono::milliseconds preferenceTtl{std::chrono::minutes(10)};
+};
+
+/**
+ * @brief Snapshot of the connection race counters.
+ */
+struct HappyEyeballsStats {
+  /// Connections established.
+  std::uint64_t connects = 0;
+  /// Connections won by another endpoint than the one tried first.
+  std::uint64_t fallbacks = 0;
+  /// Connections which started with the remembered winner of the host.
+  std::uint64_t remembered = 0;
+  /// Connects which failed on every endpoint or timed out.
+  std::uint64_t failures = 0;
+  /// TCP connection attempts started, and those which failed.
+  std::uint64_t attempts = 0;
+  std::uint64_t failedAttempts = 0;
+};
+
+/**
+ * @brief Connects to the first endpoint of a host which answers, racing
+ *        staggered attempts as described in RFC 8305.
+ *
+ * The endpoints are ordered alternating between IPv6 and IPv4, starting
+ * with the family the resolver listed first. The first attempt starts at
+ * once and every attemptDelay, or as soon as all running attempts failed,
+ * the next endpoint joins the race. The first connected socket wins and the
+ * other attempts are closed, so a host with an unreachable IPv6 address
+ * costs one attemptDelay instead of a TCP timeout.
+ *
+ * The winner is remembered per host and tried first, with its family, by
+ * the following connects, until preferenceTtl passes or a connect fails.
+ */
+class HappyEyeballs {
+ public:
+  using Results = boost::asio::ip::tcp::resolver::results_type;
+
+  explicit HappyEyeballs(const HappyEyeballsOptions& options);
+
+  /**
+   * @brief Returns a socket connected to one of the endpoints.
+   * @param key - the host:port the endpoints belong to.
+   * @param timeout - fails a connect which takes longer with
+   *        boost::asio::error::timed_out. Zero waits indefinitely.
+   * @throws boost::system::system_error with the error of the last failed
+   *         attempt if no endpoint accepted the connection.
+   */
+  boost::asio::awaitable<boost::asio::ip::tcp::socket> connect(
+      std::string key, Results results,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
+  /**
+   * @brief Returns the endpoints in the order they are tried.
+   */
+  std::vector<boost::asio::ip::tcp::endpoint> order(
+      const std::string& key, const Results& results) const;
+  /**
+   * @brief Drops the remembered winner of the host.
+   */
+  void forget(const std::string& key);
+
+  HappyEyeballsStats stats() const;
+
+ private:
+  struct Preference {
+    boost::asio::ip::tcp::endpoint endpoint;
+    std::chrono::steady_clock::time_point wonAt;
+  };
+
+  /**
+   * @brief Returns the remembered winner of the host unless it expired.
+   */
+  std::optional<boost::asio::ip::tcp::endpoint> preferred(
+      const std::string& key) const;
+  void remember(const std::string& key,
+                const boost::asio::ip::tcp::endpoint& endpoint);
+
+  HappyEyeballsOptions m_options;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, Preference> m_preferences;
+
+  std::atomic<std::uint64_t> m_connects{0};
+  std::atomic<std::uint64_t> m_fallbacks{0};
+  std::atomic<std::uint64_t> m_remembered{0};
+  std::atomic<std::uint64_t> m_failures{0};
+  std::atomic<std::uint64_t> m_attempts{0};
+  std::atomic<std::uint64_t> m_failedAttempts{0};
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_HAPPY_EYEBALLS_H
@@ -0,0 +1,82 @@
+#ifndef OUTLINE_IO_RUNTIME_H
+#define OUTLINE_IO_RUNTIME_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+namespace outline {
+namespace network {
+
+enum class IoRuntimeMode {
+  /// One io_context run by all threads. Every request runs on its own strand.
+  ThreadPool,
+  /// One io_context per thread. Requests are assigned round-robin.
+  ContextPerThread,
+};
+
+/**
+ * @brief Settings of the I/O threads which run the requests.
+ */
+struct IoRuntimeOptions {
+  std::size_t threads = 1;
+  IoRuntimeMode mode = IoRuntimeMode::ThreadPool;
+};
+
+/**
+ * @brief Owns the io_contexts and the threads running them.
+ */
+class IoRuntime {
+ public:
+  explicit IoRuntime(const IoRuntimeOptions& options);
+  /**
+   * @brief Destructor. Stops the io_contexts and joins the threads.
+   */
+  ~IoRuntime();
+
+  IoRuntime(const IoRuntime&) = delete;
+  IoRuntime& operator=(const IoRuntime&) = delete;
+
+  /**
+   * @brief Returns the executor for a new request.
+   *
+   * In thread pool mode this is a new strand, so the request and the
+   * connection it uses never run on two threads at once. In context per
+   * thread mode the single threaded io_context already guarantees that.
+   */
+  boost::asio::any_io_executor nextExecutor();
+  /**
+   * @brief Stops the io_contexts and joins the threads. Idempotent.
+   */
+  void stop();
+  /**
+   * @brief Stops the threads and destroys the io_contexts together with the
+   *        handlers and coroutines which have not run yet. Only the
+   *        destructor may be called afterwards.
+   */
+  void shutdown();
+
+  std::size_t threadCount() const { return m_threads.size(); }
+  IoRuntimeMode mode() const { return m_mode; }
+
+ private:
+  using WorkGuard =
+      boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+  IoRuntimeMode m_mode;
+  std::vector<std::unique_ptr<boost::asio::io_context>> m_contexts;
+  std::vector<WorkGuard> m_workGuards;
+  std::vector<std::thread> m_threads;
+  std::atomic<std::size_t> m_next{0};
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_IO_RUNTIME_H
@@ -0,0 +1,92 @@
+#ifndef OUTLINE_RATE_LIMITER_H
+#define OUTLINE_RATE_LIMITER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <boost/asio/awaitable.hpp>
+
+#include "outline/metrics/LatencyHistogram.h"
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Settings of the token bucket which limits the request rate to a
+ *        server.
+ */
+struct RateLimiterOptions {
+  /// Sends requests as fast as they are made when false.
+  bool enabled = false;
+  /// Sustained rate of requests.
+  double requestsPerSecond = 20;
+  /// Requests which may be sent at once after the client was idle.
+  std::size_t burst = 10;
+  /// Requests which may wait for a token at the same time. Further requests
+  /// fail with OutlineRateLimitedException. 0 means no limit.
+  std::size_t maxQueueDepth = 0;
+};
+
+/**
+ * @brief Snapshot of the rate limiter counters.
+ */
+struct RateLimiterStats {
+  /// Requests which got a token, with or without waiting.
+  std::uint64_t acquired = 0;
+  /// Requests which had to wait for their token.
+  std::uint64_t delayed = 0;
+  /// Requests which failed because the queue was full.
+  std::uint64_t rejected = 0;
+  /// Requests waiting for a token now, and the most there ever were.
+  std::size_t queueDepth = 0;
+  std::size_t maxQueueDepth = 0;
+  /// Time the delayed requests waited.
+  metrics::HistogramSnapshot waits;
+};
+
+/**
+ * @brief Token bucket shared by the requests of a client.
+ *
+ * A request which finds the bucket empty reserves the next free token and
+ * waits on a timer until it is due, so waiting requests hold no thread and
+ * are served in arrival order. Every attempt of a retried request takes a
+ * token, since each one reaches the server.
+ */
+class RateLimiter {
+ public:
+  explicit RateLimiter(const RateLimiterOptions& options);
+
+  /**
+   * @brief Returns once the request may be sent.
+   * @throws OutlineRateLimitedException if maxQueueDepth requests are
+   *         already waiting.
+   */
+  boost::asio::awaitable<void> acquire();
+
+  RateLimiterStats stats() const;
+
+ private:
+  /**
+   * @brief Adds the tokens earned since the last refill.
+   */
+  void refillLocked(std::chrono::steady_clock::time_point now);
+
+  RateLimiterOptions m_options;
+  mutable std::mutex m_mutex;
+  /// Negative while waiting requests have reserved tokens ahead.
+  double m_tokens;
+  std::chrono::steady_clock::time_point m_refilledAt;
+  std::size_t m_waiting = 0;
+  std::size_t m_maxWaiting = 0;
+  std::uint64_t m_acquired = 0;
+  std::uint64_t m_delayed = 0;
+  std::uint64_t m_rejected = 0;
+  metrics::LatencyHistogram m_waits;
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_RATE_LIMITER_H
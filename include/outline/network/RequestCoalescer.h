@@ -0,0 +1,107 @@
+#ifndef OUTLINE_REQUEST_COALESCER_H
+#define OUTLINE_REQUEST_COALESCER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/any_completion_handler.hpp>
+#include <boost/asio/awaitable.hpp>
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Settings of the coalescing of identical GET requests.
+ */
+struct CoalescingOptions {
+  /// Sends every GET separately when false.
+  bool enabled = true;
+};
+
+/**
+ * @brief Snapshot of the coalescing counters.
+ */
+struct CoalescingStats {
+  /// Requests which were actually sent.
+  std::uint64_t sent = 0;
+  /// Calls which were served by a request another call had already sent.
+  std::uint64_t coalesced = 0;
+  /// Requests in flight now.
+  std::size_t inFlight = 0;
+};
+
+/**
+ * @brief Shares one in-flight request among concurrent calls with the same
+ *        key ("singleflight").
+ *
+ * The first call starts the request on its own, so a caller which gives up,
+ * e.g. after coWithTimeout, cancels only its own wait. A call arriving
+ * after invalidate() never joins a request started before it, so a read
+ * made after a write cannot be answered by a read sent before the write.
+ */
+class RequestCoalescer {
+ public:
+  using Response = std::pair<int, std::string>;
+  /// Starts the request when no identical one is in flight. It is kept
+  /// alive until the request completes.
+  using Fetch = std::function<boost::asio::awaitable<Response>()>;
+
+  explicit RequestCoalescer(const CoalescingOptions& options);
+
+  /**
+   * @brief Returns the response of the request in flight for the key, or
+   *        starts one with fetch().
+   */
+  boost::asio::awaitable<Response> run(std::string key, Fetch fetch);
+  /**
+   * @brief Makes later calls start new requests instead of joining the ones
+   *        in flight.
+   */
+  void invalidate();
+
+  CoalescingStats stats() const;
+
+ private:
+  using Handler =
+      boost::asio::any_completion_handler<void(std::exception_ptr, Response)>;
+
+  /**
+   * @brief Callers waiting for one request.
+   */
+  struct Flight {
+    std::vector<std::pair<std::uint64_t, Handler>> waiters;
+    std::uint64_t nextWaiter = 0;
+  };
+
+  void complete(const std::string& key, const std::shared_ptr<Flight>& flight,
+                std::exception_ptr error, Response response);
+  /**
+   * @brief Removes a waiter whose caller cancelled and fails its wait.
+   */
+  void cancel(const std::shared_ptr<Flight>& flight, std::uint64_t waiter);
+  /**
+   * @brief Completes the wait on the caller's executor.
+   */
+  static void deliver(Handler handler, std::exception_ptr error,
+                      Response response);
+
+  CoalescingOptions m_options;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, std::shared_ptr<Flight>> m_flights;
+  std::size_t m_inFlight = 0;
+  std::uint64_t m_sent = 0;
+  std::uint64_t m_coalesced = 0;
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_REQUEST_COALESCER_H
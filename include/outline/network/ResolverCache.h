@@ -0,0 +1,106 @@
+#ifndef OUTLINE_RESOLVER_CACHE_H
+#define OUTLINE_RESOLVER_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Settings of the DNS resolution cache.
+ */
+struct ResolverCacheOptions {
+  /// Resolves every request again when false.
+  bool enabled = true;
+  /// Resolved addresses are fresh for this long.
+  std::chrono::milliseconds ttl{std::chrono::seconds(60)};
+  /// An expired entry is still served for this long while it is refreshed
+  /// in the background. Older entries are resolved on the request path.
+  std::chrono::milliseconds maxStale{std::chrono::minutes(10)};
+};
+
+/**
+ * @brief Snapshot of the DNS resolution cache counters.
+ */
+struct ResolverCacheStats {
+  /// Lookups served by a fresh entry.
+  std::uint64_t hits = 0;
+  /// Lookups served by an expired entry while it was refreshed.
+  std::uint64_t staleHits = 0;
+  /// Lookups which had to wait for the resolver.
+  std::uint64_t misses = 0;
+  /// Completed background and explicit refreshes.
+  std::uint64_t refreshes = 0;
+  /// Background refreshes which failed. The old entry is kept.
+  std::uint64_t refreshFailures = 0;
+};
+
+/**
+ * @brief Caches resolved endpoints per host:port.
+ */
+class ResolverCache {
+ public:
+  using Results = boost::asio::ip::tcp::resolver::results_type;
+
+  explicit ResolverCache(const ResolverCacheOptions& options);
+
+  /**
+   * @brief Returns the endpoints of the host, resolving them if necessary.
+   * @param host - the host name or address.
+   * @param port - the port or service name.
+   * @param timeout - fails a lookup which takes longer with
+   *        boost::asio::error::timed_out. Zero waits indefinitely.
+   */
+  boost::asio::awaitable<Results> resolve(
+      std::string host, std::string port,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
+  /**
+   * @brief Resolves the host now and replaces the cached entry.
+   */
+  boost::asio::awaitable<Results> refresh(
+      std::string host, std::string port,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
+  /**
+   * @brief Drops the entry, e.g. after none of its endpoints accepted a
+   *        connection.
+   */
+  void invalidate(const std::string& host, const std::string& port);
+
+  ResolverCacheStats stats() const;
+
+ private:
+  struct Entry {
+    Results results;
+    std::chrono::steady_clock::time_point resolvedAt;
+    bool refreshing = false;
+  };
+
+  static std::string makeKey(const std::string& host, const std::string& port);
+  boost::asio::awaitable<void> refreshInBackground(
+      std::string host, std::string port, std::chrono::milliseconds timeout);
+  static boost::asio::awaitable<Results> lookup(
+      std::string host, std::string port, std::chrono::milliseconds timeout);
+
+  ResolverCacheOptions m_options;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, Entry> m_entries;
+
+  std::atomic<std::uint64_t> m_hits{0};
+  std::atomic<std::uint64_t> m_staleHits{0};
+  std::atomic<std::uint64_t> m_misses{0};
+  std::atomic<std::uint64_t> m_refreshes{0};
+  std::atomic<std::uint64_t> m_refreshFailures{0};
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_RESOLVER_CACHE_H
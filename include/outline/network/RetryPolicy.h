@@ -0,0 +1,75 @@
+#ifndef OUTLINE_RETRY_POLICY_H
+#define OUTLINE_RETRY_POLICY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Settings of the retries of failed idempotent requests.
+ */
+struct RetryOptions {
+  /// Attempts per request including the first one. 1 disables retries.
+  int maxAttempts = 3;
+  /// Upper bound of the delay before the first retry.
+  std::chrono::milliseconds initialBackoff{100};
+  /// Upper bound of the delay before any retry.
+  std::chrono::milliseconds maxBackoff{std::chrono::seconds(2)};
+  /// Retries responses with a 5xx status, not only network errors.
+  bool retryServerErrors = true;
+};
+
+/**
+ * @brief Snapshot of the retry counters.
+ */
+struct RetryStats {
+  /// Attempts made after a failed one.
+  std::uint64_t retries = 0;
+  /// Requests which still failed after the last attempt.
+  std::uint64_t exhausted = 0;
+};
+
+/**
+ * @brief Decides whether and when a failed request is attempted again.
+ *
+ * The delay before retry n is drawn uniformly from
+ * [0, min(maxBackoff, initialBackoff * 2^(n-1))], so clients which failed
+ * together do not retry together.
+ */
+class RetryPolicy {
+ public:
+  explicit RetryPolicy(const RetryOptions& options);
+
+  /**
+   * @brief Returns true if another attempt may follow the failed one.
+   * @param attempt - the number of the failed attempt, starting at 1.
+   */
+  bool shouldRetry(int attempt) const {
+    return attempt < m_options.maxAttempts;
+  }
+  /**
+   * @brief Returns the jittered delay before the retry after the attempt.
+   */
+  std::chrono::milliseconds backoff(int attempt) const;
+
+  void recordRetry() { m_retries.fetch_add(1, std::memory_order_relaxed); }
+  void recordExhausted() {
+    m_exhausted.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  const RetryOptions& options() const { return m_options; }
+  RetryStats stats() const;
+
+ private:
+  RetryOptions m_options;
+  std::atomic<std::uint64_t> m_retries{0};
+  std::atomic<std::uint64_t> m_exhausted{0};
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_RETRY_POLICY_H
@@ -0,0 +1,110 @@
+#ifndef OUTLINE_TLS_SESSION_CACHE_H
+#define OUTLINE_TLS_SESSION_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/asio/ssl.hpp>
+
+namespace outline {
+namespace network {
+
+/**
+ * @brief Describes a completed TLS handshake.
+ */
+struct TlsHandshakeEvent {
+  /// host:port of the server.
+  std::string peer;
+  /// True if a cached session was resumed, false for a full handshake.
+  bool resumed = false;
+  std::chrono::nanoseconds duration{0};
+};
+
+/**
+ * @brief Settings of TLS session resumption.
+ */
+struct TlsSessionOptions {
+  /// Keeps session tickets/IDs per host:port and offers them on reconnect.
+  bool resumption = true;
+  /// Optional observer called on the I/O thread after every handshake.
+  std::function<void(const TlsHandshakeEvent&)> onHandshake;
+};
+
+/**
+ * @brief Snapshot of the TLS handshake counters.
+ */
+struct TlsHandshakeStats {
+  std::uint64_t fullHandshakes = 0;
+  std::uint64_t resumedHandshakes = 0;
+  /// Total time spent in full handshakes.
+  std::chrono::nanoseconds fullHandshakeTime{0};
+  /// Total time spent in resumed handshakes.
+  std::chrono::nanoseconds resumedHandshakeTime{0};
+};
+
+/**
+ * @brief Client side cache of TLS sessions keyed by host:port.
+ *
+ * New sessions are collected by a callback installed on the ssl::context,
+ * which also covers TLS 1.3 tickets sent by the server after the handshake.
+ */
+class TlsSessionCache {
+ public:
+  explicit TlsSessionCache(TlsSessionOptions options);
+  ~TlsSessionCache();
+
+  TlsSessionCache(const TlsSessionCache&) = delete;
+  TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+  /**
+   * @brief Enables the client session cache on the context.
+   * @param context - the context used for all connections of the client.
+   */
+  void attach(boost::asio::ssl::context& context);
+  /**
+   * @brief Offers the cached session for the peer before the handshake.
+   * @param ssl - the connection which is about to handshake.
+   * @param peer - host:port key. Must outlive the connection.
+   */
+  void prepare(SSL* ssl, const std::string& peer);
+  /**
+   * @brief Records the result of a successful handshake.
+   */
+  void recordHandshake(SSL* ssl, const std::string& peer,
+                       std::chrono::nanoseconds duration);
+  /**
+   * @brief Forgets the session of the peer, e.g. after a failed handshake.
+   */
+  void erase(const std::string& peer);
+
+  TlsHandshakeStats stats() const;
+
+ private:
+  struct SessionDeleter {
+    void operator()(SSL_SESSION* session) const { SSL_SESSION_free(session); }
+  };
+  using SessionPtr = std::unique_ptr<SSL_SESSION, SessionDeleter>;
+
+  static int onNewSession(SSL* ssl, SSL_SESSION* session);
+  void store(const std::string& peer, SSL_SESSION* session);
+
+  TlsSessionOptions m_options;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, SessionPtr> m_sessions;
+
+  std::atomic<std::uint64_t> m_fullHandshakes{0};
+  std::atomic<std::uint64_t> m_resumedHandshakes{0};
+  std::atomic<std::int64_t> m_fullHandshakeNs{0};
+  std::atomic<std::int64_t> m_resumedHandshakeNs{0};
+};
+
+}  // namespace network
+}  // namespace outline
+
+#endif  // OUTLINE_TLS_SESSION_CACHE_H
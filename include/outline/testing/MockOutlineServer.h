@@ -0,0 +1,155 @@
+#ifndef OUTLINE_TESTING_MOCK_OUTLINE_SERVER_H
+#define OUTLINE_TESTING_MOCK_OUTLINE_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/json/object.hpp>
+
+#include "outline/models/AccessKey.h"
+
+namespace outline {
+namespace testing {
+
+/**
+ * @brief Settings of MockOutlineServer.
+ */
+struct MockServerOptions {
+  /// Port on 127.0.0.1. 0 picks a free one, see MockOutlineServer::port().
+  unsigned short port = 0;
+  /// Threads serving connections.
+  std::size_t threads = 1;
+  /// Secret path prefix of the management API.
+  std::string secret = "mock";
+  /// Delay before every response, plus a random extra of up to
+  /// latencyJitter.
+  std::chrono::milliseconds latency{0};
+  std::chrono::milliseconds latencyJitter{0};
+  /// Fraction of requests answered with errorStatus instead.
+  double errorRate = 0;
+  int errorStatus = 500;
+  /// Fraction of requests whose connection is closed without an answer.
+  double dropRate = 0;
+  /// Number of keys which exist when the server starts.
+  std::size_t initialKeys = 0;
+  /// Compresses response bodies with gzip or deflate when the request
+  /// accepts them.
+  bool compression = false;
+  /// Writes responses at no more than this many bytes per second, to
+  /// imitate a slow link. 0 means unlimited.
+  std::size_t bytesPerSecond = 0;
+};
+
+/**
+ * @brief Counters of a MockOutlineServer.
+ */
+struct MockServerStats {
+  std::uint64_t connections = 0;
+  std::uint64_t requests = 0;
+  /// Requests answered with MockServerOptions::errorStatus.
+  std::uint64_t injectedErrors = 0;
+  /// Connections closed instead of answering.
+  std::uint64_t droppedConnections = 0;
+  /// Responses sent with a compressed body.
+  std::uint64_t compressedResponses = 0;
+};
+
+/**
+ * @brief In-process Outline management API over HTTPS for tests and load
+ *        tests which must not depend on a real server.
+ *
+ * Keys and settings live in memory. The certificate is self-signed and
+ * generated at start-up, so clients must not verify it, which OutlineClient
+ * does not. Listens on 127.0.0.1 until stopped or destroyed:
+ * @code
+ * testing::MockOutlineServer server({.initialKeys = 100});
+ * auto client = OutlineClient::create(server.apiUrl(), "", 5);
+ * @endcode
+ */
+class MockOutlineServer {
+ public:
+  explicit MockOutlineServer(const MockServerOptions& options = {});
+  ~MockOutlineServer();
+
+  MockOutlineServer(const MockOutlineServer&) = delete;
+  MockOutlineServer& operator=(const MockOutlineServer&) = delete;
+
+  /**
+   * @brief Returns the URL to pass to OutlineClient.
+   */
+  std::string apiUrl() const;
+  unsigned short port() const { return m_port; }
+  std::size_t keyCount() const;
+  MockServerStats stats() const;
+
+  /**
+   * @brief Closes the listening socket and every connection.
+   */
+  void stop();
+
+ private:
+  using Request =
+      boost::beast::http::request<boost::beast::http::string_body>;
+  using Response =
+      boost::beast::http::response<boost::beast::http::string_body>;
+
+  boost::asio::awaitable<void> accept();
+  boost::asio::awaitable<void> serve(boost::asio::ip::tcp::socket socket);
+  /// Runs the request against the in-memory state.
+  Response handle(const Request& request);
+  /// Handles /access-keys/{id} and its sub-resources; `action` is the rest
+  /// of the path, such as "/name".
+  Response handleAccessKey(const Request& request,
+                           const boost::json::object& body,
+                           const std::string& id, std::string_view action);
+  AccessKey makeKey(std::string id);
+  bool chance(double probability) const;
+  std::chrono::milliseconds responseDelay() const;
+
+  MockServerOptions m_options;
+  boost::asio::ssl::context m_sslContext;
+
+  mutable std::mutex m_mutex;
+  std::map<std::uint64_t, AccessKey> m_keys;
+  std::unordered_map<std::string, std::uint64_t> m_bytesTransferred;
+  std::uint64_t m_nextId = 0;
+  std::string m_serverName = "Mock Outline Server";
+  std::string m_hostname = "127.0.0.1";
+  int m_portForNewAccessKeys = 12345;
+  bool m_metricsEnabled = true;
+  std::optional<std::int64_t> m_accessKeyDataLimit;
+
+  std::atomic<std::uint64_t> m_connections{0};
+  std::atomic<std::uint64_t> m_requests{0};
+  std::atomic<std::uint64_t> m_injectedErrors{0};
+  std::atomic<std::uint64_t> m_droppedConnections{0};
+  std::atomic<std::uint64_t> m_compressedResponses{0};
+
+  // Destroyed first, so unfinished sessions are torn down while the state
+  // above still exists.
+  boost::asio::io_context m_context;
+  boost::asio::ip::tcp::acceptor m_acceptor;
+  unsigned short m_port = 0;
+  std::vector<std::thread> m_threads;
+};
+
+}  // namespace testing
+}  // namespace outline
+
+#endif  // OUTLINE_TESTING_MOCK_OUTLINE_SERVER_H
@@ -0,0 +1,71 @@
+#ifndef OUTLINE_JSON_UTILS_H
+#define OUTLINE_JSON_UTILS_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <boost/json.hpp>
+
+#include "outline/exceptions/OutlineExceptions.h"
+
+namespace outline {
+namespace utils {
+
+/**
+ * @brief Parses a response body.
+ *
+ * @param body The JSON text.
+ * @param what Name of the document used in the error message.
+ * @param storage Storage of the parsed value, e.g. a request arena.
+ * @return The parsed value.
+ *
+ * @throws OutlineParseException if the body is not valid JSON.
+ */
+boost::json::value parseJson(std::string_view body, std::string_view what,
+                             boost::json::storage_ptr storage = {});
+
+/**
+ * @brief Parses a response body and converts it to a model with value_to.
+ *
+ * @throws OutlineParseException if the body is not valid JSON or does not
+ *         match the model.
+ */
+template <typename T>
+T parseJsonAs(std::string_view body, std::string_view what,
+              boost::json::storage_ptr storage = {}) {
+  boost::json::value jv = parseJson(body, what, std::move(storage));
+  try {
+    return boost::json::value_to<T>(jv);
+  } catch (const OutlineException&) {
+    throw;
+  } catch (const std::exception& e) {
+    throw OutlineParseException("Invalid JSON structure for " +
+                                std::string(what) + ": " + e.what());
+  }
+}
+
+/**
+ * @brief Reads the field into out if it is present and not null.
+ */
+template <typename T>
+void readField(const boost::json::object& obj, std::string_view key, T& out) {
+  const boost::json::value* field = obj.if_contains(key);
+  if (field != nullptr && !field->is_null()) {
+    out = boost::json::value_to<T>(*field);
+  }
+}
+
+template <typename T>
+void readField(const boost::json::object& obj, std::string_view key,
+               std::optional<T>& out) {
+  const boost::json::value* field = obj.if_contains(key);
+  if (field != nullptr && !field->is_null()) {
+    out = boost::json::value_to<T>(*field);
+  }
+}
+
+}  // namespace utils
+}  // namespace outline
+
+#endif  // OUTLINE_JSON_UTILS_H
@@ -0,0 +1,105 @@
+#ifndef OUTLINE_JSON_WRITER_H
+#define OUTLINE_JSON_WRITER_H
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace outline {
+namespace utils {
+
+/**
+ * @brief Writes JSON objects directly into a string, without building a
+ *        boost::json::value first.
+ *
+ * Meant for the small request bodies of the mutation endpoints. Writing
+ * into a string with enough capacity allocates nothing:
+ * @code
+ * JsonWriter writer(body);
+ * writer.beginObject().field("name", name).endObject();
+ * // {"name":"..."}
+ * @endcode
+ * The caller is responsible for a well-formed sequence of calls.
+ */
+class JsonWriter {
+ public:
+  /**
+   * @brief Appends to `out`, which is not cleared.
+   */
+  explicit JsonWriter(std::string& out) : m_out(out) {}
+
+  JsonWriter& beginObject() {
+    separate();
+    m_out.push_back('{');
+    m_needsComma = false;
+    return *this;
+  }
+  JsonWriter& endObject() {
+    m_out.push_back('}');
+    m_needsComma = true;
+    return *this;
+  }
+  JsonWriter& key(std::string_view name) {
+    separate();
+    writeString(name);
+    m_out.push_back(':');
+    m_needsComma = false;
+    return *this;
+  }
+
+  JsonWriter& value(std::string_view text) {
+    separate();
+    writeString(text);
+    m_needsComma = true;
+    return *this;
+  }
+  JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+  JsonWriter& value(bool flag) {
+    separate();
+    m_out.append(flag ? "true" : "false");
+    m_needsComma = true;
+    return *this;
+  }
+  template <typename Integer,
+            std::enable_if_t<std::is_integral_v<Integer> &&
+                                 !std::is_same_v<Integer, bool>,
+                             int> = 0>
+  JsonWriter& value(Integer number) {
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    m_out.append(digits, result.ptr);
+    m_needsComma = true;
+    return *this;
+  }
+
+  /**
+   * @brief Writes "name":value.
+   */
+  template <typename T>
+  JsonWriter& field(std::string_view name, const T& fieldValue) {
+    return key(name).value(fieldValue);
+  }
+
+  const std::string& str() const { return m_out; }
+
+ private:
+  void separate() {
+    if (m_needsComma) {
+      m_out.push_back(',');
+    }
+  }
+  /**
+   * @brief Writes the text as a quoted JSON string. UTF-8 is copied as is.
+   */
+  void writeString(std::string_view text);
+
+  std::string& m_out;
+  bool m_needsComma = false;
+};
+
+}  // namespace utils
+}  // namespace outline
+
+#endif  // OUTLINE_JSON_WRITER_H
@@ -0,0 +1,156 @@
+#ifndef OUTLINE_REQUEST_ARENA_H
+#define OUTLINE_REQUEST_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/json/memory_resource.hpp>
+#include <boost/json/monotonic_resource.hpp>
+#include <boost/json/storage_ptr.hpp>
+#include <boost/json/value.hpp>
+
+#include "outline/utils/JsonWriter.h"
+
+namespace outline {
+namespace utils {
+
+/**
+ * @brief Settings of the per-request arenas.
+ */
+struct ArenaOptions {
+  /// Size of the buffer owned by each arena. Requests which need more
+  /// memory fall back to the heap for the rest of the request.
+  std::size_t bufferSize = 64 * 1024;
+  /// Number of idle arenas kept for reuse.
+  std::size_t maxIdleArenas = 64;
+};
+
+/**
+ * @brief Snapshot of the arena counters.
+ */
+struct ArenaStats {
+  /// Arenas handed out to requests.
+  std::uint64_t leases = 0;
+  /// Arenas allocated because no idle one was available.
+  std::uint64_t arenasCreated = 0;
+  /// Heap allocations made after an arena buffer was exhausted.
+  std::uint64_t overflowAllocations = 0;
+  std::uint64_t overflowBytes = 0;
+};
+
+/**
+ * @brief Memory resource which forwards to the heap and counts allocations.
+ */
+class CountingResource : public boost::json::memory_resource {
+ public:
+  std::uint64_t allocations() const {
+    return m_allocations.load(std::memory_order_relaxed);
+  }
+  std::uint64_t bytes() const {
+    return m_bytes.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override;
+  bool do_is_equal(
+      const boost::json::memory_resource& other) const noexcept override;
+
+  std::atomic<std::uint64_t> m_allocations{0};
+  std::atomic<std::uint64_t> m_bytes{0};
+};
+
+/**
+ * @brief Memory of a single in-flight request: a monotonic resource over a
+ *        recycled buffer for JSON values and a recycled string for the
+ *        serialized request body.
+ */
+class RequestArena {
+ public:
+  RequestArena(std::size_t bufferSize, CountingResource& upstream);
+
+  RequestArena(const RequestArena&) = delete;
+  RequestArena& operator=(const RequestArena&) = delete;
+
+  /**
+   * @brief Returns the storage for values which live until the request ends.
+   */
+  boost::json::storage_ptr storage() { return m_storage; }
+  /**
+   * @brief Serializes the value into the recycled body buffer.
+   *
+   * The client writes its bodies with writeBody(); this is kept only so that
+   * bench_micro and the tests can compare against the boost::json::value
+   * path.
+   * @return the body, valid until the next call or the end of the request.
+   */
+  const std::string& serialize(const boost::json::value& value);
+  /**
+   * @brief Starts a new body in the recycled body buffer, which replaces
+   *        the previous one.
+   * @return a writer whose str() is valid until the next body or the end of
+   *         the request.
+   */
+  JsonWriter writeBody();
+  /**
+   * @brief Frees everything allocated during the request.
+   */
+  void reset();
+
+ private:
+  std::unique_ptr<unsigned char[]> m_buffer;
+  boost::json::monotonic_resource m_resource;
+  boost::json::storage_ptr m_storage;
+  std::string m_body;
+};
+
+class ArenaPool;
+
+/**
+ * @brief Returns the arena to its pool when destroyed.
+ */
+struct ArenaReleaser {
+  ArenaPool* pool = nullptr;
+  void operator()(RequestArena* arena) const;
+};
+
+using ArenaLease = std::unique_ptr<RequestArena, ArenaReleaser>;
+
+/**
+ * @brief Recycles arenas between requests.
+ */
+class ArenaPool {
+ public:
+  explicit ArenaPool(const ArenaOptions& options);
+  ~ArenaPool();
+
+  /**
+   * @brief Takes an idle arena or creates one.
+   */
+  ArenaLease acquire();
+
+  ArenaStats stats() const;
+
+ private:
+  friend struct ArenaReleaser;
+  void release(RequestArena* arena);
+
+  ArenaOptions m_options;
+  CountingResource m_upstream;
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<RequestArena>> m_idle;
+
+  std::atomic<std::uint64_t> m_leases{0};
+  std::atomic<std::uint64_t> m_arenasCreated{0};
+};
+
+}  // namespace utils
+}  // namespace outline
+
+#endif  // OUTLINE_REQUEST_ARENA_H
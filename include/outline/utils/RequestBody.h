@@ -0,0 +1,41 @@
+#ifndef OUTLINE_REQUEST_BODY_H
+#define OUTLINE_REQUEST_BODY_H
+
+#include <string>
+
+#include "outline/utils/JsonWriter.h"
+#include "outline/utils/RequestArena.h"
+
+namespace outline {
+namespace utils {
+
+/**
+ * @brief Builds the body of the create and update access key requests in
+ *        the arena.
+ *
+ * @param params CreateAccessKeyParams or UpdateAccessKeyParams.
+ * @return The body, valid until the arena is reused.
+ */
+template <typename Params>
+const std::string& serializeAccessKeyParams(const Params& params,
+                                            RequestArena& arena) {
+  JsonWriter writer = arena.writeBody();
+  writer.beginObject();
+  if (params.name)
+    writer.field("name", params.name.value());
+  if (params.password)
+    writer.field("password", params.password.value());
+  if (params.method)
+    writer.field("method", params.method.value());
+  if (params.data_limit_bytes) {
+    writer.key("limit").beginObject();
+    writer.field("bytes", params.data_limit_bytes.value()).endObject();
+  }
+  writer.endObject();
+  return writer.str();
+}
+
+}  // namespace utils
+}  // namespace outline
+
+#endif  // OUTLINE_REQUEST_BODY_H
@@ -1,36 +1,60 @@
-#include <boost/algorithm/string/replace.hpp>
-#include <boost/url.hpp>
-#include <iostream>
-#include <map>
-#include <stdexcept>
+#ifndef OUTLINE_URL_UTILS_H
+#define OUTLINE_URL_UTILS_H
+
+#include <array>
 #include <string>
+#include <string_view>
+
+#include "outline/constants/ApiEndpoint.h"
 
 namespace outline {
 namespace utils {
 
 /**
- * @brief Replaces named placeholders in an endpoint string with corresponding values.
- *
- * @param endpoint The endpoint string containing placeholders in the format {key}.
- * @param placeholders A map of key-value pairs where keys correspond to placeholder names.
- * @return A new string with all placeholders replaced by their corresponding values.
- *
- * @throws std::invalid_argument if any placeholders remain unresolved after replacement.
+ * @brief Appends the value percent-encoded as one path segment, so an id
+ *        cannot add segments or a query to the path.
  */
-std::string replacePlaceholders(
-    std::string_view endpoint,
-    const std::map<std::string, std::string>& placeholders);
+void appendPathSegment(std::string& target, std::string_view value);
 
 /**
- * @brief Appends a path segment to a base URL.
+ * @brief Builds the request target of a route below the base path of the
+ *        API URL.
  *
- * @param baseUrl The base boost::urls::url object.
- * @param endpoint The endpoint to append.
- * @return A new boost::urls::url object with the appended endpoint.
+ * The placeholder names are checked against the route at compile time and
+ * the target is built with a single allocation:
+ * @code
+ * auto target = utils::buildTarget<api::Endpoints::RenameAccessKey,
+ *                                  api::UrlParams::KeyId>("/secret", {"7"});
+ * // "/secret/access-keys/7/name"
+ * @endcode
  *
- * @throws std::invalid_argument if the endpoint is invalid.
+ * @param basePath Path of the API URL without a trailing '/'.
+ * @param values Values of the placeholders, in the order of `names`.
  */
-boost::urls::url appendUrl(const boost::urls::url& baseUrl,
-                           const std::string& endpoint);
+template <const api::Route& route, const std::string_view&... names>
+std::string buildTarget(
+    std::string_view basePath,
+    const std::array<std::string_view, sizeof...(names)>& values = {}) {
+  static_assert(route.hasPlaceholders(
+                    std::array<std::string_view, sizeof...(names)>{names...}),
+                "placeholder names do not match the route");
+  // Percent-encoding at most triples a value.
+  std::size_t size = basePath.size() + route.literalSize();
+  for (std::string_view value : values) {
+    size += 3 * value.size();
+  }
+  std::string target;
+  target.reserve(size);
+  target.append(basePath);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    target.append(route.literal(i));
+    appendPathSegment(target, values[i]);
+  }
+  target.append(route.literal(values.size()));
+  return target;
+}
+
 }  // namespace utils
-}  // namespace outline
\ No newline at end of file
+}  // namespace outline
+
+#endif  // OUTLINE_URL_UTILS_H
@@ -0,0 +1,201 @@
+#include "outline/AccessKeyReconciler.h"
+
+#include <boost/asio.hpp>
+
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace outline {
+
+namespace {
+
+/**
+ * @brief Adds the calls which turn the current key into the desired one.
+ * @return false if the key already matches.
+ */
+bool planUpdate(const AccessKey& current, const DesiredAccessKey& desired,
+                std::vector<AccessKeyOperation>& operations) {
+  const std::size_t before = operations.size();
+  if (current.name != desired.name) {
+    operations.push_back(AccessKeyOperation::rename(current.id, desired.name));
+  }
+  if (desired.dataLimitBytes) {
+    if (!current.dataLimit ||
+        current.dataLimit->bytes != *desired.dataLimitBytes) {
+      operations.push_back(AccessKeyOperation::addDataLimit(
+          current.id, *desired.dataLimitBytes));
+    }
+  } else if (current.dataLimit) {
+    operations.push_back(AccessKeyOperation::deleteDataLimit(current.id));
+  }
+  return operations.size() != before;
+}
+
+}  // namespace
+
+ReconcilePlan planReconcile(const std::vector<AccessKey>& current,
+                            const std::vector<DesiredAccessKey>& desired,
+                            const ReconcileOptions& options) {
+  std::unordered_map<std::string_view, std::size_t> byId;
+  // Positions of the keys with the name, consumed from the back.
+  std::unordered_map<std::string_view, std::vector<std::size_t>> byName;
+  byId.reserve(current.size());
+  byName.reserve(current.size());
+  for (std::size_t i = current.size(); i-- > 0;) {
+    byId.emplace(current[i].id, i);
+    byName[current[i].name].push_back(i);
+  }
+  std::vector<bool> matched(current.size(), false);
+
+  ReconcilePlan plan;
+  auto reconcile = [&](const DesiredAccessKey& key, std::size_t index) {
+    matched[index] = true;
+    if (!planUpdate(current[index], key, plan.operations)) {
+      ++plan.unchanged;
+    }
+  };
+  auto create = [&](const DesiredAccessKey& key) {
+    CreateAccessKeyParams params;
+    params.name = key.name;
+    params.data_limit_bytes = key.dataLimitBytes;
+    plan.operations.push_back(AccessKeyOperation::create(std::move(params)));
+    // A key wanted under an id is created under it, or the next run would
+    // not find it and create it again.
+    if (key.id) {
+      plan.operations.back().accessKeyId = *key.id;
+    }
+  };
+
+  // Keys with an id claim their match first, so matching by name cannot
+  // take a key which is wanted under another name.
+  std::vector<const DesiredAccessKey*> byNameOnly;
+  std::unordered_set<std::string_view> created;
+  for (const DesiredAccessKey& key : desired) {
+    if (!key.id) {
+      byNameOnly.push_back(&key);
+      continue;
+    }
+    auto it = byId.find(*key.id);
+    if (it == byId.end()) {
+      if (created.insert(*key.id).second) {
+        create(key);
+      }
+    } else if (!matched[it->second]) {
+      reconcile(key, it->second);
+    }
+  }
+  for (const DesiredAccessKey* key : byNameOnly) {
+    auto it = byName.find(key->name);
+    std::size_t index = current.size();
+    if (it != byName.end()) {
+      auto& positions = it->second;
+      while (!positions.empty() && matched[positions.back()]) {
+        positions.pop_back();
+      }
+      if (!positions.empty()) {
+        index = positions.back();
+        positions.pop_back();
+      }
+    }
+    if (index < current.size()) {
+      reconcile(*key, index);
+    } else {
+      create(*key);
+    }
+  }
+
+  if (options.deleteUnlisted) {
+    for (std::size_t i = 0; i < current.size(); ++i) {
+      if (!matched[i]) {
+        plan.operations.push_back(AccessKeyOperation::remove(current[i].id));
+      }
+    }
+  }
+  return plan;
+}
+
+std::string ReconcilePlan::describe() const {
+  std::ostringstream out;
+  for (const AccessKeyOperation& operation : operations) {
+    switch (operation.type) {
+      case AccessKeyOperationType::Create:
+        out << "create \"" << operation.params.name.value_or("") << "\"";
+        if (!operation.accessKeyId.empty()) {
+          out << " as " << operation.accessKeyId;
+        }
+        if (operation.params.data_limit_bytes) {
+          out << " with data limit " << *operation.params.data_limit_bytes;
+        }
+        break;
+      case AccessKeyOperationType::Rename:
+        out << "rename " << operation.accessKeyId << " to \""
+            << operation.name << "\"";
+        break;
+      case AccessKeyOperationType::AddDataLimit:
+        out << "set data limit of " << operation.accessKeyId << " to "
+            << operation.dataLimitBytes;
+        break;
+      case AccessKeyOperationType::DeleteDataLimit:
+        out << "remove data limit of " << operation.accessKeyId;
+        break;
+      case AccessKeyOperationType::Delete:
+        out << "delete " << operation.accessKeyId;
+        break;
+    }
+    out << '\n';
+  }
+  out << unchanged << " unchanged\n";
+  return out.str();
+}
+
+AccessKeyReconciler::AccessKeyReconciler(OutlineClient& client,
+                                         const ReconcileOptions& options)
+    : m_client(client), m_options(options) {}
+
+boost::asio::awaitable<ReconcilePlan> AccessKeyReconciler::coPlan(
+    std::vector<DesiredAccessKey> desired) {
+  // A cached list may be up to a TTL old, and the plan must match the
+  // server as it is.
+  std::vector<AccessKey> current =
+      co_await m_client.coGetAccessKeysTypedUncached();
+  co_return planReconcile(current, desired, m_options);
+}
+
+boost::asio::awaitable<ReconcileResult> AccessKeyReconciler::coApply(
+    std::vector<DesiredAccessKey> desired) {
+  ReconcileResult result;
+  result.plan = co_await coPlan(std::move(desired));
+  if (!result.plan.empty()) {
+    result.results = co_await m_client.coApplyAccessKeyOperations(
+        result.plan.operations, m_options.concurrency);
+  }
+  co_return result;
+}
+
+std::future<ReconcilePlan> AccessKeyReconciler::planAsync(
+    std::vector<DesiredAccessKey> desired) {
+  return boost::asio::co_spawn(m_client.executor(),
+                               coPlan(std::move(desired)),
+                               boost::asio::use_future);
+}
+
+std::future<ReconcileResult> AccessKeyReconciler::applyAsync(
+    std::vector<DesiredAccessKey> desired) {
+  return boost::asio::co_spawn(m_client.executor(),
+                               coApply(std::move(desired)),
+                               boost::asio::use_future);
+}
+
+ReconcilePlan AccessKeyReconciler::plan(
+    std::vector<DesiredAccessKey> desired) {
+  return planAsync(std::move(desired)).get();
+}
+
+ReconcileResult AccessKeyReconciler::apply(
+    std::vector<DesiredAccessKey> desired) {
+  return applyAsync(std::move(desired)).get();
+}
+
+}  // namespace outline
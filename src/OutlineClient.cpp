@@ -26,26 +26,133 @@ namespace http = boost::beast::http;
 namespace ssl = boost::asio::ssl;
 
 OutlineClient::OutlineClient(std::string_view apiUrl, std::string_view cert,
-                             int timeout)
+                             int timeout, const OutlineClientOptions& options)
     : m_cert(cert),
       m_timeout(timeout),
+      m_tlsSessionCache(options.tls),
       m_sslContext(ssl::context::sslv23_client),
-      m_workGuard(boost::asio::make_work_guard(m_ioContext)) {
+      m_arenas(options.arena),
+      m_runtime(options.sharedRuntime
+                    ? options.sharedRuntime
+                    : std::make_shared<network::IoRuntime>(options.runtime)),
+      m_ownsRuntime(!options.sharedRuntime),
+      m_connectionPool(options.connectionPool),
+      m_resolverCache(options.dns),
+      m_happyEyeballs(options.happyEyeballs),
+      m_compression(options.compression),
+      m_retryPolicy(options.retry),
+      m_circuitBreaker(options.circuitBreaker),
+      m_rateLimiter(options.rateLimit),
+      m_coalescer(options.coalescing),
+      m_accessKeyCache(options.accessKeyCache) {
   try {
     m_apiUrl = boost::urls::parse_uri(apiUrl).value();
   } catch (const std::exception& e) {
     throw OutlineParseException(std::string("Unable to parse API URL: ") +
                                 e.what());
   }
+  auto path = m_apiUrl.encoded_path();
+  m_basePath.assign(path.data(), path.size());
+  while (!m_basePath.empty() && m_basePath.back() == '/') {
+    m_basePath.pop_back();
+  }
   m_sslContext.set_verify_mode(ssl::verify_none);
   m_sslContext.set_default_verify_paths();
-  m_ioThread = std::thread([this]() { m_ioContext.run(); });
+  m_tlsSessionCache.attach(m_sslContext);
 }
 
 OutlineClient::~OutlineClient() {
-  m_workGuard.reset();
-  m_ioContext.stop();
-  if (m_ioThread.joinable())
-    m_ioThread.join();
+  if (m_ownsRuntime) {
+    m_runtime->stop();
+    // Pooled sockets are closed while their io_context still exists, then
+    // the coroutines which never finished are destroyed while the members
+    // their frames refer to still exist.
+    m_connectionPool.clear();
+    m_runtime->shutdown();
+  }
+  m_connectionPool.clear();
+}
+
+network::ConnectionPoolStats OutlineClient::connectionPoolStats() const {
+  return m_connectionPool.stats();
+}
+
+network::TlsHandshakeStats OutlineClient::tlsHandshakeStats() const {
+  return m_tlsSessionCache.stats();
+}
+
+network::ResolverCacheStats OutlineClient::resolverCacheStats() const {
+  return m_resolverCache.stats();
+}
+
+network::HappyEyeballsStats OutlineClient::happyEyeballsStats() const {
+  return m_happyEyeballs.stats();
+}
+
+network::CompressionStats OutlineClient::compressionStats() const {
+  return m_compression.stats();
+}
+
+utils::ArenaStats OutlineClient::arenaStats() const {
+  return m_arenas.stats();
+}
+
+network::RetryStats OutlineClient::retryStats() const {
+  return m_retryPolicy.stats();
+}
+
+network::CircuitBreakerStats OutlineClient::circuitBreakerStats() const {
+  return m_circuitBreaker.stats();
+}
+
+network::RateLimiterStats OutlineClient::rateLimiterStats() const {
+  return m_rateLimiter.stats();
+}
+
+network::CoalescingStats OutlineClient::coalescingStats() const {
+  return m_coalescer.stats();
+}
+
+cache::AccessKeyCacheStats OutlineClient::accessKeyCacheStats() const {
+  return m_accessKeyCache.stats();
+}
+
+metrics::ClientStats OutlineClient::stats() const {
+  metrics::ClientStats stats;
+  stats.endpoints = m_requestMetrics.snapshot();
+  stats.connectionPool = m_connectionPool.stats();
+  stats.tls = m_tlsSessionCache.stats();
+  stats.dns = m_resolverCache.stats();
+  stats.connect = m_happyEyeballs.stats();
+  stats.compression = m_compression.stats();
+  stats.retry = m_retryPolicy.stats();
+  stats.circuitBreaker = m_circuitBreaker.stats();
+  stats.rateLimiter = m_rateLimiter.stats();
+  stats.coalescing = m_coalescer.stats();
+  stats.accessKeyCache = m_accessKeyCache.stats();
+  stats.arena = m_arenas.stats();
+  return stats;
+}
+
+std::string OutlineClient::prometheusMetrics() const {
+  return metrics::toPrometheus(stats());
+}
+
+void OutlineClient::clearAccessKeyCache() {
+  m_accessKeyCache.clear();
+}
+
+void OutlineClient::closeIdleConnections() {
+  m_connectionPool.clear();
+}
+
+std::future<void> OutlineClient::refreshResolution() {
+  return boost::asio::co_spawn(
+      m_runtime->nextExecutor(),
+      [this]() -> boost::asio::awaitable<void> {
+        co_await m_resolverCache.refresh(m_apiUrl.host(),
+                                         std::string(m_apiUrl.port()));
+      },
+      boost::asio::use_future);
 }
 }  // namespace outline
@@ -1,234 +1,333 @@
 #include "outline/OutlineClient.h"
 #include "outline/constants/ApiEndpoint.h"
 #include "outline/exceptions/OutlineExceptions.h"
+#include "outline/utils/JsonUtils.h"
+#include "outline/utils/RequestBody.h"
 #include "outline/utils/UrlUtils.h"
 
 #include <boost/json.hpp>
 #include <future>
-#include <map>
 #include <string>
 
 namespace outline {
 
+namespace {
+
+/**
+ * @brief Drops the cached key and list once a write has finished, whether
+ *        it succeeded or not.
+ */
+class CacheInvalidation {
+ public:
+  CacheInvalidation(cache::AccessKeyCache& cache, std::string accessKeyId)
+      : m_cache(cache), m_accessKeyId(std::move(accessKeyId)) {}
+  ~CacheInvalidation() { m_cache.invalidate(m_accessKeyId); }
+
+  CacheInvalidation(const CacheInvalidation&) = delete;
+  CacheInvalidation& operator=(const CacheInvalidation&) = delete;
+
+  /// Used by a create once the id of the new key is known, since a 404 for
+  /// it may be cached.
+  void setAccessKeyId(std::string accessKeyId) {
+    m_accessKeyId = std::move(accessKeyId);
+  }
+
+ private:
+  cache::AccessKeyCache& m_cache;
+  std::string m_accessKeyId;
+};
+
+}  // namespace
+
+boost::asio::awaitable<std::string> OutlineClient::coGetAccessKeys() {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::GetAccessKeys>();
+  auto [status, body] = co_await doCachedGetAsync(
+      api::EndpointId::GetAccessKeys, target, cache::AccessKeyCache::kAllKeys);
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get access keys (status=" + std::to_string(status) + ")",
+        status);
+  }
+  boost::json::value keysVal =
+      utils::parseJson(body, "access keys", arena->storage());
+  co_return boost::json::serialize(keysVal);
+}
+
 std::future<std::string> OutlineClient::getAccessKeysAsync() {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this]() -> boost::asio::awaitable<std::string> {
-        auto url = utils::appendUrl(m_apiUrl,
-                                    std::string(api::Endpoints::GetAccessKeys));
-        auto [status, body] = co_await doGetAsync(url);
-        if (status != 200) {
-          throw OutlineServerErrorException(
-              "Unable to get access keys (status=" + std::to_string(status) +
-              ")");
-        }
-        boost::json::value keysVal;
-        try {
-          keysVal = boost::json::parse(body);
-        } catch (const std::exception& e) {
-          throw OutlineParseException(
-              std::string("JSON parse error for access keys: ") + e.what());
-        }
-        co_return boost::json::serialize(keysVal);
-      },
-      boost::asio::use_future);
+  return getAccessKeysAsync(boost::asio::use_future);
+}
+
+boost::asio::awaitable<std::string> OutlineClient::coGetAccessKey(
+    std::string accessKeyId) {
+  auto arena = m_arenas.acquire();
+  auto target = keyTarget<api::Endpoints::GetAccessKeyById>(accessKeyId);
+  auto [status, body] = co_await doCachedGetAsync(
+      api::EndpointId::GetAccessKeyById, target, accessKeyId);
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get access key (status=" + std::to_string(status) + ")",
+        status);
+  }
+  boost::json::value keyVal =
+      utils::parseJson(body, "access key", arena->storage());
+  co_return boost::json::serialize(keyVal);
 }
 
 std::future<std::string> OutlineClient::getAccessKeyAsync(
     const std::string& accessKeyId) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, accessKeyId]() -> boost::asio::awaitable<std::string> {
-        std::map<std::string, std::string> placeholders{{"keyId", accessKeyId}};
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            utils::replacePlaceholders(
-                std::string(api::Endpoints::GetAccessKeyById), placeholders));
-        auto [status, body] = co_await doGetAsync(url);
-        if (status != 200) {
-          throw OutlineServerErrorException(
-              "Unable to get access key (status=" + std::to_string(status) +
-              ")");
-        }
-        boost::json::value keyVal;
-        try {
-          keyVal = boost::json::parse(body);
-        } catch (const std::exception& e) {
-          throw OutlineParseException(
-              std::string("JSON parse error for access key: ") + e.what());
-        }
-        co_return boost::json::serialize(keyVal);
-      },
-      boost::asio::use_future);
+  return getAccessKeyAsync(accessKeyId, boost::asio::use_future);
+}
+
+boost::asio::awaitable<std::string> OutlineClient::coCreateAccessKey(
+    CreateAccessKeyParams params) {
+  CacheInvalidation invalidation(m_accessKeyCache,
+                                 cache::AccessKeyCache::kAllKeys);
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::CreateAccessKey>();
+  auto [status, responseBody] = co_await doPostAsync(
+      api::EndpointId::CreateAccessKey, target,
+      utils::serializeAccessKeyParams(params, *arena));
+  if (status != 201) {
+    throw OutlineServerErrorException(
+        "Unable to create access key (status=" + std::to_string(status) + ")",
+        status);
+  }
+  boost::json::value keyVal = utils::parseJson(
+      responseBody, "access key creation", arena->storage());
+  if (const auto* keyObj = keyVal.if_object()) {
+    if (const auto* id = keyObj->if_contains("id"); id && id->is_string()) {
+      invalidation.setAccessKeyId(std::string(id->as_string()));
+    }
+  }
+  co_return boost::json::serialize(keyVal);
 }
 
 std::future<std::string> OutlineClient::createAccessKeyAsync(
     const CreateAccessKeyParams& params) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, params]() -> boost::asio::awaitable<std::string> {
-        auto url = utils::appendUrl(
-            m_apiUrl, std::string(api::Endpoints::CreateAccessKey));
-        boost::json::object keyObj;
-        if (params.name)
-          keyObj["name"] = params.name.value();
-        if (params.password)
-          keyObj["password"] = params.password.value();
-        if (params.method)
-          keyObj["method"] = params.method.value();
-        if (params.data_limit_bytes) {
-          boost::json::object dataLimitObj{
-              {"bytes", params.data_limit_bytes.value()}};
-          keyObj["limit"] = dataLimitObj;
-        }
-        auto [status, responseBody] =
-            co_await doPostAsync(url, boost::json::serialize(keyObj));
-        if (status != 201) {
-          throw OutlineServerErrorException(
-              "Unable to create access key (status=" + std::to_string(status) +
-              ")");
-        }
-        boost::json::value keyVal;
-        try {
-          keyVal = boost::json::parse(responseBody);
-        } catch (const std::exception& e) {
-          throw OutlineParseException(
-              std::string("JSON parse error for access key creation: ") +
-              e.what());
-        }
-        co_return boost::json::serialize(keyVal);
-      },
-      boost::asio::use_future);
+  return createAccessKeyAsync(params, boost::asio::use_future);
+}
+
+boost::asio::awaitable<std::string> OutlineClient::coUpdateAccessKey(
+    std::string accessKeyId, UpdateAccessKeyParams params) {
+  CacheInvalidation invalidation(m_accessKeyCache, accessKeyId);
+  auto arena = m_arenas.acquire();
+  auto target = keyTarget<api::Endpoints::UpdateAccessKey>(accessKeyId);
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::UpdateAccessKey, target,
+      utils::serializeAccessKeyParams(params, *arena));
+  if (status != 201) {
+    throw OutlineServerErrorException(
+        "Unable to update access key (status=" + std::to_string(status) + ")",
+        status);
+  }
+  boost::json::value keyVal = utils::parseJson(
+      responseBody, "access key update", arena->storage());
+  co_return boost::json::serialize(keyVal);
 }
 
 std::future<std::string> OutlineClient::updateAccessKeyAsync(
     const std::string& accessKeyId, const UpdateAccessKeyParams& params) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, accessKeyId, params]() -> boost::asio::awaitable<std::string> {
-        std::map<std::string, std::string> placeholders{{"keyId", accessKeyId}};
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            utils::replacePlaceholders(
-                std::string(api::Endpoints::UpdateAccessKey), placeholders));
-        boost::json::object keyObj;
-        if (params.name)
-          keyObj["name"] = params.name.value();
-        if (params.password)
-          keyObj["password"] = params.password.value();
-        if (params.method)
-          keyObj["method"] = params.method.value();
-        if (params.data_limit_bytes) {
-          boost::json::object dataLimitObj{
-              {"bytes", params.data_limit_bytes.value()}};
-          keyObj["limit"] = dataLimitObj;
-        }
-        auto [status, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(keyObj));
-        if (status != 201) {
-          throw OutlineServerErrorException(
-              "Unable to update access key (status=" + std::to_string(status) +
-              ")");
-        }
-        boost::json::value keyVal;
-        try {
-          keyVal = boost::json::parse(responseBody);
-        } catch (const std::exception& e) {
-          throw OutlineParseException(
-              std::string("JSON parse error for access key update: ") +
-              e.what());
-        }
-        co_return boost::json::serialize(keyVal);
-      },
-      boost::asio::use_future);
+  return updateAccessKeyAsync(accessKeyId, params, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coDeleteAccessKey(
+    std::string accessKeyId) {
+  CacheInvalidation invalidation(m_accessKeyCache, accessKeyId);
+  auto target = keyTarget<api::Endpoints::DeleteAccessKey>(accessKeyId);
+  auto [status, responseBody] = co_await doDeleteAsync(
+      api::EndpointId::DeleteAccessKey, target);
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to delete access key (status=" + std::to_string(status) + ")",
+        status);
+  }
 }
 
 std::future<void> OutlineClient::deleteAccessKeyAsync(
     const std::string& accessKeyId) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, accessKeyId]() -> boost::asio::awaitable<void> {
-        std::map<std::string, std::string> placeholders{{"keyId", accessKeyId}};
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            utils::replacePlaceholders(
-                std::string(api::Endpoints::DeleteAccessKey), placeholders));
-        auto [status, responseBody] = co_await doDeleteAsync(url);
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to delete access key (status=" + std::to_string(status) +
-              ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return deleteAccessKeyAsync(accessKeyId, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coRenameAccessKey(
+    std::string accessKeyId, std::string newName) {
+  CacheInvalidation invalidation(m_accessKeyCache, accessKeyId);
+  auto arena = m_arenas.acquire();
+  auto target = keyTarget<api::Endpoints::RenameAccessKey>(accessKeyId);
+  utils::JsonWriter body = arena->writeBody();
+  body.beginObject().field("name", newName).endObject();
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::RenameAccessKey, target, body.str());
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to rename access key (status=" + std::to_string(status) + ")",
+        status);
+  }
 }
 
 std::future<void> OutlineClient::renameAccessKeyAsync(
     const std::string& accessKeyId, const std::string& newName) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, accessKeyId, newName]() -> boost::asio::awaitable<void> {
-        std::map<std::string, std::string> placeholders{{"keyId", accessKeyId}};
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            utils::replacePlaceholders(
-                std::string(api::Endpoints::RenameAccessKey), placeholders));
-        boost::json::object keyObj{{"name", newName}};
-        auto [status, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(keyObj));
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to rename access key (status=" + std::to_string(status) +
-              ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return renameAccessKeyAsync(accessKeyId, newName, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coAddDataLimit(
+    std::string accessKeyId, int dataLimitBytes) {
+  CacheInvalidation invalidation(m_accessKeyCache, accessKeyId);
+  auto arena = m_arenas.acquire();
+  auto target = keyTarget<api::Endpoints::AddDataLimit>(accessKeyId);
+  utils::JsonWriter body = arena->writeBody();
+  body.beginObject().field("bytes", dataLimitBytes).endObject();
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::AddDataLimit, target, body.str());
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to add data limit (status=" + std::to_string(status) + ")",
+        status);
+  }
 }
 
 std::future<void> OutlineClient::addDataLimitAsync(
     const std::string& accessKeyId, int dataLimitBytes) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, accessKeyId, dataLimitBytes]() -> boost::asio::awaitable<void> {
-        std::map<std::string, std::string> placeholders{{"keyId", accessKeyId}};
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            utils::replacePlaceholders(
-                std::string(api::Endpoints::AddDataLimit), placeholders));
-        boost::json::object dataLimitObj{{"bytes", dataLimitBytes}};
-        auto [status, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(dataLimitObj));
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to add data limit (status=" + std::to_string(status) +
-              ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return addDataLimitAsync(
+      accessKeyId, dataLimitBytes, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coDeleteDataLimit(
+    std::string accessKeyId) {
+  CacheInvalidation invalidation(m_accessKeyCache, accessKeyId);
+  auto target = keyTarget<api::Endpoints::DeleteDataLimit>(accessKeyId);
+  auto [status, responseBody] = co_await doDeleteAsync(
+      api::EndpointId::DeleteDataLimit, target);
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to delete data limit (status=" + std::to_string(status) + ")",
+        status);
+  }
 }
 
 std::future<void> OutlineClient::deleteDataLimitAsync(
     const std::string& accessKeyId) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, accessKeyId]() -> boost::asio::awaitable<void> {
-        std::map<std::string, std::string> placeholders{{"keyId", accessKeyId}};
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            utils::replacePlaceholders(
-                std::string(api::Endpoints::DeleteDataLimit), placeholders));
-        auto [status, responseBody] = co_await doDeleteAsync(url);
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to delete data limit (status=" + std::to_string(status) +
-              ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return deleteDataLimitAsync(accessKeyId, boost::asio::use_future);
+}
+
+boost::asio::awaitable<std::vector<AccessKey>>
+OutlineClient::coGetAccessKeysTyped() {
+  co_return co_await coReadAccessKeysTyped(false);
+}
+
+boost::asio::awaitable<std::vector<AccessKey>>
+OutlineClient::coGetAccessKeysTypedUncached() {
+  co_return co_await coReadAccessKeysTyped(true);
+}
+
+boost::asio::awaitable<std::vector<AccessKey>>
+OutlineClient::coReadAccessKeysTyped(bool refresh) {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::GetAccessKeys>();
+  auto [status, body] = co_await doCachedGetAsync(
+      api::EndpointId::GetAccessKeys, target, cache::AccessKeyCache::kAllKeys,
+      refresh);
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get access keys (status=" + std::to_string(status) + ")",
+        status);
+  }
+  co_return accessKeysFromJson(
+      utils::parseJson(body, "access keys", arena->storage()));
+}
+
+std::future<std::vector<AccessKey>> OutlineClient::getAccessKeysTypedAsync() {
+  return getAccessKeysTypedAsync(boost::asio::use_future);
+}
+
+boost::asio::awaitable<std::size_t> OutlineClient::coGetAccessKeysStream(
+    AccessKeyStreamParser::Callback onAccessKey) {
+  auto target = routeTarget<api::Endpoints::GetAccessKeys>();
+  AccessKeyStreamParser parser(std::move(onAccessKey));
+  int status = co_await doGetStreamAsync(
+      api::EndpointId::GetAccessKeys, target,
+      [&parser](std::string_view chunk) { parser.write(chunk); });
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get access keys (status=" + std::to_string(status) + ")",
+        status);
+  }
+  parser.finish();
+  co_return parser.count();
+}
+
+std::future<std::size_t> OutlineClient::getAccessKeysStreamAsync(
+    AccessKeyStreamParser::Callback onAccessKey) {
+  return getAccessKeysStreamAsync(std::move(onAccessKey),
+                                  boost::asio::use_future);
+}
+
+boost::asio::awaitable<AccessKey> OutlineClient::coGetAccessKeyTyped(
+    std::string accessKeyId) {
+  auto arena = m_arenas.acquire();
+  auto target = keyTarget<api::Endpoints::GetAccessKeyById>(accessKeyId);
+  auto [status, body] = co_await doCachedGetAsync(
+      api::EndpointId::GetAccessKeyById, target, accessKeyId);
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get access key (status=" + std::to_string(status) + ")",
+        status);
+  }
+  co_return utils::parseJsonAs<AccessKey>(
+      body, "access key", arena->storage());
+}
+
+std::future<AccessKey> OutlineClient::getAccessKeyTypedAsync(
+    const std::string& accessKeyId) {
+  return getAccessKeyTypedAsync(accessKeyId, boost::asio::use_future);
+}
+
+boost::asio::awaitable<AccessKey> OutlineClient::coCreateAccessKeyTyped(
+    CreateAccessKeyParams params) {
+  CacheInvalidation invalidation(m_accessKeyCache,
+                                 cache::AccessKeyCache::kAllKeys);
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::CreateAccessKey>();
+  auto [status, responseBody] = co_await doPostAsync(
+      api::EndpointId::CreateAccessKey, target,
+      utils::serializeAccessKeyParams(params, *arena));
+  if (status != 201) {
+    throw OutlineServerErrorException(
+        "Unable to create access key (status=" + std::to_string(status) + ")",
+        status);
+  }
+  AccessKey key = utils::parseJsonAs<AccessKey>(
+      responseBody, "access key creation", arena->storage());
+  invalidation.setAccessKeyId(key.id);
+  co_return key;
+}
+
+std::future<AccessKey> OutlineClient::createAccessKeyTypedAsync(
+    const CreateAccessKeyParams& params) {
+  return createAccessKeyTypedAsync(params, boost::asio::use_future);
+}
+
+boost::asio::awaitable<AccessKey> OutlineClient::coUpdateAccessKeyTyped(
+    std::string accessKeyId, UpdateAccessKeyParams params) {
+  CacheInvalidation invalidation(m_accessKeyCache, accessKeyId);
+  auto arena = m_arenas.acquire();
+  auto target = keyTarget<api::Endpoints::UpdateAccessKey>(accessKeyId);
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::UpdateAccessKey, target,
+      utils::serializeAccessKeyParams(params, *arena));
+  if (status != 201) {
+    throw OutlineServerErrorException(
+        "Unable to update access key (status=" + std::to_string(status) + ")",
+        status);
+  }
+  co_return utils::parseJsonAs<AccessKey>(
+      responseBody, "access key update", arena->storage());
+}
+
+std::future<AccessKey> OutlineClient::updateAccessKeyTypedAsync(
+    const std::string& accessKeyId, const UpdateAccessKeyParams& params) {
+  return updateAccessKeyTypedAsync(
+      accessKeyId, params, boost::asio::use_future);
 }
 
 std::string OutlineClient::getAccessKeys() {
@@ -263,4 +362,24 @@ void OutlineClient::deleteDataLimit(const std::string& accessKeyId) {
     deleteDataLimitAsync(accessKeyId).get();
 }
 
+std::vector<AccessKey> OutlineClient::getAccessKeysTyped() {
+    return getAccessKeysTypedAsync().get();
+}
+
+AccessKey OutlineClient::getAccessKeyTyped(const std::string& accessKeyId) {
+    return getAccessKeyTypedAsync(accessKeyId).get();
+}
+
+std::size_t OutlineClient::getAccessKeysStream(AccessKeyStreamParser::Callback onAccessKey) {
+    return getAccessKeysStreamAsync(std::move(onAccessKey)).get();
+}
+
+AccessKey OutlineClient::createAccessKeyTyped(const CreateAccessKeyParams& params) {
+    return createAccessKeyTypedAsync(params).get();
+}
+
+AccessKey OutlineClient::updateAccessKeyTyped(const std::string& accessKeyId, const UpdateAccessKeyParams& params) {
+    return updateAccessKeyTypedAsync(accessKeyId, params).get();
+}
+
 }  // namespace outline
@@ -0,0 +1,174 @@
+#include "outline/OutlineClient.h"
+#include "outline/exceptions/OutlineExceptions.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/any_completion_handler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <memory>
+
+namespace outline {
+
+AccessKeyOperation AccessKeyOperation::create(CreateAccessKeyParams params) {
+  AccessKeyOperation operation;
+  operation.type = AccessKeyOperationType::Create;
+  operation.params = std::move(params);
+  return operation;
+}
+
+AccessKeyOperation AccessKeyOperation::rename(std::string accessKeyId,
+                                              std::string name) {
+  AccessKeyOperation operation;
+  operation.type = AccessKeyOperationType::Rename;
+  operation.accessKeyId = std::move(accessKeyId);
+  operation.name = std::move(name);
+  return operation;
+}
+
+AccessKeyOperation AccessKeyOperation::addDataLimit(std::string accessKeyId,
+                                                    int dataLimitBytes) {
+  AccessKeyOperation operation;
+  operation.type = AccessKeyOperationType::AddDataLimit;
+  operation.accessKeyId = std::move(accessKeyId);
+  operation.dataLimitBytes = dataLimitBytes;
+  return operation;
+}
+
+AccessKeyOperation AccessKeyOperation::deleteDataLimit(
+    std::string accessKeyId) {
+  AccessKeyOperation operation;
+  operation.type = AccessKeyOperationType::DeleteDataLimit;
+  operation.accessKeyId = std::move(accessKeyId);
+  return operation;
+}
+
+AccessKeyOperation AccessKeyOperation::remove(std::string accessKeyId) {
+  AccessKeyOperation operation;
+  operation.type = AccessKeyOperationType::Delete;
+  operation.accessKeyId = std::move(accessKeyId);
+  return operation;
+}
+
+namespace {
+
+/**
+ * @brief State shared by the workers of one bulk request.
+ */
+struct BulkState {
+  explicit BulkState(std::vector<AccessKeyOperation> operations)
+      : operations(std::move(operations)), results(this->operations.size()) {}
+
+  std::vector<AccessKeyOperation> operations;
+  std::vector<AccessKeyOperationResult> results;
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> runningWorkers{0};
+  /// Resumes the waiting coroutine once the last worker has finished.
+  boost::asio::any_completion_handler<void()> onDone;
+};
+
+}  // namespace
+
+boost::asio::awaitable<AccessKeyOperationResult>
+OutlineClient::coApplyAccessKeyOperation(AccessKeyOperation operation) {
+  AccessKeyOperationResult result;
+  try {
+    switch (operation.type) {
+      case AccessKeyOperationType::Create:
+        if (operation.accessKeyId.empty()) {
+          result.accessKey =
+              co_await coCreateAccessKeyTyped(std::move(operation.params));
+        } else {
+          UpdateAccessKeyParams params;
+          params.name = std::move(operation.params.name);
+          params.method = std::move(operation.params.method);
+          params.password = std::move(operation.params.password);
+          params.data_limit_bytes = operation.params.data_limit_bytes;
+          result.accessKey = co_await coUpdateAccessKeyTyped(
+              std::move(operation.accessKeyId), std::move(params));
+        }
+        break;
+      case AccessKeyOperationType::Rename:
+        co_await coRenameAccessKey(std::move(operation.accessKeyId),
+                                   std::move(operation.name));
+        break;
+      case AccessKeyOperationType::AddDataLimit:
+        co_await coAddDataLimit(std::move(operation.accessKeyId),
+                                operation.dataLimitBytes);
+        break;
+      case AccessKeyOperationType::DeleteDataLimit:
+        co_await coDeleteDataLimit(std::move(operation.accessKeyId));
+        break;
+      case AccessKeyOperationType::Delete:
+        co_await coDeleteAccessKey(std::move(operation.accessKeyId));
+        break;
+    }
+    result.success = true;
+  } catch (const OutlineServerErrorException& e) {
+    result.status = e.status();
+    result.error = std::current_exception();
+  } catch (...) {
+    result.error = std::current_exception();
+  }
+  co_return result;
+}
+
+boost::asio::awaitable<std::vector<AccessKeyOperationResult>>
+OutlineClient::coApplyAccessKeyOperations(
+    std::vector<AccessKeyOperation> operations, std::size_t concurrency) {
+  if (operations.empty()) {
+    co_return std::vector<AccessKeyOperationResult>();
+  }
+  auto executor = co_await boost::asio::this_coro::executor;
+  auto state = std::make_shared<BulkState>(std::move(operations));
+  const std::size_t workers =
+      std::clamp<std::size_t>(concurrency, 1, state->operations.size());
+  state->runningWorkers = workers;
+
+  // Every worker takes the next operation until none are left, so at most
+  // `workers` requests are in flight at any time.
+  auto worker = [this, state]() -> boost::asio::awaitable<void> {
+    for (;;) {
+      const std::size_t index =
+          state->next.fetch_add(1, std::memory_order_relaxed);
+      if (index >= state->operations.size()) {
+        co_return;
+      }
+      state->results[index] = co_await coApplyAccessKeyOperation(
+          std::move(state->operations[index]));
+    }
+  };
+  auto onWorkerDone = [state](std::exception_ptr) {
+    if (state->runningWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      boost::asio::post(std::move(state->onDone));
+    }
+  };
+  // The workers are started only after the completion handler is stored, so
+  // the last one cannot finish before there is someone to wake up.
+  co_await boost::asio::async_initiate<
+      decltype(boost::asio::use_awaitable), void()>(
+      [&](auto handler) {
+        state->onDone = std::move(handler);
+        for (std::size_t i = 0; i < workers; ++i) {
+          boost::asio::co_spawn(executor, worker, onWorkerDone);
+        }
+      },
+      boost::asio::use_awaitable);
+  co_return std::move(state->results);
+}
+
+std::future<std::vector<AccessKeyOperationResult>>
+OutlineClient::applyAccessKeyOperationsAsync(
+    std::vector<AccessKeyOperation> operations, std::size_t concurrency) {
+  return applyAccessKeyOperationsAsync(std::move(operations), concurrency,
+                                       boost::asio::use_future);
+}
+
+std::vector<AccessKeyOperationResult> OutlineClient::applyAccessKeyOperations(
+    std::vector<AccessKeyOperation> operations, std::size_t concurrency) {
+    return applyAccessKeyOperationsAsync(std::move(operations), concurrency)
+        .get();
+}
+
+}  // namespace outline
@@ -1,90 +1,103 @@
 #include "outline/OutlineClient.h"
 #include "outline/constants/ApiEndpoint.h"
 #include "outline/exceptions/OutlineExceptions.h"
+#include "outline/utils/JsonUtils.h"
 #include "outline/utils/UrlUtils.h"
 
 #include <boost/json.hpp>
 #include <future>
-#include <map>
 #include <string>
 
 namespace outline {
+boost::asio::awaitable<std::string> OutlineClient::coGetMetrics() {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::GetMetrics>();
+  auto [status, body] =
+      co_await doGetAsync(api::EndpointId::GetMetrics, target);
+  if (status >= 400 ||
+      body.find("bytesTransferredByUserId") == std::string::npos) {
+    throw OutlineServerErrorException(
+        "Unable to get metrics (status=" + std::to_string(status) + ")",
+        status);
+  }
+  boost::json::value metricsVal =
+      utils::parseJson(body, "metrics", arena->storage());
+  co_return boost::json::serialize(metricsVal);
+}
+
 std::future<std::string> OutlineClient::getMetricsAsync() {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this]() -> boost::asio::awaitable<std::string> {
-        auto url =
-            utils::appendUrl(m_apiUrl, std::string(api::Endpoints::GetMetrics));
-        auto [status, body] = co_await doGetAsync(url);
-        if (status >= 400 ||
-            body.find("bytesTransferredByUserId") == std::string::npos) {
-          throw OutlineServerErrorException(
-              "Unable to get metrics (status=" + std::to_string(status) + ")");
-        }
-        boost::json::value metricsVal;
-        try {
-          metricsVal = boost::json::parse(body);
-        } catch (const std::exception& e) {
-          throw OutlineParseException(
-              std::string("JSON parse error for metrics: ") + e.what());
-        }
-        co_return boost::json::serialize(metricsVal);
-      },
-      boost::asio::use_future);
+  return getMetricsAsync(boost::asio::use_future);
+}
+
+boost::asio::awaitable<TransferMetrics> OutlineClient::coGetMetricsTyped() {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::GetMetrics>();
+  auto [status, body] =
+      co_await doGetAsync(api::EndpointId::GetMetrics, target);
+  if (status >= 400) {
+    throw OutlineServerErrorException(
+        "Unable to get metrics (status=" + std::to_string(status) + ")",
+        status);
+  }
+  co_return utils::parseJsonAs<TransferMetrics>(
+      body, "metrics", arena->storage());
+}
+
+std::future<TransferMetrics> OutlineClient::getMetricsTypedAsync() {
+  return getMetricsTypedAsync(boost::asio::use_future);
+}
+
+boost::asio::awaitable<bool> OutlineClient::coGetMetricsStatus() {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::GetMetricsStatus>();
+  auto [status, body] = co_await doGetAsync(
+      api::EndpointId::GetMetricsStatus, target);
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get metrics status (status=" + std::to_string(status) + ")",
+        status);
+  }
+  boost::json::value metricsVal =
+      utils::parseJson(body, "metrics status", arena->storage());
+  if (!metricsVal.is_object() ||
+      !metricsVal.as_object().contains("metricsEnabled")) {
+    throw OutlineParseException(
+        "Invalid JSON structure for metrics status.");
+  }
+  co_return metricsVal.as_object()["metricsEnabled"].as_bool();
 }
 
 std::future<bool> OutlineClient::getMetricsStatusAsync() {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this]() -> boost::asio::awaitable<bool> {
-        auto url = utils::appendUrl(
-            m_apiUrl, std::string(api::Endpoints::GetMetricsStatus));
-        auto [status, body] = co_await doGetAsync(url);
-        if (status != 200) {
-          throw OutlineServerErrorException(
-              "Unable to get metrics status (status=" + std::to_string(status) +
-              ")");
-        }
-        boost::json::value metricsVal;
-        try {
-          metricsVal = boost::json::parse(body);
-        } catch (const std::exception& e) {
-          throw OutlineParseException(
-              std::string("JSON parse error for metrics status: ") + e.what());
-        }
-        if (!metricsVal.is_object() ||
-            !metricsVal.as_object().contains("metricsEnabled")) {
-          throw OutlineParseException(
-              "Invalid JSON structure for metrics status.");
-        }
-        co_return metricsVal.as_object()["metricsEnabled"].as_bool();
-      },
-      boost::asio::use_future);
+  return getMetricsStatusAsync(boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coSetMetricsStatus(bool status) {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::SetMetricsStatus>();
+  utils::JsonWriter body = arena->writeBody();
+  body.beginObject().field("metricsEnabled", status).endObject();
+  auto [statusCode, responseBody] = co_await doPutAsync(
+      api::EndpointId::SetMetricsStatus, target, body.str());
+  if (statusCode != 204) {
+    throw OutlineServerErrorException(
+        "Unable to set metrics status (status=" +
+        std::to_string(statusCode) + ")",
+        statusCode);
+  }
 }
 
 std::future<void> OutlineClient::setMetricsStatusAsync(bool status) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, status]() -> boost::asio::awaitable<void> {
-        auto url = utils::appendUrl(
-            m_apiUrl, std::string(api::Endpoints::SetMetricsStatus));
-        boost::json::object metricsObj{{"metricsEnabled", status}};
-        auto [statusCode, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(metricsObj));
-        if (statusCode != 204) {
-          throw OutlineServerErrorException(
-              "Unable to set metrics status (status=" +
-              std::to_string(statusCode) + ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return setMetricsStatusAsync(status, boost::asio::use_future);
 }
 
 std::string OutlineClient::getMetrics() {
     return getMetricsAsync().get();
 }
 
+TransferMetrics OutlineClient::getMetricsTyped() {
+    return getMetricsTypedAsync().get();
+}
+
 std::string OutlineClient::getServerInformation() {
     return getServerInformationAsync().get();
 }
@@ -1,13 +1,15 @@
 #include "outline/OutlineClient.h"
 #include "outline/constants/ApiEndpoint.h"
 #include "outline/exceptions/OutlineExceptions.h"
-#include "outline/utils/UrlUtils.h"
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
 #include <boost/json.hpp>
+#include <array>
 #include <iostream>
+#include <optional>
 
 namespace outline {
 
@@ -15,156 +17,476 @@ namespace ssl = boost::asio::ssl;
 namespace http = boost::beast::http;
 using tcp = boost::asio::ip::tcp;
 
-boost::asio::awaitable<std::pair<int, std::string>> OutlineClient::doGetAsync(
-    const boost::urls::url& url) {
-  ssl::stream<tcp::socket> sslStream(m_ioContext, m_sslContext);
-  tcp::resolver resolver(m_ioContext);
-  auto results = co_await resolver.async_resolve(url.host(), url.port(),
-                                                 boost::asio::use_awaitable);
-  co_await boost::asio::async_connect(sslStream.next_layer(), results,
-                                      boost::asio::use_awaitable);
-  co_await sslStream.async_handshake(ssl::stream_base::client,
-                                     boost::asio::use_awaitable);
-
-  std::string host = url.host();
-  std::string target = url.encoded_path().data();
-  if (!url.encoded_query().empty()) {
-    target += "?" + std::string(url.encoded_query());
-  }
-
-  http::request<http::string_body> req{http::verb::get, target, 11};
-  req.set(http::field::host, host);
-  req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-  co_await http::async_write(sslStream, req, boost::asio::use_awaitable);
+namespace {
 
-  boost::beast::flat_buffer buffer;
-  http::response<http::dynamic_body> res;
-  co_await http::async_read(sslStream, buffer, res, boost::asio::use_awaitable);
+/**
+ * @brief Returns true if the error means the server closed a kept-alive
+ *        connection before the request could be served.
+ */
+bool isStaleConnectionError(const boost::system::error_code& ec) {
+  return ec == http::error::end_of_stream ||
+         ec == boost::asio::error::eof ||
+         ec == boost::asio::error::connection_reset ||
+         ec == boost::asio::error::broken_pipe ||
+         ec == ssl::error::stream_truncated;
+}
+
+/**
+ * @brief Starts the deadline of the next phase of a request. A zero timeout
+ *        disables it.
+ */
+void startPhase(network::PooledConnection& connection,
+                std::chrono::milliseconds timeout) {
+  auto& stream = boost::beast::get_lowest_layer(connection.stream);
+  if (timeout.count() > 0) {
+    stream.expires_after(timeout);
+  } else {
+    stream.expires_never();
+  }
+}
+
+/**
+ * @brief Fails the request. A phase which exceeded its deadline is reported
+ *        as OutlineTimeoutException.
+ */
+[[noreturn]] void throwRequestError(const boost::system::error_code& ec,
+                                    const std::string& phase) {
+  if (ec == boost::beast::error::timeout ||
+      ec == boost::asio::error::timed_out) {
+    throw OutlineTimeoutException(phase + " timed out");
+  }
+  throw boost::system::system_error(ec);
+}
 
+/**
+ * @brief Returns how the body of the response is encoded. A request which
+ *        did not offer Accept-Encoding gets the body as it arrived, like a
+ *        client without compression support.
+ */
+network::ContentEncoding contentEncoding(const http::fields& request,
+                                         const http::fields& response) {
+  if (request.find(http::field::accept_encoding) == request.end()) {
+    return network::ContentEncoding::Identity;
+  }
+  auto value = response[http::field::content_encoding];
+  return network::parseContentEncoding(
+      std::string_view(value.data(), value.size()));
+}
+
+/**
+ * @brief Reads the body after the header and passes it to onChunk piece by
+ *        piece. The deadline applies to every piece, so a large but
+ *        steadily arriving response is not cut off.
+ */
+boost::asio::awaitable<boost::system::error_code> readBodyChunksAsync(
+    network::PooledConnection& connection, boost::beast::flat_buffer& buffer,
+    http::response_parser<http::buffer_body>& parser,
+    std::chrono::milliseconds timeout,
+    const std::function<void(std::string_view)>& onChunk) {
   boost::system::error_code ec;
-  co_await sslStream.async_shutdown(
-      boost::asio::redirect_error(boost::asio::use_awaitable, ec));
-  if (ec && ec != boost::asio::error::eof)
-    throw boost::system::system_error(ec);
+  std::array<char, 16384> chunk;
+  while (!parser.is_done()) {
+    parser.get().body().data = chunk.data();
+    parser.get().body().size = chunk.size();
+    startPhase(connection, timeout);
+    co_await http::async_read(
+        connection.stream, buffer, parser,
+        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    if (ec == http::error::need_buffer) {
+      ec = {};
+    }
+    if (ec) {
+      co_return ec;
+    }
+    const std::size_t size = chunk.size() - parser.get().body().size;
+    if (size > 0) {
+      onChunk(std::string_view(chunk.data(), size));
+    }
+  }
+  co_return ec;
+}
 
-  co_return std::make_pair(static_cast<int>(res.result_int()),
-                           boost::beast::buffers_to_string(res.body().data()));
+[[noreturn]] void throwCircuitOpen(const boost::urls::url& apiUrl) {
+  throw OutlineCircuitOpenException("requests to " +
+                                    std::string(apiUrl.host()) +
+                                    " are suspended after repeated failures");
 }
 
-boost::asio::awaitable<std::pair<int, std::string>> OutlineClient::doPostAsync(
-    const boost::urls::url& url, const std::string& body) {
-  ssl::stream<tcp::socket> sslStream(m_ioContext, m_sslContext);
-  tcp::resolver resolver(m_ioContext);
-  auto results = co_await resolver.async_resolve(url.host(), url.port(),
-                                                 boost::asio::use_awaitable);
-  co_await boost::asio::async_connect(sslStream.next_layer(), results,
-                                      boost::asio::use_awaitable);
-  co_await sslStream.async_handshake(ssl::stream_base::client,
-                                     boost::asio::use_awaitable);
-
-  std::string host = url.host();
-  std::string target = url.encoded_path().data();
-  if (!url.encoded_query().empty()) {
-    target += "?" + std::string(url.encoded_query());
-  }
-
-  http::request<http::string_body> req{http::verb::post, target, 11};
-  req.set(http::field::host, host);
-  req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-  req.set(http::field::content_type, "application/json");
-  req.body() = body;
-  req.prepare_payload();
+}  // namespace
 
-  co_await http::async_write(sslStream, req, boost::asio::use_awaitable);
+std::chrono::milliseconds OutlineClient::requestTimeout() const {
+  return std::chrono::seconds(m_timeout);
+}
 
-  boost::beast::flat_buffer buffer;
-  http::response<http::dynamic_body> res;
-  co_await http::async_read(sslStream, buffer, res, boost::asio::use_awaitable);
+boost::asio::awaitable<std::unique_ptr<network::PooledConnection>>
+OutlineClient::connectAsync() {
+  auto executor = co_await boost::asio::this_coro::executor;
+  auto connection =
+      std::make_unique<network::PooledConnection>(executor, m_sslContext);
+  std::string host = m_apiUrl.host();
+  std::string port(m_apiUrl.port());
+  network::ResolverCache::Results results;
+  try {
+    results = co_await m_resolverCache.resolve(host, port, requestTimeout());
+  } catch (const boost::system::system_error& e) {
+    throwRequestError(e.code(), "resolve of " + host);
+  }
+  connection->peer = host + ":" + port;
+  try {
+    boost::beast::get_lowest_layer(connection->stream).socket() =
+        co_await m_happyEyeballs.connect(connection->peer, std::move(results),
+                                         requestTimeout());
+  } catch (const boost::system::system_error& e) {
+    // The cached addresses may be outdated, resolve them again next time.
+    m_resolverCache.invalidate(host, port);
+    throwRequestError(e.code(), "connect to " + connection->peer);
+  }
 
+  SSL* ssl = connection->stream.native_handle();
+  m_tlsSessionCache.prepare(ssl, connection->peer);
+  auto started = std::chrono::steady_clock::now();
   boost::system::error_code ec;
-  co_await sslStream.async_shutdown(
+  startPhase(*connection, requestTimeout());
+  co_await connection->stream.async_handshake(
+      ssl::stream_base::client,
       boost::asio::redirect_error(boost::asio::use_awaitable, ec));
-  if (ec && ec != boost::asio::error::eof)
-    throw boost::system::system_error(ec);
-
-  co_return std::make_pair(static_cast<int>(res.result_int()),
-                           boost::beast::buffers_to_string(res.body().data()));
+  if (ec) {
+    // Do not offer a session the server has just refused again.
+    m_tlsSessionCache.erase(connection->peer);
+    throwRequestError(ec, "TLS handshake with " + connection->peer);
+  }
+  m_tlsSessionCache.recordHandshake(
+      ssl, connection->peer, std::chrono::steady_clock::now() - started);
+  co_return connection;
 }
 
-boost::asio::awaitable<std::pair<int, std::string>> OutlineClient::doPutAsync(
-    const boost::urls::url& url, const std::string& body) {
-  ssl::stream<tcp::socket> sslStream(m_ioContext, m_sslContext);
-  tcp::resolver resolver(m_ioContext);
-  auto results = co_await resolver.async_resolve(url.host(), url.port(),
-                                                 boost::asio::use_awaitable);
-  co_await boost::asio::async_connect(sslStream.next_layer(), results,
-                                      boost::asio::use_awaitable);
-  co_await sslStream.async_handshake(ssl::stream_base::client,
-                                     boost::asio::use_awaitable);
-
-  std::string host = url.host();
-  std::string target = url.encoded_path().data();
-  if (!url.encoded_query().empty()) {
-    target += "?" + std::string(url.encoded_query());
-  }
-
-  http::request<http::string_body> req{http::verb::put, target, 11};
-  req.set(http::field::host, host);
+OutlineClient::Request OutlineClient::makeRequest(
+    http::verb verb, const std::string& target, const std::string& body) {
+  Request req{verb, target, 11};
+  req.set(http::field::host, m_apiUrl.host());
   req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-  req.set(http::field::content_type, "application/json");
-  req.body() = body;
-  req.prepare_payload();
-
-  co_await http::async_write(sslStream, req, boost::asio::use_awaitable);
+  if (verb == http::verb::get && m_compression.options().enabled) {
+    req.set(http::field::accept_encoding, "gzip, deflate");
+  }
+  if (verb == http::verb::post || verb == http::verb::put) {
+    req.set(http::field::content_type, "application/json");
+    req.body() = boost::beast::span<const char>(body.data(), body.size());
+    req.prepare_payload();
+  }
+  req.keep_alive(m_connectionPool.options().enabled);
+  return req;
+}
 
-  boost::beast::flat_buffer buffer;
-  http::response<http::dynamic_body> res;
-  co_await http::async_read(sslStream, buffer, res, boost::asio::use_awaitable);
+boost::asio::awaitable<void> OutlineClient::releaseConnectionAsync(
+    std::unique_ptr<network::PooledConnection> connection, bool keepAlive) {
+  if (keepAlive && m_connectionPool.options().enabled) {
+    // An idle connection must not time out before its next request.
+    boost::beast::get_lowest_layer(connection->stream).expires_never();
+    m_connectionPool.release(std::move(connection));
+    co_return;
+  }
 
   boost::system::error_code ec;
-  co_await sslStream.async_shutdown(
+  startPhase(*connection, requestTimeout());
+  co_await connection->stream.async_shutdown(
       boost::asio::redirect_error(boost::asio::use_awaitable, ec));
-  if (ec && ec != boost::asio::error::eof)
-    throw boost::system::system_error(ec);
+  if (ec && ec != boost::asio::error::eof &&
+      ec != ssl::error::stream_truncated)
+    throwRequestError(ec, "TLS shutdown");
+}
+
+boost::asio::awaitable<std::pair<int, std::string>>
+OutlineClient::doAttemptAsync(const Request& req) {
+  auto executor = co_await boost::asio::this_coro::executor;
+  for (;;) {
+    auto connection = m_connectionPool.acquire(executor);
+    const bool reused = connection != nullptr;
+    if (!reused) {
+      connection = co_await connectAsync();
+    }
+
+    boost::system::error_code ec;
+    startPhase(*connection, requestTimeout());
+    co_await http::async_write(
+        connection->stream, req,
+        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    const bool written = !ec;
+
+    boost::beast::flat_buffer buffer;
+    http::response_parser<http::string_body> parser;
+    // Access key lists of large servers exceed the default 8 MB limit.
+    parser.body_limit(boost::none);
+    if (written) {
+      startPhase(*connection, requestTimeout());
+      co_await http::async_read_header(
+          connection->stream, buffer, parser,
+          boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+    int status = 0;
+    bool keepAlive = false;
+    std::string body;
+    if (!ec) {
+      status = static_cast<int>(parser.get().result_int());
+      keepAlive = parser.get().keep_alive();
+      const auto encoding = contentEncoding(req, parser.get());
+      if (encoding == network::ContentEncoding::Identity) {
+        startPhase(*connection, requestTimeout());
+        co_await http::async_read(
+            connection->stream, buffer, parser,
+            boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        body = std::move(parser.get().body());
+      } else {
+        // Inflated as it arrives, so the compressed body is never held in
+        // full.
+        http::response_parser<http::buffer_body> chunks(std::move(parser));
+        network::Inflater inflater;
+        const network::Inflater::Sink append = [&body](std::string_view out) {
+          body.append(out);
+        };
+        ec = co_await readBodyChunksAsync(
+            *connection, buffer, chunks, requestTimeout(),
+            [&inflater, &append](std::string_view chunk) {
+              inflater.write(chunk, append);
+            });
+        if (!ec) {
+          inflater.finish();
+          m_compression.record(inflater);
+        }
+      }
+    }
+    if (ec) {
+      // The server may close an idle kept-alive connection at any time. Try
+      // again on a new connection, unless a POST might have been processed.
+      if (reused && isStaleConnectionError(ec) &&
+          (!written || req.method() != http::verb::post)) {
+        continue;
+      }
+      throwRequestError(ec, written ? "response read" : "request write");
+    }
 
-  co_return std::make_pair(static_cast<int>(res.result_int()),
-                           boost::beast::buffers_to_string(res.body().data()));
+    co_await releaseConnectionAsync(std::move(connection), keepAlive);
+    co_return std::make_pair(status, std::move(body));
+  }
 }
 
 boost::asio::awaitable<std::pair<int, std::string>>
-OutlineClient::doDeleteAsync(const boost::urls::url& url) {
-  ssl::stream<tcp::socket> sslStream(m_ioContext, m_sslContext);
-  tcp::resolver resolver(m_ioContext);
-  auto results = co_await resolver.async_resolve(url.host(), url.port(),
-                                                 boost::asio::use_awaitable);
-  co_await boost::asio::async_connect(sslStream.next_layer(), results,
-                                      boost::asio::use_awaitable);
-  co_await sslStream.async_handshake(ssl::stream_base::client,
-                                     boost::asio::use_awaitable);
-
-  std::string host = url.host();
-  std::string target = url.encoded_path().data();
-  if (!url.encoded_query().empty()) {
-    target += "?" + std::string(url.encoded_query());
-  }
-
-  http::request<http::string_body> req{http::verb::delete_, target, 11};
-  req.set(http::field::host, host);
-  req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-  co_await http::async_write(sslStream, req, boost::asio::use_awaitable);
+OutlineClient::doRequestAsync(api::EndpointId endpoint, http::verb verb,
+                              const std::string& target,
+                              const std::string& body) {
+  if (verb != http::verb::get) {
+    // A GET issued after this write must not get a response read before it.
+    m_coalescer.invalidate();
+  }
+  auto req = makeRequest(verb, target, body);
+  // A POST may have created a key before it failed, so it is never repeated.
+  const bool idempotent = verb != http::verb::post;
+  for (int attempt = 1;; ++attempt) {
+    co_await m_rateLimiter.acquire();
+    if (!m_circuitBreaker.allow()) {
+      throwCircuitOpen(m_apiUrl);
+    }
+    std::exception_ptr error;
+    std::pair<int, std::string> result;
+    auto recording = m_requestMetrics.start(endpoint, req.body().size());
+    try {
+      result = co_await doAttemptAsync(req);
+      recording.responded(result.first, result.second.size());
+    } catch (const boost::system::system_error& e) {
+      if (e.code() == boost::asio::error::operation_aborted) {
+        m_circuitBreaker.recordAbandoned();
+        throw;
+      }
+      recording.failed();
+      error = std::current_exception();
+    } catch (const OutlineTimeoutException&) {
+      recording.timedOut();
+      error = std::current_exception();
+    } catch (...) {
+      m_circuitBreaker.recordAbandoned();
+      throw;
+    }
 
-  boost::beast::flat_buffer buffer;
-  http::response<http::dynamic_body> res;
-  co_await http::async_read(sslStream, buffer, res, boost::asio::use_awaitable);
+    const bool serverError = !error && result.first >= 500;
+    if (!error && !serverError) {
+      m_circuitBreaker.recordSuccess();
+      co_return result;
+    }
+    m_circuitBreaker.recordFailure();
+    const bool retryable =
+        idempotent && (error || m_retryPolicy.options().retryServerErrors);
+    if (!retryable || !m_retryPolicy.shouldRetry(attempt)) {
+      if (retryable) {
+        m_retryPolicy.recordExhausted();
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      co_return result;
+    }
+    m_retryPolicy.recordRetry();
+    boost::asio::steady_timer backoff(
+        co_await boost::asio::this_coro::executor,
+        m_retryPolicy.backoff(attempt));
+    co_await backoff.async_wait(boost::asio::use_awaitable);
+  }
+}
 
-  boost::system::error_code ec;
-  co_await sslStream.async_shutdown(
-      boost::asio::redirect_error(boost::asio::use_awaitable, ec));
-  if (ec && ec != boost::asio::error::eof)
-    throw boost::system::system_error(ec);
+boost::asio::awaitable<int> OutlineClient::doGetStreamAsync(
+    api::EndpointId endpoint, const std::string& target,
+    const std::function<void(std::string_view)>& onChunk) {
+  // Chunks already passed to onChunk cannot be taken back, so a streamed
+  // request is only guarded by the circuit breaker and never retried.
+  co_await m_rateLimiter.acquire();
+  if (!m_circuitBreaker.allow()) {
+    throwCircuitOpen(m_apiUrl);
+  }
+  int status = 0;
+  std::size_t received = 0;
+  auto recording = m_requestMetrics.start(endpoint, 0);
+  try {
+    status = co_await doGetStreamAttemptAsync(
+        target, [&onChunk, &received](std::string_view chunk) {
+          received += chunk.size();
+          onChunk(chunk);
+        });
+    recording.responded(status, received);
+  } catch (const boost::system::system_error& e) {
+    if (e.code() == boost::asio::error::operation_aborted) {
+      m_circuitBreaker.recordAbandoned();
+    } else {
+      m_circuitBreaker.recordFailure();
+    }
+    throw;
+  } catch (const OutlineTimeoutException&) {
+    recording.timedOut();
+    m_circuitBreaker.recordFailure();
+    throw;
+  } catch (...) {
+    m_circuitBreaker.recordAbandoned();
+    throw;
+  }
+  if (status >= 500) {
+    m_circuitBreaker.recordFailure();
+  } else {
+    m_circuitBreaker.recordSuccess();
+  }
+  co_return status;
+}
+
+boost::asio::awaitable<int> OutlineClient::doGetStreamAttemptAsync(
+    const std::string& target,
+    const std::function<void(std::string_view)>& onChunk) {
+  auto req = makeRequest(http::verb::get, target, std::string());
+  auto executor = co_await boost::asio::this_coro::executor;
+  for (;;) {
+    auto connection = m_connectionPool.acquire(executor);
+    const bool reused = connection != nullptr;
+    if (!reused) {
+      connection = co_await connectAsync();
+    }
+
+    boost::system::error_code ec;
+    startPhase(*connection, requestTimeout());
+    co_await http::async_write(
+        connection->stream, req,
+        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    const bool written = !ec;
+
+    boost::beast::flat_buffer buffer;
+    http::response_parser<http::buffer_body> parser;
+    parser.body_limit(boost::none);
+    if (written) {
+      startPhase(*connection, requestTimeout());
+      co_await http::async_read_header(
+          connection->stream, buffer, parser,
+          boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+    if (ec) {
+      // Nothing has been passed to onChunk yet, so a stale kept-alive
+      // connection can be replaced like in doAttemptAsync.
+      if (reused && isStaleConnectionError(ec)) {
+        continue;
+      }
+      throwRequestError(ec, written ? "response read" : "request write");
+    }
+
+    const int status = static_cast<int>(parser.get().result_int());
+    const bool deliver = status >= 200 && status < 300;
+    std::optional<network::Inflater> inflater;
+    if (deliver &&
+        contentEncoding(req, parser.get()) !=
+            network::ContentEncoding::Identity) {
+      inflater.emplace();
+    }
+    ec = co_await readBodyChunksAsync(
+        *connection, buffer, parser, requestTimeout(),
+        [&](std::string_view chunk) {
+          if (inflater) {
+            inflater->write(chunk, onChunk);
+          } else if (deliver) {
+            onChunk(chunk);
+          }
+        });
+    if (ec) {
+      throwRequestError(ec, "response read");
+    }
+    if (inflater) {
+      inflater->finish();
+      m_compression.record(*inflater);
+    }
+
+    co_await releaseConnectionAsync(std::move(connection),
+                                    parser.get().keep_alive());
+    co_return status;
+  }
+}
+
+boost::asio::awaitable<std::pair<int, std::string>> OutlineClient::doGetAsync(
+    api::EndpointId endpoint, const std::string& target) {
+  // The target already holds the base path, the route and the key id, so
+  // it identifies the request of this client on its own.
+  co_return co_await m_coalescer.run(
+      target, [this, endpoint, target]() -> boost::asio::awaitable<
+                                             std::pair<int, std::string>> {
+        co_return co_await doRequestAsync(endpoint, http::verb::get, target,
+                                          std::string());
+      });
+}
+
+boost::asio::awaitable<std::pair<int, std::string>>
+OutlineClient::doCachedGetAsync(api::EndpointId endpoint,
+                                const std::string& target,
+                                const std::string& accessKeyId,
+                                bool refresh) {
+  if (!refresh) {
+    if (auto cached = m_accessKeyCache.find(accessKeyId)) {
+      co_return std::move(*cached);
+    }
+  }
+  const std::uint64_t generation = m_accessKeyCache.generation();
+  auto response = co_await doGetAsync(endpoint, target);
+  m_accessKeyCache.store(accessKeyId, response.first, response.second,
+                         generation);
+  co_return response;
+}
+
+boost::asio::awaitable<std::pair<int, std::string>> OutlineClient::doPostAsync(
+    api::EndpointId endpoint, const std::string& target,
+    const std::string& body) {
+  co_return co_await doRequestAsync(endpoint, http::verb::post, target, body);
+}
 
-  co_return std::make_pair(static_cast<int>(res.result_int()),
-                           boost::beast::buffers_to_string(res.body().data()));
+boost::asio::awaitable<std::pair<int, std::string>> OutlineClient::doPutAsync(
+    api::EndpointId endpoint, const std::string& target,
+    const std::string& body) {
+  co_return co_await doRequestAsync(endpoint, http::verb::put, target, body);
+}
+
+boost::asio::awaitable<std::pair<int, std::string>>
+OutlineClient::doDeleteAsync(api::EndpointId endpoint,
+                             const std::string& target) {
+  co_return co_await doRequestAsync(endpoint, http::verb::delete_, target,
+                                    std::string());
 }
 
 }  // namespace outline
@@ -1,140 +1,164 @@
 #include "outline/OutlineClient.h"
 #include "outline/constants/ApiEndpoint.h"
 #include "outline/exceptions/OutlineExceptions.h"
+#include "outline/utils/JsonUtils.h"
 #include "outline/utils/UrlUtils.h"
 
 #include <boost/json.hpp>
 #include <future>
-#include <map>
 #include <string>
 
 namespace outline {
+boost::asio::awaitable<std::string> OutlineClient::coGetServerInformation() {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::GetServerInformation>();
+  auto [status, body] = co_await doGetAsync(
+      api::EndpointId::GetServerInformation, target);
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get server information (status=" +
+        std::to_string(status) + ")",
+        status);
+  }
+  boost::json::value serverVal =
+      utils::parseJson(body, "server", arena->storage());
+  co_return boost::json::serialize(serverVal);
+}
+
 std::future<std::string> OutlineClient::getServerInformationAsync() {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this]() -> boost::asio::awaitable<std::string> {
-        auto url = utils::appendUrl(
-            m_apiUrl, std::string(api::Endpoints::GetServerInformation));
-        auto [status, body] = co_await doGetAsync(url);
-        if (status != 200) {
-          throw OutlineServerErrorException(
-              "Unable to get server information (status=" +
-              std::to_string(status) + ")");
-        }
-        boost::json::value serverVal;
-        try {
-          serverVal = boost::json::parse(body);
-        } catch (const std::exception& e) {
-          throw OutlineParseException(
-              std::string("JSON parse error for server: ") + e.what());
-        }
-        co_return boost::json::serialize(serverVal);
-      },
-      boost::asio::use_future);
+  return getServerInformationAsync(boost::asio::use_future);
+}
+
+boost::asio::awaitable<ServerInformation>
+OutlineClient::coGetServerInformationTyped() {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::GetServerInformation>();
+  auto [status, body] = co_await doGetAsync(
+      api::EndpointId::GetServerInformation, target);
+  if (status != 200) {
+    throw OutlineServerErrorException(
+        "Unable to get server information (status=" +
+        std::to_string(status) + ")",
+        status);
+  }
+  co_return utils::parseJsonAs<ServerInformation>(
+      body, "server", arena->storage());
+}
+
+std::future<ServerInformation> OutlineClient::getServerInformationTypedAsync() {
+  return getServerInformationTypedAsync(boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coSetServerName(
+    std::string serverName) {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::SetServerName>();
+  utils::JsonWriter body = arena->writeBody();
+  body.beginObject().field("name", serverName).endObject();
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::SetServerName, target, body.str());
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to set server name (status=" + std::to_string(status) + ")",
+        status);
+  }
 }
 
 std::future<void> OutlineClient::setServerNameAsync(
     const std::string& serverName) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, serverName]() -> boost::asio::awaitable<void> {
-        auto url = utils::appendUrl(m_apiUrl,
-                                    std::string(api::Endpoints::SetServerName));
-        boost::json::object serverObj{{"name", serverName}};
-        auto [status, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(serverObj));
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to set server name (status=" + std::to_string(status) +
-              ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return setServerNameAsync(serverName, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coSetHostName(
+    std::string hostName) {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::SetHostName>();
+  utils::JsonWriter body = arena->writeBody();
+  body.beginObject().field("hostname", hostName).endObject();
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::SetHostName, target, body.str());
+  if (status != 204) {
+    throw OutlineServerErrorException("Unable to set host name (status=" +
+                                      std::to_string(status) + ")",
+                                      status);
+  }
+  // The access URL of every cached key names the old host.
+  m_accessKeyCache.clear();
 }
 
 std::future<void> OutlineClient::setHostNameAsync(const std::string& hostName) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, hostName]() -> boost::asio::awaitable<void> {
-        auto url = utils::appendUrl(m_apiUrl,
-                                    std::string(api::Endpoints::SetHostName));
-        boost::json::object hostObj{{"hostname", hostName}};
-        auto [status, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(hostObj));
-        if (status != 204) {
-          throw OutlineServerErrorException("Unable to set host name (status=" +
-                                            std::to_string(status) + ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return setHostNameAsync(hostName, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coSetDefaultPort(int port) {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::SetDefaultPort>();
+  utils::JsonWriter body = arena->writeBody();
+  body.beginObject().field("port", port).endObject();
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::SetDefaultPort, target, body.str());
+  if (status == 400) {
+    throw OutlineServerErrorException(
+        "The requested port isn't valid or missing.", status);
+  }
+  if (status == 409) {
+    throw OutlineServerErrorException(
+        "The requested port is already in use.", status);
+  }
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to set default port (status=" + std::to_string(status) + ")",
+        status);
+  }
+  // The access URL of every cached key names the old port.
+  m_accessKeyCache.clear();
 }
 
 std::future<void> OutlineClient::setDefaultPortAsync(int port) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, port]() -> boost::asio::awaitable<void> {
-        auto url = utils::appendUrl(
-            m_apiUrl, std::string(api::Endpoints::SetDefaultPort));
-        boost::json::object portObj{{"port", port}};
-        auto [status, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(portObj));
-        if (status == 400) {
-          throw OutlineServerErrorException(
-              "The requested port isn't valid or missing.");
-        }
-        if (status == 409) {
-          throw OutlineServerErrorException(
-              "The requested port is already in use.");
-        }
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to set default port (status=" + std::to_string(status) +
-              ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return setDefaultPortAsync(port, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void> OutlineClient::coSetDataLimitForAllAccessKeys(
+    int dataLimitBytes) {
+  auto arena = m_arenas.acquire();
+  auto target = routeTarget<api::Endpoints::SetDataLimitForAllAccessKeys>();
+  utils::JsonWriter body = arena->writeBody();
+  body.beginObject().field("bytes", dataLimitBytes).endObject();
+  auto [status, responseBody] = co_await doPutAsync(
+      api::EndpointId::SetDataLimitForAllAccessKeys, target, body.str());
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to set data limit for all (status=" +
+        std::to_string(status) + ")",
+        status);
+  }
 }
 
 std::future<void> OutlineClient::setDataLimitForAllAccessKeysAsync(
     int dataLimitBytes) {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this, dataLimitBytes]() -> boost::asio::awaitable<void> {
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            std::string(api::Endpoints::SetDataLimitForAllAccessKeys));
-        boost::json::object dataLimitObj{{"bytes", dataLimitBytes}};
-        auto [status, responseBody] =
-            co_await doPutAsync(url, boost::json::serialize(dataLimitObj));
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to set data limit for all (status=" +
-              std::to_string(status) + ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return setDataLimitForAllAccessKeysAsync(
+      dataLimitBytes, boost::asio::use_future);
+}
+
+boost::asio::awaitable<void>
+OutlineClient::coDeleteDataLimitForAllAccessKeys() {
+  auto target = routeTarget<api::Endpoints::DeleteDataLimitForAllAccessKeys>();
+  auto [status, responseBody] = co_await doDeleteAsync(
+      api::EndpointId::DeleteDataLimitForAllAccessKeys, target);
+  if (status != 204) {
+    throw OutlineServerErrorException(
+        "Unable to delete data limit for all (status=" +
+        std::to_string(status) + ")",
+        status);
+  }
 }
 
 std::future<void> OutlineClient::deleteDataLimitForAllAccessKeysAsync() {
-  return boost::asio::co_spawn(
-      m_ioContext,
-      [this]() -> boost::asio::awaitable<void> {
-        auto url = utils::appendUrl(
-            m_apiUrl,
-            std::string(api::Endpoints::DeleteDataLimitForAllAccessKeys));
-        auto [status, responseBody] = co_await doDeleteAsync(url);
-        if (status != 204) {
-          throw OutlineServerErrorException(
-              "Unable to delete data limit for all (status=" +
-              std::to_string(status) + ")");
-        }
-        co_return;
-      },
-      boost::asio::use_future);
+  return deleteDataLimitForAllAccessKeysAsync(boost::asio::use_future);
+}
+
+ServerInformation OutlineClient::getServerInformationTyped() {
+    return getServerInformationTypedAsync().get();
 }
 
 void OutlineClient::setServerName(const std::string& serverName) {
@@ -0,0 +1,118 @@
+#include "outline/OutlineFleet.h"
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace outline {
+
+OutlineFleet::OutlineFleet(const std::vector<FleetServer>& servers,
+                           const FleetOptions& options)
+    : m_options(options),
+      m_runtime(std::make_shared<network::IoRuntime>(options.runtime)) {
+  OutlineClientOptions clientOptions = options.client;
+  clientOptions.sharedRuntime = m_runtime;
+  m_apiUrls.reserve(servers.size());
+  m_clients.reserve(servers.size());
+  for (const FleetServer& server : servers) {
+    m_apiUrls.push_back(server.apiUrl);
+    m_clients.push_back(std::make_unique<OutlineClient>(
+        server.apiUrl, server.cert, options.timeout, clientOptions));
+  }
+}
+
+OutlineFleet::~OutlineFleet() {
+  m_runtime->stop();
+  // Pooled sockets are closed while their io_context still exists, then the
+  // coroutines which never finished are destroyed while their clients do.
+  for (auto& client : m_clients) {
+    client->closeIdleConnections();
+  }
+  m_runtime->shutdown();
+}
+
+template <typename T>
+std::future<std::vector<FleetResult<T>>> OutlineFleet::fanOut(
+    boost::asio::awaitable<T> (OutlineClient::*operation)(),
+    ResultCallback<T> onResult) {
+  struct State {
+    std::vector<FleetResult<T>> results;
+    std::atomic<std::size_t> remaining{0};
+    std::promise<std::vector<FleetResult<T>>> promise;
+    ResultCallback<T> onResult;
+    std::mutex callbackMutex;
+  };
+  auto state = std::make_shared<State>();
+  auto future = state->promise.get_future();
+  if (m_clients.empty()) {
+    state->promise.set_value({});
+    return future;
+  }
+  state->results.resize(m_clients.size());
+  state->remaining = m_clients.size();
+  state->onResult = std::move(onResult);
+
+  for (std::size_t i = 0; i < m_clients.size(); ++i) {
+    state->results[i].index = i;
+    state->results[i].apiUrl = m_apiUrls[i];
+    OutlineClient& client = *m_clients[i];
+    boost::asio::co_spawn(
+        m_runtime->nextExecutor(),
+        client.coWithTimeout((client.*operation)(), m_options.serverTimeout),
+        [state, i](std::exception_ptr error, T value) {
+          FleetResult<T>& result = state->results[i];
+          if (error) {
+            result.error = error;
+          } else {
+            result.value = std::move(value);
+          }
+          if (state->onResult) {
+            std::lock_guard<std::mutex> lock(state->callbackMutex);
+            try {
+              state->onResult(result);
+            } catch (...) {
+              // A failing callback must not lose the other answers.
+            }
+          }
+          if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            state->promise.set_value(std::move(state->results));
+          }
+        });
+  }
+  return future;
+}
+
+std::future<std::vector<FleetResult<ServerInformation>>>
+OutlineFleet::getServerInformationAsync(
+    ResultCallback<ServerInformation> onResult) {
+  return fanOut(&OutlineClient::coGetServerInformationTyped,
+                std::move(onResult));
+}
+
+std::future<std::vector<FleetResult<TransferMetrics>>>
+OutlineFleet::getMetricsAsync(ResultCallback<TransferMetrics> onResult) {
+  return fanOut(&OutlineClient::coGetMetricsTyped, std::move(onResult));
+}
+
+std::future<std::vector<FleetResult<std::vector<AccessKey>>>>
+OutlineFleet::getAccessKeysAsync(
+    ResultCallback<std::vector<AccessKey>> onResult) {
+  return fanOut(&OutlineClient::coGetAccessKeysTyped, std::move(onResult));
+}
+
+std::vector<FleetResult<ServerInformation>>
+OutlineFleet::getServerInformation() {
+  return getServerInformationAsync().get();
+}
+
+std::vector<FleetResult<TransferMetrics>> OutlineFleet::getMetrics() {
+  return getMetricsAsync().get();
+}
+
+std::vector<FleetResult<std::vector<AccessKey>>>
+OutlineFleet::getAccessKeys() {
+  return getAccessKeysAsync().get();
+}
+
+}  // namespace outline
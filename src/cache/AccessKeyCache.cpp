@@ -0,0 +1,101 @@
+#include "outline/cache/AccessKeyCache.h"
+
+#include <iterator>
+
+namespace outline {
+namespace cache {
+
+AccessKeyCache::AccessKeyCache(const AccessKeyCacheOptions& options)
+    : m_options(options) {}
+
+std::optional<std::pair<int, std::string>> AccessKeyCache::find(
+    const std::string& accessKeyId) {
+  if (!m_options.enabled) {
+    return std::nullopt;
+  }
+  int status = 0;
+  std::shared_ptr<const std::string> body;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(accessKeyId);
+    if (it != m_entries.end() &&
+        std::chrono::steady_clock::now() < it->second.expiresAt) {
+      status = it->second.status;
+      body = it->second.body;
+    }
+  }
+  if (!body) {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+  if (status == 404) {
+    m_negativeHits.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+  }
+  return std::make_pair(status, *body);
+}
+
+std::uint64_t AccessKeyCache::generation() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_generation;
+}
+
+void AccessKeyCache::store(const std::string& accessKeyId, int status,
+                           const std::string& body,
+                           std::uint64_t generation) {
+  if (!m_options.enabled || (status != 200 && status != 404)) {
+    return;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  auto entryBody = std::make_shared<const std::string>(body);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (generation != m_generation) {
+    return;
+  }
+  if (m_entries.size() >= m_options.maxEntries &&
+      m_entries.find(accessKeyId) == m_entries.end()) {
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+      it = now < it->second.expiresAt ? std::next(it) : m_entries.erase(it);
+    }
+    if (m_entries.size() >= m_options.maxEntries) {
+      return;
+    }
+  }
+  Entry& entry = m_entries[accessKeyId];
+  entry.status = status;
+  entry.body = std::move(entryBody);
+  entry.expiresAt =
+      now + (status == 404 ? m_options.negativeTtl : m_options.ttl);
+}
+
+void AccessKeyCache::invalidate(const std::string& accessKeyId) {
+  if (!m_options.enabled) {
+    return;
+  }
+  m_invalidations.fetch_add(1, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_generation;
+  m_entries.erase(accessKeyId);
+  m_entries.erase(kAllKeys);
+}
+
+void AccessKeyCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_generation;
+  m_entries.clear();
+}
+
+AccessKeyCacheStats AccessKeyCache::stats() const {
+  AccessKeyCacheStats stats;
+  stats.hits = m_hits.load(std::memory_order_relaxed);
+  stats.negativeHits = m_negativeHits.load(std::memory_order_relaxed);
+  stats.misses = m_misses.load(std::memory_order_relaxed);
+  stats.invalidations = m_invalidations.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  stats.entries = m_entries.size();
+  return stats;
+}
+
+}  // namespace cache
+}  // namespace outline
@@ -0,0 +1,217 @@
+#include "outline/metrics/ClientStats.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string_view>
+
+namespace outline {
+namespace metrics {
+
+namespace {
+
+constexpr std::string_view kPrefix = "outline_client_";
+
+/// Bounds of the exported latency histogram in microseconds.
+constexpr std::array<std::int64_t, 14> kLatencyBounds = {
+    1000,   2500,    5000,    10000,   25000,   50000,   100000,
+    250000, 500000, 1000000, 2500000, 5000000, 10000000, 30000000};
+
+void header(std::ostringstream& out, std::string_view name,
+            std::string_view type, std::string_view help) {
+  out << "# HELP " << kPrefix << name << ' ' << help << '\n'
+      << "# TYPE " << kPrefix << name << ' ' << type << '\n';
+}
+
+template <typename T>
+void sample(std::ostringstream& out, std::string_view name, T value) {
+  out << kPrefix << name << ' ' << value << '\n';
+}
+
+bool used(const EndpointStats& endpoint) {
+  return endpoint.latency.count != 0 || endpoint.inFlight != 0;
+}
+
+}  // namespace
+
+std::string toPrometheus(const ClientStats& stats) {
+  std::ostringstream out;
+  out.precision(12);
+
+  header(out, "responses_total", "counter",
+         "Responses received, by endpoint and HTTP status code.");
+  for (const EndpointStats& endpoint : stats.endpoints) {
+    for (const auto& [status, count] : endpoint.responsesByStatus) {
+      out << kPrefix << "responses_total{endpoint=\"" << endpoint.name
+          << "\",code=\"" << status << "\"} " << count << '\n';
+    }
+  }
+
+  header(out, "request_failures_total", "counter",
+         "Attempts which ended without a response.");
+  for (const EndpointStats& endpoint : stats.endpoints) {
+    if (!used(endpoint)) {
+      continue;
+    }
+    out << kPrefix << "request_failures_total{endpoint=\"" << endpoint.name
+        << "\",reason=\"timeout\"} " << endpoint.timeouts << '\n'
+        << kPrefix << "request_failures_total{endpoint=\"" << endpoint.name
+        << "\",reason=\"error\"} " << endpoint.failures << '\n';
+  }
+
+  header(out, "request_duration_seconds", "histogram",
+         "Time from sending an attempt to its response or failure.");
+  for (const EndpointStats& endpoint : stats.endpoints) {
+    if (!used(endpoint)) {
+      continue;
+    }
+    const std::string labels =
+        "endpoint=\"" + std::string(endpoint.name) + "\"";
+    for (std::int64_t bound : kLatencyBounds) {
+      out << kPrefix << "request_duration_seconds_bucket{" << labels
+          << ",le=\"" << static_cast<double>(bound) / 1e6 << "\"} "
+          << endpoint.latency.countAtOrBelow(std::chrono::microseconds(bound))
+          << '\n';
+    }
+    out << kPrefix << "request_duration_seconds_bucket{" << labels
+        << ",le=\"+Inf\"} " << endpoint.latency.count << '\n'
+        << kPrefix << "request_duration_seconds_sum{" << labels << "} "
+        << static_cast<double>(endpoint.latency.sumMicros) / 1e6 << '\n'
+        << kPrefix << "request_duration_seconds_count{" << labels << "} "
+        << endpoint.latency.count << '\n';
+  }
+
+  header(out, "sent_bytes_total", "counter", "Request body bytes sent.");
+  for (const EndpointStats& endpoint : stats.endpoints) {
+    if (used(endpoint)) {
+      out << kPrefix << "sent_bytes_total{endpoint=\"" << endpoint.name
+          << "\"} " << endpoint.bytesSent << '\n';
+    }
+  }
+  header(out, "received_bytes_total", "counter",
+         "Response body bytes received.");
+  for (const EndpointStats& endpoint : stats.endpoints) {
+    if (used(endpoint)) {
+      out << kPrefix << "received_bytes_total{endpoint=\"" << endpoint.name
+          << "\"} " << endpoint.bytesReceived << '\n';
+    }
+  }
+  header(out, "in_flight_requests", "gauge", "Attempts in flight.");
+  for (const EndpointStats& endpoint : stats.endpoints) {
+    if (used(endpoint)) {
+      out << kPrefix << "in_flight_requests{endpoint=\"" << endpoint.name
+          << "\"} " << endpoint.inFlight << '\n';
+    }
+  }
+
+  header(out, "pool_hits_total", "counter",
+         "Requests served by an idle keep-alive connection.");
+  sample(out, "pool_hits_total", stats.connectionPool.hits);
+  header(out, "pool_misses_total", "counter",
+         "Requests which opened a new connection.");
+  sample(out, "pool_misses_total", stats.connectionPool.misses);
+  header(out, "pool_idle_connections", "gauge",
+         "Connections idle in the pool.");
+  sample(out, "pool_idle_connections", stats.connectionPool.idle);
+  header(out, "tls_handshakes_total", "counter",
+         "TLS handshakes, by whether the session was resumed.");
+  out << kPrefix << "tls_handshakes_total{resumed=\"false\"} "
+      << stats.tls.fullHandshakes << '\n'
+      << kPrefix << "tls_handshakes_total{resumed=\"true\"} "
+      << stats.tls.resumedHandshakes << '\n';
+  header(out, "dns_lookups_total", "counter",
+         "Host lookups, by how the resolver cache served them.");
+  out << kPrefix << "dns_lookups_total{result=\"hit\"} " << stats.dns.hits
+      << '\n'
+      << kPrefix << "dns_lookups_total{result=\"stale\"} "
+      << stats.dns.staleHits << '\n'
+      << kPrefix << "dns_lookups_total{result=\"miss\"} " << stats.dns.misses
+      << '\n';
+  header(out, "connects_total", "counter",
+         "Connections opened, by whether the first address answered, or "
+         "failed.");
+  out << kPrefix << "connects_total{result=\"first\"} "
+      << stats.connect.connects - stats.connect.fallbacks << '\n'
+      << kPrefix << "connects_total{result=\"fallback\"} "
+      << stats.connect.fallbacks << '\n'
+      << kPrefix << "connects_total{result=\"failed\"} "
+      << stats.connect.failures << '\n';
+  header(out, "connect_attempts_total", "counter",
+         "TCP connection attempts, several per connect while addresses race.");
+  sample(out, "connect_attempts_total", stats.connect.attempts);
+  header(out, "connect_attempt_failures_total", "counter",
+         "TCP connection attempts which failed.");
+  sample(out, "connect_attempt_failures_total", stats.connect.failedAttempts);
+  header(out, "compressed_responses_total", "counter",
+         "Responses which arrived gzip or deflate encoded.");
+  sample(out, "compressed_responses_total",
+         stats.compression.compressedResponses);
+  header(out, "compressed_response_bytes_total", "counter",
+         "Body bytes of compressed responses, as received and inflated.");
+  out << kPrefix << "compressed_response_bytes_total{stage=\"wire\"} "
+      << stats.compression.compressedBytes << '\n'
+      << kPrefix << "compressed_response_bytes_total{stage=\"inflated\"} "
+      << stats.compression.inflatedBytes << '\n';
+  header(out, "retries_total", "counter",
+         "Attempts made after a failed one.");
+  sample(out, "retries_total", stats.retry.retries);
+  header(out, "retries_exhausted_total", "counter",
+         "Requests which still failed after the last attempt.");
+  sample(out, "retries_exhausted_total", stats.retry.exhausted);
+  header(out, "circuit_state", "gauge",
+         "Circuit breaker state: 0 closed, 1 open, 2 half-open.");
+  sample(out, "circuit_state", static_cast<int>(stats.circuitBreaker.state));
+  header(out, "circuit_rejected_total", "counter",
+         "Requests rejected by the open circuit breaker.");
+  sample(out, "circuit_rejected_total", stats.circuitBreaker.rejected);
+  header(out, "rate_limiter_requests_total", "counter",
+         "Requests which passed the rate limiter, by whether they waited, "
+         "or were rejected.");
+  out << kPrefix << "rate_limiter_requests_total{result=\"immediate\"} "
+      << stats.rateLimiter.acquired - stats.rateLimiter.delayed << '\n'
+      << kPrefix << "rate_limiter_requests_total{result=\"delayed\"} "
+      << stats.rateLimiter.delayed << '\n'
+      << kPrefix << "rate_limiter_requests_total{result=\"rejected\"} "
+      << stats.rateLimiter.rejected << '\n';
+  header(out, "rate_limiter_queue_depth", "gauge",
+         "Requests waiting for a rate limiter token.");
+  sample(out, "rate_limiter_queue_depth", stats.rateLimiter.queueDepth);
+  header(out, "rate_limiter_wait_seconds", "histogram",
+         "Time delayed requests waited for a token.");
+  for (std::int64_t bound : kLatencyBounds) {
+    out << kPrefix << "rate_limiter_wait_seconds_bucket{le=\""
+        << static_cast<double>(bound) / 1e6 << "\"} "
+        << stats.rateLimiter.waits.countAtOrBelow(
+               std::chrono::microseconds(bound))
+        << '\n';
+  }
+  out << kPrefix << "rate_limiter_wait_seconds_bucket{le=\"+Inf\"} "
+      << stats.rateLimiter.waits.count << '\n';
+  sample(out, "rate_limiter_wait_seconds_sum",
+         static_cast<double>(stats.rateLimiter.waits.sumMicros) / 1e6);
+  sample(out, "rate_limiter_wait_seconds_count",
+         stats.rateLimiter.waits.count);
+  header(out, "coalesced_gets_total", "counter",
+         "GET calls, by whether they sent a request or shared one already "
+         "in flight.");
+  out << kPrefix << "coalesced_gets_total{result=\"sent\"} "
+      << stats.coalescing.sent << '\n'
+      << kPrefix << "coalesced_gets_total{result=\"shared\"} "
+      << stats.coalescing.coalesced << '\n';
+  header(out, "coalesced_gets_in_flight", "gauge",
+         "GET requests in flight which other calls may join.");
+  sample(out, "coalesced_gets_in_flight", stats.coalescing.inFlight);
+  header(out, "access_key_cache_lookups_total", "counter",
+         "Access key cache lookups, by result.");
+  out << kPrefix << "access_key_cache_lookups_total{result=\"hit\"} "
+      << stats.accessKeyCache.hits << '\n'
+      << kPrefix << "access_key_cache_lookups_total{result=\"negative\"} "
+      << stats.accessKeyCache.negativeHits << '\n'
+      << kPrefix << "access_key_cache_lookups_total{result=\"miss\"} "
+      << stats.accessKeyCache.misses << '\n';
+  return out.str();
+}
+
+}  // namespace metrics
+}  // namespace outline
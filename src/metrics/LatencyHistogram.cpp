@@ -0,0 +1,88 @@
+#include "outline/metrics/LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace outline {
+namespace metrics {
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  const auto micros = static_cast<std::uint64_t>(std::max<std::int64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count(),
+      0));
+  m_buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sumMicros.fetch_add(micros, std::memory_order_relaxed);
+  std::uint64_t max = m_maxMicros.load(std::memory_order_relaxed);
+  while (micros > max && !m_maxMicros.compare_exchange_weak(
+                             max, micros, std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.buckets.resize(kBucketCount);
+  for (std::size_t i = 0; i < kBucketCount; ++i) {
+    snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    // Summed from the buckets, so the count always matches them even while
+    // requests are being recorded.
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.sumMicros = m_sumMicros.load(std::memory_order_relaxed);
+  snapshot.maxMicros = m_maxMicros.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t micros) {
+  micros = std::min<std::uint64_t>(micros, (std::uint64_t{1} << kMaxBits) - 1);
+  if (micros < kSubBuckets) {
+    return static_cast<std::size_t>(micros);
+  }
+  const std::size_t msb = std::bit_width(micros) - 1;
+  const std::size_t shift = msb - kSubBucketBits;
+  return (msb - kSubBucketBits + 1) * kSubBuckets +
+         static_cast<std::size_t>((micros >> shift) & (kSubBuckets - 1));
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const std::size_t shift = index / kSubBuckets - 1;
+  const std::uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+  return lower + (std::uint64_t{1} << shift) - 1;
+}
+
+std::chrono::microseconds HistogramSnapshot::percentile(double q) const {
+  if (count == 0) {
+    return std::chrono::microseconds::zero();
+  }
+  const auto rank = static_cast<std::uint64_t>(
+      std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= std::max<std::uint64_t>(rank, 1)) {
+      return std::chrono::microseconds(static_cast<std::int64_t>(
+          std::min(LatencyHistogram::bucketUpperBound(i), maxMicros)));
+    }
+  }
+  return std::chrono::microseconds(static_cast<std::int64_t>(maxMicros));
+}
+
+std::uint64_t HistogramSnapshot::countAtOrBelow(
+    std::chrono::microseconds bound) const {
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < buckets.size(); ++i) {
+    if (LatencyHistogram::bucketUpperBound(i) >
+        static_cast<std::uint64_t>(bound.count())) {
+      break;
+    }
+    total += buckets[i];
+  }
+  return total;
+}
+
+}  // namespace metrics
+}  // namespace outline
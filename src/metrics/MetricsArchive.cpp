@@ -0,0 +1,579 @@
+#include "outline/metrics/MetricsArchive.h"
+#include "outline/exceptions/OutlineExceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace outline {
+namespace metrics {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'L', 'M', 'A', 'R', 'C', 'H', '1'};
+constexpr std::uint32_t kVersion = 1;
+/// The file grows at least by this much, so appends rarely remap it.
+constexpr std::size_t kMinMapping = 1 << 20;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+  /// End of the last complete record.
+  std::uint64_t used;
+};
+
+enum class RecordType : std::uint32_t { Keys = 1, Block = 2 };
+
+struct RecordHeader {
+  RecordType type;
+  std::uint32_t reserved;
+  /// Payload bytes, a multiple of 8 so that every record stays aligned.
+  std::uint64_t size;
+};
+
+/**
+ * @brief Start of a block record. It is followed by the columns:
+ *        std::int64_t timestamps[capacity] in Unix milliseconds,
+ *        std::uint64_t lastCounters[keys] and
+ *        std::uint64_t deltas[keys][capacity].
+ */
+struct BlockHeader {
+  std::uint32_t capacity;
+  std::uint32_t keys;
+  /// Samples written so far. Raised only after a sample is complete.
+  std::uint32_t samples;
+  std::uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) % 8 == 0);
+static_assert(sizeof(RecordHeader) % 8 == 0);
+static_assert(sizeof(BlockHeader) % 8 == 0);
+
+template <typename Char>
+struct BlockView {
+  using Int64 = std::conditional_t<std::is_const_v<Char>, const std::int64_t,
+                                   std::int64_t>;
+  using Uint64 = std::conditional_t<std::is_const_v<Char>,
+                                    const std::uint64_t, std::uint64_t>;
+  using Header =
+      std::conditional_t<std::is_const_v<Char>, const BlockHeader,
+                         BlockHeader>;
+
+  BlockView(Char* data, std::size_t offset)
+      : header(reinterpret_cast<Header*>(data + offset)),
+        timestamps(reinterpret_cast<Int64*>(header + 1)),
+        lastCounters(reinterpret_cast<Uint64*>(timestamps +
+                                               header->capacity)),
+        deltas(lastCounters + header->keys) {}
+
+  Header* header;
+  Int64* timestamps;
+  Uint64* lastCounters;
+  Uint64* deltas;
+};
+
+std::size_t blockSize(std::uint64_t capacity, std::uint64_t keys) {
+  return sizeof(BlockHeader) + 8 * (capacity + keys + keys * capacity);
+}
+
+std::size_t alignRecord(std::size_t size) {
+  return (size + 7) & ~std::size_t(7);
+}
+
+std::int64_t toMillis(std::chrono::system_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+std::chrono::system_clock::time_point fromMillis(std::int64_t millis) {
+  return std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::milliseconds(millis)));
+}
+
+[[noreturn]] void throwFileError(const std::string& path,
+                                 const std::string& operation) {
+  throw OutlineArchiveException(path + ": " + operation + " failed: " +
+                                std::strerror(errno));
+}
+
+[[noreturn]] void throwCorrupt(const std::string& path,
+                               const std::string& reason) {
+  throw OutlineArchiveException(path + " is not a metrics archive: " +
+                                reason);
+}
+
+/**
+ * @brief Checks the header and returns the end of the records which fit in
+ *        the mapping.
+ */
+std::size_t checkHeader(const std::string& path, const char* data,
+                        std::size_t mapped) {
+  if (mapped < sizeof(FileHeader)) {
+    throwCorrupt(path, "the file is too short");
+  }
+  const auto* header = reinterpret_cast<const FileHeader*>(data);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+    throwCorrupt(path, "wrong magic");
+  }
+  if (header->version != kVersion) {
+    throwCorrupt(path, "unsupported version " +
+                           std::to_string(header->version));
+  }
+  if (header->used < sizeof(FileHeader)) {
+    throwCorrupt(path, "bad length");
+  }
+  return std::min<std::size_t>(header->used, mapped);
+}
+
+/**
+ * @brief Calls onKey(keyId) for every dictionary entry and
+ *        onBlock(offset) for every block, in file order. A block may only
+ *        have columns for the keys listed before it.
+ */
+template <typename OnKey, typename OnBlock>
+void scanRecords(const std::string& path, const char* data, std::size_t used,
+                 OnKey&& onKey, OnBlock&& onBlock) {
+  std::size_t offset = sizeof(FileHeader);
+  std::size_t keys = 0;
+  while (offset + sizeof(RecordHeader) <= used) {
+    const auto* record = reinterpret_cast<const RecordHeader*>(data + offset);
+    const std::size_t payload = offset + sizeof(RecordHeader);
+    if (record->size > used - payload || record->size % 8 != 0) {
+      throwCorrupt(path, "truncated record");
+    }
+    const char* begin = data + payload;
+    const char* end = begin + record->size;
+    if (record->type == RecordType::Keys) {
+      std::uint32_t count = 0;
+      if (end - begin < 8) {
+        throwCorrupt(path, "truncated key record");
+      }
+      std::memcpy(&count, begin, sizeof(count));
+      const char* cursor = begin + 8;
+      for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint32_t length = 0;
+        if (end - cursor < 4) {
+          throwCorrupt(path, "truncated key record");
+        }
+        std::memcpy(&length, cursor, sizeof(length));
+        cursor += sizeof(length);
+        if (static_cast<std::size_t>(end - cursor) < length) {
+          throwCorrupt(path, "truncated key record");
+        }
+        onKey(std::string(cursor, length));
+        cursor += length;
+        ++keys;
+      }
+    } else if (record->type == RecordType::Block) {
+      const auto* block = reinterpret_cast<const BlockHeader*>(begin);
+      if (record->size < sizeof(BlockHeader) ||
+          record->size != blockSize(block->capacity, block->keys) ||
+          block->samples > block->capacity || block->keys > keys) {
+        throwCorrupt(path, "malformed block");
+      }
+      onBlock(payload);
+    } else {
+      throwCorrupt(path, "unknown record type");
+    }
+    offset = payload + record->size;
+  }
+}
+
+/**
+ * @brief Sums adjacent counters. The four independent lanes map onto SIMD
+ *        additions even at -O2, where the compiler does not vectorize a
+ *        plain reduction loop of unknown length.
+ */
+std::uint64_t sumRange(const std::uint64_t* values, std::size_t count) {
+  std::uint64_t lanes[4] = {0, 0, 0, 0};
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    lanes[0] += values[i];
+    lanes[1] += values[i + 1];
+    lanes[2] += values[i + 2];
+    lanes[3] += values[i + 3];
+  }
+  std::uint64_t total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < count; ++i) {
+    total += values[i];
+  }
+  return total;
+}
+
+}  // namespace
+
+MetricsArchiveWriter::MetricsArchiveWriter(
+    const std::string& path, const MetricsArchiveOptions& options)
+    : m_path(path), m_options(options) {
+  m_options.samplesPerBlock = std::max<std::uint32_t>(
+      m_options.samplesPerBlock, 1);
+  m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (m_fd < 0) {
+    throwFileError(path, "open");
+  }
+  try {
+    struct stat status {};
+    if (::fstat(m_fd, &status) != 0) {
+      throwFileError(path, "stat");
+    }
+    if (status.st_size == 0) {
+      map(kMinMapping);
+      auto* header = reinterpret_cast<FileHeader*>(m_data);
+      std::memcpy(header->magic, kMagic, sizeof(kMagic));
+      header->version = kVersion;
+      header->used = m_used = sizeof(FileHeader);
+    } else {
+      map(static_cast<std::size_t>(status.st_size));
+      load();
+    }
+  } catch (...) {
+    unmap();
+    ::close(m_fd);
+    throw;
+  }
+}
+
+MetricsArchiveWriter::~MetricsArchiveWriter() {
+  unmap();
+  // Errors are ignored: the records are complete either way.
+  [[maybe_unused]] int result =
+      ::ftruncate(m_fd, static_cast<off_t>(m_used));
+  ::close(m_fd);
+}
+
+void MetricsArchiveWriter::append(const TransferMetrics& snapshot,
+                                  Clock::time_point time) {
+  const std::int64_t timestamp = std::max(toMillis(time), m_lastTimestamp);
+  std::vector<std::string> added;
+  for (const auto& [keyId, counter] : snapshot.bytesTransferredByUserId) {
+    if (m_keyNumbers.find(keyId) == m_keyNumbers.end()) {
+      added.push_back(keyId);
+    }
+  }
+  if (!added.empty()) {
+    std::sort(added.begin(), added.end());
+    appendKeys(added);
+  }
+  if (m_block == 0) {
+    openBlock();
+  } else {
+    BlockView<char> current(m_data, m_block);
+    if (current.header->samples == current.header->capacity ||
+        current.header->keys < m_lastCounters.size()) {
+      openBlock();
+    }
+  }
+
+  BlockView<char> block(m_data, m_block);
+  const std::uint32_t sample = block.header->samples;
+  const std::size_t capacity = block.header->capacity;
+  const bool baseline = m_samples == 0;
+  block.timestamps[sample] = timestamp;
+  for (const auto& [keyId, counter] : snapshot.bytesTransferredByUserId) {
+    const std::uint32_t key = m_keyNumbers.find(keyId)->second;
+    std::uint64_t& last = m_lastCounters[key];
+    // A counter which went down was reset and counts from zero again.
+    const std::uint64_t delta =
+        baseline ? 0 : (counter >= last ? counter - last : counter);
+    block.deltas[key * capacity + sample] = delta;
+    block.lastCounters[key] = counter;
+    last = counter;
+  }
+  block.header->samples = sample + 1;
+  m_lastTimestamp = timestamp;
+  ++m_samples;
+}
+
+void MetricsArchiveWriter::flush() {
+  if (::msync(m_data, m_used, MS_SYNC) != 0) {
+    throwFileError(m_path, "msync");
+  }
+}
+
+void MetricsArchiveWriter::map(std::size_t size) {
+  unmap();
+  if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+    throwFileError(m_path, "resize");
+  }
+  void* data =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED) {
+    throwFileError(m_path, "mmap");
+  }
+  m_data = static_cast<char*>(data);
+  m_mapped = size;
+}
+
+void MetricsArchiveWriter::unmap() {
+  if (m_data != nullptr) {
+    ::munmap(m_data, m_mapped);
+    m_data = nullptr;
+    m_mapped = 0;
+  }
+}
+
+void MetricsArchiveWriter::reserve(std::size_t size) {
+  if (m_used + size > m_mapped) {
+    // Offsets rather than pointers are kept, so remapping is safe.
+    map(std::max({m_mapped * 2, m_used + size, kMinMapping}));
+  }
+}
+
+void MetricsArchiveWriter::load() {
+  m_used = checkHeader(m_path, m_data, m_mapped);
+  scanRecords(
+      m_path, m_data, m_used,
+      [this](std::string keyId) {
+        m_keyNumbers.emplace(std::move(keyId),
+                             static_cast<std::uint32_t>(
+                                 m_lastCounters.size()));
+        m_lastCounters.push_back(0);
+      },
+      [this](std::size_t offset) {
+        BlockView<const char> block(m_data, offset);
+        m_block = offset;
+        m_samples += block.header->samples;
+        if (block.header->samples > 0) {
+          m_lastTimestamp = block.timestamps[block.header->samples - 1];
+        }
+      });
+  if (m_block != 0) {
+    BlockView<const char> block(m_data, m_block);
+    std::copy_n(block.lastCounters, block.header->keys,
+                m_lastCounters.begin());
+  }
+  // A record cut off by a crash is overwritten by the next one.
+  reinterpret_cast<FileHeader*>(m_data)->used = m_used;
+}
+
+void MetricsArchiveWriter::appendKeys(const std::vector<std::string>& keyIds) {
+  std::size_t size = 8;
+  for (const std::string& keyId : keyIds) {
+    size += sizeof(std::uint32_t) + keyId.size();
+  }
+  size = alignRecord(size);
+  reserve(sizeof(RecordHeader) + size);
+
+  auto* record = reinterpret_cast<RecordHeader*>(m_data + m_used);
+  record->type = RecordType::Keys;
+  record->size = size;
+  char* cursor = m_data + m_used + sizeof(RecordHeader);
+  const auto count = static_cast<std::uint32_t>(keyIds.size());
+  std::memcpy(cursor, &count, sizeof(count));
+  cursor += 8;
+  for (const std::string& keyId : keyIds) {
+    const auto length = static_cast<std::uint32_t>(keyId.size());
+    std::memcpy(cursor, &length, sizeof(length));
+    cursor += sizeof(length);
+    std::memcpy(cursor, keyId.data(), keyId.size());
+    cursor += keyId.size();
+    m_keyNumbers.emplace(keyId,
+                         static_cast<std::uint32_t>(m_lastCounters.size()));
+    m_lastCounters.push_back(0);
+  }
+  m_used += sizeof(RecordHeader) + size;
+  reinterpret_cast<FileHeader*>(m_data)->used = m_used;
+}
+
+void MetricsArchiveWriter::openBlock() {
+  const std::uint32_t capacity = m_options.samplesPerBlock;
+  const auto keys = static_cast<std::uint32_t>(m_lastCounters.size());
+  const std::size_t size = blockSize(capacity, keys);
+  reserve(sizeof(RecordHeader) + size);
+
+  auto* record = reinterpret_cast<RecordHeader*>(m_data + m_used);
+  record->type = RecordType::Block;
+  record->size = size;
+  const std::size_t offset = m_used + sizeof(RecordHeader);
+  auto* header = reinterpret_cast<BlockHeader*>(m_data + offset);
+  header->capacity = capacity;
+  header->keys = keys;
+  header->samples = 0;
+  BlockView<char> block(m_data, offset);
+  // The space may hold the rest of a record cut off by a crash, and a key
+  // missing from a sample must read as no traffic.
+  std::memset(block.deltas, 0,
+              std::size_t(capacity) * keys * sizeof(std::uint64_t));
+  // Keys missing from a sample keep their counter.
+  std::copy(m_lastCounters.begin(), m_lastCounters.end(),
+            block.lastCounters);
+  m_block = offset;
+  m_used = offset + size;
+  reinterpret_cast<FileHeader*>(m_data)->used = m_used;
+}
+
+MetricsArchiveReader::MetricsArchiveReader(const std::string& path) {
+  m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (m_fd < 0) {
+    throwFileError(path, "open");
+  }
+  try {
+    struct stat status {};
+    if (::fstat(m_fd, &status) != 0) {
+      throwFileError(path, "stat");
+    }
+    m_mapped = static_cast<std::size_t>(status.st_size);
+    if (m_mapped < sizeof(FileHeader)) {
+      throwCorrupt(path, "the file is too short");
+    }
+    void* data = ::mmap(nullptr, m_mapped, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+      throwFileError(path, "mmap");
+    }
+    m_data = static_cast<const char*>(data);
+
+    const std::size_t used = checkHeader(path, m_data, m_mapped);
+    scanRecords(
+        path, m_data, used,
+        [this](std::string keyId) {
+          m_keyNumbers.emplace(keyId,
+                               static_cast<std::uint32_t>(m_keys.size()));
+          m_keys.push_back(std::move(keyId));
+        },
+        [this](std::size_t offset) {
+          BlockView<const char> view(m_data, offset);
+          Block block;
+          block.timestamps = view.timestamps;
+          block.deltas = view.deltas;
+          block.capacity = view.header->capacity;
+          block.keys = view.header->keys;
+          // Later samples of a block being written are not seen.
+          block.samples = view.header->samples;
+          if (block.samples > 0) {
+            m_blocks.push_back(block);
+            m_samples += block.samples;
+          }
+        });
+  } catch (...) {
+    if (m_data != nullptr) {
+      ::munmap(const_cast<char*>(m_data), m_mapped);
+    }
+    ::close(m_fd);
+    throw;
+  }
+}
+
+MetricsArchiveReader::~MetricsArchiveReader() {
+  ::munmap(const_cast<char*>(m_data), m_mapped);
+  ::close(m_fd);
+}
+
+std::optional<MetricsArchiveReader::Clock::time_point>
+MetricsArchiveReader::firstSample() const {
+  if (m_blocks.empty()) {
+    return std::nullopt;
+  }
+  return fromMillis(m_blocks.front().timestamps[0]);
+}
+
+std::optional<MetricsArchiveReader::Clock::time_point>
+MetricsArchiveReader::lastSample() const {
+  if (m_blocks.empty()) {
+    return std::nullopt;
+  }
+  const Block& block = m_blocks.back();
+  return fromMillis(block.timestamps[block.samples - 1]);
+}
+
+template <typename Visit>
+void MetricsArchiveReader::forEachRange(Clock::time_point from,
+                                        Clock::time_point to,
+                                        Visit&& visit) const {
+  const std::int64_t begin = toMillis(from);
+  const std::int64_t end = toMillis(to);
+  if (begin >= end) {
+    return;
+  }
+  // Blocks are in time order, so the ones before the range are skipped by
+  // a binary search as well.
+  auto it = std::partition_point(
+      m_blocks.begin(), m_blocks.end(), [begin](const Block& block) {
+        return block.timestamps[block.samples - 1] < begin;
+      });
+  for (; it != m_blocks.end() && it->timestamps[0] < end; ++it) {
+    const std::int64_t* timestamps = it->timestamps;
+    const std::int64_t* last = timestamps + it->samples;
+    const std::size_t first =
+        std::lower_bound(timestamps, last, begin) - timestamps;
+    const std::size_t stop =
+        std::lower_bound(timestamps + first, last, end) - timestamps;
+    if (first < stop) {
+      visit(*it, first, stop);
+    }
+  }
+}
+
+std::uint64_t MetricsArchiveReader::bytesBetween(const std::string& keyId,
+                                                 Clock::time_point from,
+                                                 Clock::time_point to) const {
+  auto key = m_keyNumbers.find(keyId);
+  if (key == m_keyNumbers.end()) {
+    return 0;
+  }
+  const std::uint32_t number = key->second;
+  std::uint64_t total = 0;
+  forEachRange(from, to,
+               [number, &total](const Block& block, std::size_t first,
+                                std::size_t stop) {
+                 if (number < block.keys) {
+                   total += sumRange(
+                       block.deltas + std::size_t(number) * block.capacity +
+                           first,
+                       stop - first);
+                 }
+               });
+  return total;
+}
+
+std::vector<std::uint64_t> MetricsArchiveReader::bytesByKeyBetween(
+    Clock::time_point from, Clock::time_point to) const {
+  std::vector<std::uint64_t> totals(m_keys.size());
+  forEachRange(from, to,
+               [&totals](const Block& block, std::size_t first,
+                         std::size_t stop) {
+                 const std::uint64_t* column = block.deltas + first;
+                 for (std::uint32_t key = 0; key < block.keys; ++key) {
+                   totals[key] += sumRange(column, stop - first);
+                   column += block.capacity;
+                 }
+               });
+  return totals;
+}
+
+std::vector<std::pair<MetricsArchiveReader::Clock::time_point, std::uint64_t>>
+MetricsArchiveReader::series(const std::string& keyId, Clock::time_point from,
+                             Clock::time_point to) const {
+  std::vector<std::pair<Clock::time_point, std::uint64_t>> points;
+  auto key = m_keyNumbers.find(keyId);
+  if (key == m_keyNumbers.end()) {
+    return points;
+  }
+  const std::uint32_t number = key->second;
+  forEachRange(from, to,
+               [number, &points](const Block& block, std::size_t first,
+                                 std::size_t stop) {
+                 for (std::size_t i = first; i < stop; ++i) {
+                   const std::uint64_t bytes =
+                       number < block.keys
+                           ? block.deltas[std::size_t(number) *
+                                              block.capacity +
+                                          i]
+                           : 0;
+                   points.emplace_back(fromMillis(block.timestamps[i]),
+                                       bytes);
+                 }
+               });
+  return points;
+}
+
+}  // namespace metrics
+}  // namespace outline
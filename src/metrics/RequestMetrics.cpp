@@ -0,0 +1,107 @@
+#include "outline/metrics/RequestMetrics.h"
+
+namespace outline {
+namespace metrics {
+
+std::uint64_t EndpointStats::responses() const {
+  std::uint64_t total = 0;
+  for (const auto& [status, count] : responsesByStatus) {
+    total += count;
+  }
+  return total;
+}
+
+RequestMetrics::Recording RequestMetrics::start(api::EndpointId endpoint,
+                                                std::size_t bytesSent) {
+  Endpoint& entry = m_endpoints[static_cast<std::size_t>(endpoint)];
+  entry.bytesSent.fetch_add(bytesSent, std::memory_order_relaxed);
+  return Recording(entry);
+}
+
+std::vector<EndpointStats> RequestMetrics::snapshot() const {
+  std::vector<EndpointStats> snapshot(m_endpoints.size());
+  for (std::size_t i = 0; i < m_endpoints.size(); ++i) {
+    const Endpoint& entry = m_endpoints[i];
+    EndpointStats& stats = snapshot[i];
+    stats.endpoint = static_cast<api::EndpointId>(i);
+    stats.name = api::kEndpointNames[i];
+    for (std::size_t code = 0; code < entry.responsesByStatus.size();
+         ++code) {
+      const std::uint64_t count =
+          entry.responsesByStatus[code].load(std::memory_order_relaxed);
+      if (count != 0) {
+        stats.responsesByStatus.emplace_back(static_cast<int>(code) +
+                                                 kMinStatus,
+                                             count);
+      }
+    }
+    // Codes outside of 100-599 are reported as 0.
+    const std::uint64_t other =
+        entry.otherResponses.load(std::memory_order_relaxed);
+    if (other != 0) {
+      stats.responsesByStatus.insert(stats.responsesByStatus.begin(),
+                                     {0, other});
+    }
+    stats.timeouts = entry.timeouts.load(std::memory_order_relaxed);
+    stats.failures = entry.failures.load(std::memory_order_relaxed);
+    stats.bytesSent = entry.bytesSent.load(std::memory_order_relaxed);
+    stats.bytesReceived = entry.bytesReceived.load(std::memory_order_relaxed);
+    stats.inFlight = entry.inFlight.load(std::memory_order_relaxed);
+    stats.latency = entry.latency.snapshot();
+  }
+  return snapshot;
+}
+
+RequestMetrics::Recording::Recording(Endpoint& endpoint)
+    : m_endpoint(&endpoint), m_started(std::chrono::steady_clock::now()) {
+  m_endpoint->inFlight.fetch_add(1, std::memory_order_relaxed);
+}
+
+RequestMetrics::Recording::Recording(Recording&& other) noexcept
+    : m_endpoint(std::exchange(other.m_endpoint, nullptr)),
+      m_started(other.m_started) {}
+
+RequestMetrics::Recording::~Recording() {
+  failed();
+}
+
+void RequestMetrics::Recording::responded(int status,
+                                          std::size_t bytesReceived) {
+  if (!m_endpoint) {
+    return;
+  }
+  if (status >= kMinStatus && status <= kMaxStatus) {
+    m_endpoint->responsesByStatus[status - kMinStatus].fetch_add(
+        1, std::memory_order_relaxed);
+  } else {
+    m_endpoint->otherResponses.fetch_add(1, std::memory_order_relaxed);
+  }
+  m_endpoint->bytesReceived.fetch_add(bytesReceived,
+                                      std::memory_order_relaxed);
+  finish();
+}
+
+void RequestMetrics::Recording::timedOut() {
+  if (!m_endpoint) {
+    return;
+  }
+  m_endpoint->timeouts.fetch_add(1, std::memory_order_relaxed);
+  finish();
+}
+
+void RequestMetrics::Recording::failed() {
+  if (!m_endpoint) {
+    return;
+  }
+  m_endpoint->failures.fetch_add(1, std::memory_order_relaxed);
+  finish();
+}
+
+void RequestMetrics::Recording::finish() {
+  m_endpoint->latency.record(std::chrono::steady_clock::now() - m_started);
+  m_endpoint->inFlight.fetch_sub(1, std::memory_order_relaxed);
+  m_endpoint = nullptr;
+}
+
+}  // namespace metrics
+}  // namespace outline
@@ -0,0 +1,104 @@
+#include "outline/metrics/UsagePoller.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+
+namespace outline {
+namespace metrics {
+
+UsagePoller::UsagePoller(OutlineClient& client,
+                         const UsagePollerOptions& options)
+    : m_client(client),
+      m_options(options),
+      m_series(options.window),
+      m_executor(client.executor()),
+      m_stopTimer(m_executor) {}
+
+UsagePoller::~UsagePoller() {
+  stop();
+}
+
+void UsagePoller::start() {
+  if (m_done.valid()) {
+    return;
+  }
+  boost::asio::post(m_executor, [this]() {
+    m_stopped = false;
+    m_stopTimer.expires_at(boost::asio::steady_timer::time_point::max());
+  });
+  m_done = boost::asio::co_spawn(m_executor, run(), boost::asio::use_future);
+}
+
+void UsagePoller::stop() {
+  if (!m_done.valid()) {
+    return;
+  }
+  boost::asio::post(m_executor, [this]() {
+    m_stopped = true;
+    m_stopTimer.cancel();
+  });
+  m_done.get();
+}
+
+std::uint64_t UsagePoller::bytesOverLast(
+    const std::string& keyId, std::chrono::milliseconds period) const {
+  const auto interval = std::max<std::int64_t>(m_options.interval.count(), 1);
+  const auto intervals = (period.count() + interval - 1) / interval;
+  return m_series.bytesOverLast(
+      keyId, static_cast<std::size_t>(std::max<std::int64_t>(intervals, 0)));
+}
+
+double UsagePoller::currentRate(const std::string& keyId) const {
+  return m_series.currentRate(keyId);
+}
+
+UsagePollerStats UsagePoller::stats() const {
+  UsagePollerStats stats;
+  stats.polls = m_polls.load(std::memory_order_relaxed);
+  stats.failures = m_failures.load(std::memory_order_relaxed);
+  stats.keys = m_series.keyCount();
+  return stats;
+}
+
+boost::asio::awaitable<void> UsagePoller::run() {
+  using namespace boost::asio::experimental::awaitable_operators;
+  // Completes without an error when stop() cancels the timer, so that it
+  // wins the race against whatever the loop is waiting for.
+  auto stopRequested = [this]() -> boost::asio::awaitable<void> {
+    boost::system::error_code ec;
+    co_await m_stopTimer.async_wait(
+        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+  };
+
+  boost::asio::steady_timer timer(m_executor);
+  auto next = UsageSeries::Clock::now();
+  while (!m_stopped) {
+    try {
+      auto result = co_await (
+          m_client.coWithTimeout(m_client.coGetMetricsTyped(),
+                                 m_options.interval) ||
+          stopRequested());
+      if (result.index() == 1) {
+        co_return;
+      }
+      m_series.record(std::get<0>(result), UsageSeries::Clock::now());
+      if (m_options.archive != nullptr) {
+        m_options.archive->append(std::get<0>(result));
+      }
+      m_polls.fetch_add(1, std::memory_order_relaxed);
+    } catch (const std::exception&) {
+      m_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Missed ticks are skipped rather than polled back to back.
+    next = std::max(next + m_options.interval, UsageSeries::Clock::now());
+    timer.expires_at(next);
+    auto woken = co_await (timer.async_wait(boost::asio::use_awaitable) ||
+                           stopRequested());
+    if (woken.index() == 1) {
+      co_return;
+    }
+  }
+}
+
+}  // namespace metrics
+}  // namespace outline
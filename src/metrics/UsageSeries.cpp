@@ -0,0 +1,126 @@
+#include "outline/metrics/UsageSeries.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace outline {
+namespace metrics {
+
+UsageSeries::UsageSeries(std::size_t window)
+    : m_capacity(std::max<std::size_t>(window, 1) + 1),
+      m_times(m_capacity) {}
+
+void UsageSeries::record(const TransferMetrics& snapshot,
+                         Clock::time_point time) {
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  const std::uint64_t current = m_snapshots;
+  const bool baseline = current == 0;
+
+  // Keys missing from the snapshot transferred nothing since the last one.
+  for (const auto& [keyId, row] : m_rows) {
+    slot(row.index, current) = slot(row.index, current - 1);
+  }
+  for (const auto& [keyId, counter] : snapshot.bytesTransferredByUserId) {
+    auto it = m_rows.find(keyId);
+    if (it == m_rows.end()) {
+      Row row;
+      row.index = allocateRow();
+      // The row of a new key is empty, so every earlier interval reads zero.
+      std::fill_n(m_totals.begin() + row.index * m_capacity, m_capacity, 0);
+      slot(row.index, current) = baseline ? 0 : counter;
+      row.lastCounter = counter;
+      row.lastSeen = current;
+      m_rows.emplace(keyId, row);
+      continue;
+    }
+    Row& row = it->second;
+    // A counter which went down was reset and counts from zero again.
+    const std::uint64_t delta =
+        counter >= row.lastCounter ? counter - row.lastCounter : counter;
+    slot(row.index, current) += delta;
+    row.lastCounter = counter;
+    row.lastSeen = current;
+  }
+  m_times[current % m_capacity] = time;
+  ++m_snapshots;
+
+  for (auto it = m_rows.begin(); it != m_rows.end();) {
+    if (current - it->second.lastSeen >= m_capacity) {
+      m_freeRows.push_back(it->second.index);
+      it = m_rows.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::uint64_t UsageSeries::bytesOverLast(const std::string& keyId,
+                                         std::size_t intervals) const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  auto it = m_rows.find(keyId);
+  if (it == m_rows.end() || m_snapshots < 2) {
+    return 0;
+  }
+  const std::uint64_t recorded =
+      std::min<std::uint64_t>(m_snapshots - 1, m_capacity - 1);
+  const std::uint64_t last = m_snapshots - 1;
+  const std::uint64_t first =
+      last - std::min<std::uint64_t>(intervals, recorded);
+  return slot(it->second.index, last) - slot(it->second.index, first);
+}
+
+double UsageSeries::currentRate(const std::string& keyId) const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  auto it = m_rows.find(keyId);
+  if (it == m_rows.end() || m_snapshots < 2) {
+    return 0;
+  }
+  const std::uint64_t last = m_snapshots - 1;
+  const double seconds =
+      std::chrono::duration<double>(m_times[last % m_capacity] -
+                                    m_times[(last - 1) % m_capacity])
+          .count();
+  if (seconds <= 0) {
+    return 0;
+  }
+  const std::uint64_t bytes =
+      slot(it->second.index, last) - slot(it->second.index, last - 1);
+  return static_cast<double>(bytes) / seconds;
+}
+
+std::size_t UsageSeries::recordedIntervals() const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  if (m_snapshots == 0) {
+    return 0;
+  }
+  return static_cast<std::size_t>(
+      std::min<std::uint64_t>(m_snapshots - 1, m_capacity - 1));
+}
+
+std::size_t UsageSeries::keyCount() const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_rows.size();
+}
+
+std::uint64_t& UsageSeries::slot(std::size_t row, std::uint64_t snapshot) {
+  return m_totals[row * m_capacity + snapshot % m_capacity];
+}
+
+std::uint64_t UsageSeries::slot(std::size_t row,
+                                std::uint64_t snapshot) const {
+  return m_totals[row * m_capacity + snapshot % m_capacity];
+}
+
+std::size_t UsageSeries::allocateRow() {
+  if (!m_freeRows.empty()) {
+    const std::size_t index = m_freeRows.back();
+    m_freeRows.pop_back();
+    return index;
+  }
+  const std::size_t index = m_totals.size() / m_capacity;
+  m_totals.resize(m_totals.size() + m_capacity);
+  return index;
+}
+
+}  // namespace metrics
+}  // namespace outline
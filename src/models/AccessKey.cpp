@@ -0,0 +1,45 @@
+#include "outline/models/AccessKey.h"
+#include "outline/exceptions/OutlineExceptions.h"
+#include "outline/utils/JsonUtils.h"
+
+#include <boost/json.hpp>
+
+namespace outline {
+
+DataLimit tag_invoke(boost::json::value_to_tag<DataLimit>,
+                     const boost::json::value& jv) {
+  DataLimit limit;
+  limit.bytes = boost::json::value_to<std::int64_t>(jv.as_object().at("bytes"));
+  return limit;
+}
+
+AccessKey tag_invoke(boost::json::value_to_tag<AccessKey>,
+                     const boost::json::value& jv) {
+  const boost::json::object& obj = jv.as_object();
+  AccessKey key;
+  key.id = boost::json::value_to<std::string>(obj.at("id"));
+  utils::readField(obj, "name", key.name);
+  utils::readField(obj, "password", key.password);
+  utils::readField(obj, "port", key.port);
+  utils::readField(obj, "method", key.method);
+  utils::readField(obj, "dataLimit", key.dataLimit);
+  utils::readField(obj, "accessUrl", key.accessUrl);
+  return key;
+}
+
+std::vector<AccessKey> accessKeysFromJson(const boost::json::value& jv) {
+  const boost::json::object* obj = jv.if_object();
+  const boost::json::value* keys =
+      obj != nullptr ? obj->if_contains("accessKeys") : nullptr;
+  if (keys == nullptr || !keys->is_array()) {
+    throw OutlineParseException("Invalid JSON structure for access keys.");
+  }
+  try {
+    return boost::json::value_to<std::vector<AccessKey>>(*keys);
+  } catch (const std::exception& e) {
+    throw OutlineParseException(
+        std::string("Invalid JSON structure for access keys: ") + e.what());
+  }
+}
+
+}  // namespace outline
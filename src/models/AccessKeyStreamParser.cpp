@@ -0,0 +1,218 @@
+#include "outline/models/AccessKeyStreamParser.h"
+#include "outline/exceptions/OutlineExceptions.h"
+
+#include <boost/json/basic_parser_impl.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace outline {
+
+namespace {
+
+/**
+ * @brief SAX handler which builds one AccessKey at a time.
+ *
+ * Depth 1 is the root object, depth 2 the accessKeys array, depth 3 a key
+ * object and depth 4 its dataLimit object. Everything else is skipped.
+ */
+class AccessKeyHandler {
+ public:
+  static constexpr std::size_t max_object_size = std::size_t(-1);
+  static constexpr std::size_t max_array_size = std::size_t(-1);
+  static constexpr std::size_t max_key_size = std::size_t(-1);
+  static constexpr std::size_t max_string_size = std::size_t(-1);
+
+  explicit AccessKeyHandler(AccessKeyStreamParser::Callback onAccessKey)
+      : m_onAccessKey(std::move(onAccessKey)) {}
+
+  bool on_document_begin(boost::json::error_code&) { return true; }
+  bool on_document_end(boost::json::error_code&) { return true; }
+
+  bool on_object_begin(boost::json::error_code&) {
+    if (m_inKeys && m_depth == 2) {
+      m_current = AccessKey{};
+    } else if (m_inKeys && m_depth == 3 && m_key == "dataLimit") {
+      m_current.dataLimit = DataLimit{};
+      m_inDataLimit = true;
+    }
+    ++m_depth;
+    return true;
+  }
+
+  bool on_object_end(std::size_t, boost::json::error_code&) {
+    --m_depth;
+    if (m_inKeys && m_depth == 2) {
+      ++m_count;
+      m_onAccessKey(std::move(m_current));
+    } else if (m_inDataLimit && m_depth == 3) {
+      m_inDataLimit = false;
+    }
+    return true;
+  }
+
+  bool on_array_begin(boost::json::error_code&) {
+    if (m_depth == 1 && m_key == "accessKeys") {
+      m_inKeys = true;
+      m_foundKeys = true;
+    }
+    ++m_depth;
+    return true;
+  }
+
+  bool on_array_end(std::size_t, boost::json::error_code&) {
+    --m_depth;
+    if (m_inKeys && m_depth == 1) {
+      m_inKeys = false;
+    }
+    return true;
+  }
+
+  bool on_key_part(boost::json::string_view s, std::size_t,
+                   boost::json::error_code&) {
+    m_buffer.append(s.data(), s.size());
+    return true;
+  }
+
+  bool on_key(boost::json::string_view s, std::size_t,
+              boost::json::error_code&) {
+    m_buffer.append(s.data(), s.size());
+    m_key.swap(m_buffer);
+    m_buffer.clear();
+    return true;
+  }
+
+  bool on_string_part(boost::json::string_view s, std::size_t,
+                      boost::json::error_code&) {
+    m_buffer.append(s.data(), s.size());
+    return true;
+  }
+
+  bool on_string(boost::json::string_view s, std::size_t,
+                 boost::json::error_code&) {
+    m_buffer.append(s.data(), s.size());
+    if (std::string* field = stringField()) {
+      field->swap(m_buffer);
+    }
+    m_buffer.clear();
+    return true;
+  }
+
+  bool on_number_part(boost::json::string_view, boost::json::error_code&) {
+    return true;
+  }
+
+  bool on_int64(std::int64_t i, boost::json::string_view,
+                boost::json::error_code&) {
+    setNumber(i);
+    return true;
+  }
+
+  bool on_uint64(std::uint64_t u, boost::json::string_view,
+                 boost::json::error_code&) {
+    setNumber(static_cast<std::int64_t>(u));
+    return true;
+  }
+
+  bool on_double(double d, boost::json::string_view,
+                 boost::json::error_code&) {
+    setNumber(static_cast<std::int64_t>(d));
+    return true;
+  }
+
+  bool on_bool(bool, boost::json::error_code&) { return true; }
+  bool on_null(boost::json::error_code&) { return true; }
+
+  bool on_comment_part(boost::json::string_view, boost::json::error_code&) {
+    return true;
+  }
+
+  bool on_comment(boost::json::string_view, boost::json::error_code&) {
+    return true;
+  }
+
+  std::size_t count() const { return m_count; }
+  bool foundKeys() const { return m_foundKeys; }
+
+ private:
+  std::string* stringField() {
+    if (!m_inKeys || m_depth != 3) {
+      return nullptr;
+    }
+    if (m_key == "id")
+      return &m_current.id;
+    if (m_key == "name")
+      return &m_current.name;
+    if (m_key == "password")
+      return &m_current.password;
+    if (m_key == "method")
+      return &m_current.method;
+    if (m_key == "accessUrl")
+      return &m_current.accessUrl;
+    return nullptr;
+  }
+
+  void setNumber(std::int64_t value) {
+    if (m_inKeys && m_depth == 3) {
+      if (m_key == "port") {
+        m_current.port = static_cast<int>(value);
+      } else if (m_key == "id") {
+        m_current.id = std::to_string(value);
+      }
+    } else if (m_inDataLimit && m_depth == 4 && m_key == "bytes") {
+      m_current.dataLimit->bytes = value;
+    }
+  }
+
+  AccessKeyStreamParser::Callback m_onAccessKey;
+  AccessKey m_current;
+  std::string m_key;
+  std::string m_buffer;
+  int m_depth = 0;
+  bool m_inKeys = false;
+  bool m_inDataLimit = false;
+  bool m_foundKeys = false;
+  std::size_t m_count = 0;
+};
+
+}  // namespace
+
+class AccessKeyStreamParser::Impl {
+ public:
+  explicit Impl(Callback onAccessKey)
+      : parser(boost::json::parse_options(), std::move(onAccessKey)) {}
+
+  boost::json::basic_parser<AccessKeyHandler> parser;
+};
+
+AccessKeyStreamParser::AccessKeyStreamParser(Callback onAccessKey)
+    : m_impl(std::make_unique<Impl>(std::move(onAccessKey))) {}
+
+AccessKeyStreamParser::~AccessKeyStreamParser() = default;
+
+void AccessKeyStreamParser::write(std::string_view chunk) {
+  boost::json::error_code ec;
+  m_impl->parser.write_some(true, chunk.data(), chunk.size(), ec);
+  if (ec) {
+    throw OutlineParseException("JSON parse error for access keys: " +
+                                ec.message());
+  }
+}
+
+void AccessKeyStreamParser::finish() {
+  boost::json::error_code ec;
+  m_impl->parser.write_some(false, nullptr, 0, ec);
+  if (ec) {
+    throw OutlineParseException("JSON parse error for access keys: " +
+                                ec.message());
+  }
+  if (!m_impl->parser.handler().foundKeys()) {
+    throw OutlineParseException("Invalid JSON structure for access keys.");
+  }
+}
+
+std::size_t AccessKeyStreamParser::count() const {
+  return m_impl->parser.handler().count();
+}
+
+}  // namespace outline
@@ -0,0 +1,23 @@
+#include "outline/models/ServerInformation.h"
+#include "outline/utils/JsonUtils.h"
+
+#include <boost/json.hpp>
+
+namespace outline {
+
+ServerInformation tag_invoke(boost::json::value_to_tag<ServerInformation>,
+                             const boost::json::value& jv) {
+  const boost::json::object& obj = jv.as_object();
+  ServerInformation info;
+  utils::readField(obj, "name", info.name);
+  utils::readField(obj, "serverId", info.serverId);
+  utils::readField(obj, "metricsEnabled", info.metricsEnabled);
+  utils::readField(obj, "createdTimestampMs", info.createdTimestampMs);
+  utils::readField(obj, "version", info.version);
+  utils::readField(obj, "accessKeyDataLimit", info.accessKeyDataLimit);
+  utils::readField(obj, "portForNewAccessKeys", info.portForNewAccessKeys);
+  utils::readField(obj, "hostnameForAccessKeys", info.hostnameForAccessKeys);
+  return info;
+}
+
+}  // namespace outline
@@ -0,0 +1,21 @@
+#include "outline/models/TransferMetrics.h"
+
+#include <boost/json.hpp>
+
+namespace outline {
+
+TransferMetrics tag_invoke(boost::json::value_to_tag<TransferMetrics>,
+                           const boost::json::value& jv) {
+  const boost::json::object& bytesByUser =
+      jv.as_object().at("bytesTransferredByUserId").as_object();
+  TransferMetrics metrics;
+  metrics.bytesTransferredByUserId.reserve(bytesByUser.size());
+  for (const auto& entry : bytesByUser) {
+    metrics.bytesTransferredByUserId.emplace(
+        std::string(entry.key()),
+        boost::json::value_to<std::uint64_t>(entry.value()));
+  }
+  return metrics;
+}
+
+}  // namespace outline
@@ -0,0 +1,84 @@
+#include "outline/network/CircuitBreaker.h"
+
+namespace outline {
+namespace network {
+
+CircuitBreaker::CircuitBreaker(const CircuitBreakerOptions& options)
+    : m_options(options) {}
+
+bool CircuitBreaker::allow() {
+  if (!m_options.enabled) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  switch (m_state) {
+    case CircuitState::Closed:
+      return true;
+    case CircuitState::Open:
+      if (std::chrono::steady_clock::now() - m_openedAt <
+          m_options.coolDown) {
+        ++m_rejected;
+        return false;
+      }
+      m_state = CircuitState::HalfOpen;
+      m_probeInFlight = true;
+      return true;
+    case CircuitState::HalfOpen:
+      if (m_probeInFlight) {
+        ++m_rejected;
+        return false;
+      }
+      m_probeInFlight = true;
+      return true;
+  }
+  return true;
+}
+
+void CircuitBreaker::recordSuccess() {
+  if (!m_options.enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_state = CircuitState::Closed;
+  m_consecutiveFailures = 0;
+  m_probeInFlight = false;
+}
+
+void CircuitBreaker::recordFailure() {
+  if (!m_options.enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_consecutiveFailures;
+  // A failed probe opens the circuit again for another cool-down.
+  if (m_state == CircuitState::HalfOpen ||
+      (m_state == CircuitState::Closed &&
+       m_consecutiveFailures >= m_options.failureThreshold)) {
+    m_state = CircuitState::Open;
+    m_openedAt = std::chrono::steady_clock::now();
+    m_probeInFlight = false;
+    ++m_opened;
+  }
+}
+
+void CircuitBreaker::recordAbandoned() {
+  if (!m_options.enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // Let the next request probe the server instead.
+  m_probeInFlight = false;
+}
+
+CircuitBreakerStats CircuitBreaker::stats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  CircuitBreakerStats stats;
+  stats.state = m_state;
+  stats.consecutiveFailures = m_consecutiveFailures;
+  stats.opened = m_opened;
+  stats.rejected = m_rejected;
+  return stats;
+}
+
+}  // namespace network
+}  // namespace outline
@@ -0,0 +1,165 @@
+#include "outline/network/Compression.h"
+#include "outline/exceptions/OutlineExceptions.h"
+
+#include <array>
+#include <string>
+
+#include <zlib.h>
+
+namespace outline {
+namespace network {
+
+namespace {
+
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < lhs.size(); ++i) {
+    const char l = lhs[i] >= 'A' && lhs[i] <= 'Z' ? lhs[i] - 'A' + 'a' : lhs[i];
+    if (l != rhs[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+[[noreturn]] void throwInflateError(const z_stream& stream, int result) {
+  throw OutlineParseException(
+      std::string("Unable to inflate the response: ") +
+      (stream.msg != nullptr ? stream.msg : "zlib error " +
+                                                std::to_string(result)));
+}
+
+}  // namespace
+
+ContentEncoding parseContentEncoding(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+    value.remove_prefix(1);
+  }
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+    value.remove_suffix(1);
+  }
+  if (value.empty() || equalsIgnoreCase(value, "identity")) {
+    return ContentEncoding::Identity;
+  }
+  if (equalsIgnoreCase(value, "gzip") || equalsIgnoreCase(value, "x-gzip")) {
+    return ContentEncoding::Gzip;
+  }
+  if (equalsIgnoreCase(value, "deflate")) {
+    return ContentEncoding::Deflate;
+  }
+  // Only gzip and deflate are requested, so a list of codings or another
+  // one means a misbehaving server or proxy.
+  throw OutlineParseException("Unsupported Content-Encoding: " +
+                              std::string(value));
+}
+
+class Inflater::Impl {
+ public:
+  Impl() {
+    // "deflate" is the zlib format (RFC 9110), so zlib can tell both codings
+    // apart by their header: adding 32 detects gzip and zlib.
+    if (inflateInit2(&m_stream, MAX_WBITS + 32) != Z_OK) {
+      throw OutlineParseException("Unable to start inflating the response");
+    }
+  }
+
+  ~Impl() { inflateEnd(&m_stream); }
+
+  void write(std::string_view input, const Sink& onOutput) {
+    m_compressed += input.size();
+    m_stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    m_stream.avail_in = static_cast<uInt>(input.size());
+    // A full output buffer may leave inflated bytes inside zlib, so keep
+    // going until it comes back with room to spare.
+    do {
+      if (m_ended && m_stream.avail_in > 0) {
+        // A gzip body may hold several members one after another.
+        if (inflateReset(&m_stream) != Z_OK) {
+          throwInflateError(m_stream, Z_STREAM_ERROR);
+        }
+        m_ended = false;
+      }
+      m_stream.next_out = reinterpret_cast<Bytef*>(m_output.data());
+      m_stream.avail_out = static_cast<uInt>(m_output.size());
+      const int result = inflate(&m_stream, Z_NO_FLUSH);
+      if (result == Z_BUF_ERROR) {
+        // Nothing left to do until more input arrives.
+        break;
+      }
+      if (result != Z_OK && result != Z_STREAM_END) {
+        throwInflateError(m_stream, result);
+      }
+      const std::size_t produced = m_output.size() - m_stream.avail_out;
+      if (produced > 0) {
+        m_inflated += produced;
+        onOutput(std::string_view(m_output.data(), produced));
+      }
+      m_ended = result == Z_STREAM_END;
+    } while (m_stream.avail_in > 0 || (m_stream.avail_out == 0 && !m_ended));
+  }
+
+  void finish() const {
+    // An empty body, e.g. of a 204, carries no compressed stream at all.
+    if (m_compressed > 0 && !m_ended) {
+      throw OutlineParseException(
+          "Unable to inflate the response: the body was cut off");
+    }
+  }
+
+  std::size_t compressed() const { return m_compressed; }
+  std::size_t inflated() const { return m_inflated; }
+
+ private:
+  z_stream m_stream{};
+  std::array<char, 16384> m_output;
+  std::size_t m_compressed = 0;
+  std::size_t m_inflated = 0;
+  bool m_ended = false;
+};
+
+Inflater::Inflater() : m_impl(std::make_unique<Impl>()) {}
+
+Inflater::~Inflater() = default;
+Inflater::Inflater(Inflater&&) noexcept = default;
+Inflater& Inflater::operator=(Inflater&&) noexcept = default;
+
+void Inflater::write(std::string_view input, const Sink& onOutput) {
+  m_impl->write(input, onOutput);
+}
+
+void Inflater::finish() {
+  m_impl->finish();
+}
+
+std::size_t Inflater::compressedBytes() const {
+  return m_impl->compressed();
+}
+
+std::size_t Inflater::inflatedBytes() const {
+  return m_impl->inflated();
+}
+
+ResponseCompression::ResponseCompression(const CompressionOptions& options)
+    : m_options(options) {}
+
+void ResponseCompression::record(const Inflater& inflater) {
+  m_responses.fetch_add(1, std::memory_order_relaxed);
+  m_compressedBytes.fetch_add(inflater.compressedBytes(),
+                              std::memory_order_relaxed);
+  m_inflatedBytes.fetch_add(inflater.inflatedBytes(),
+                            std::memory_order_relaxed);
+}
+
+CompressionStats ResponseCompression::stats() const {
+  CompressionStats stats;
+  stats.compressedResponses = m_responses.load(std::memory_order_relaxed);
+  stats.compressedBytes = m_compressedBytes.load(std::memory_order_relaxed);
+  stats.inflatedBytes = m_inflatedBytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace network
+}  // namespace outline
@@ -0,0 +1,135 @@
+#include "outline/network/ConnectionPool.h"
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/execution/context.hpp>
+#include <boost/asio/query.hpp>
+#include <boost/beast/core/stream_traits.hpp>
+
+#include <iterator>
+
+namespace outline {
+namespace network {
+
+using tcp = boost::asio::ip::tcp;
+
+ConnectionPool::ConnectionPool(const ConnectionPoolOptions& options)
+    : m_options(options) {}
+
+std::unique_ptr<PooledConnection> ConnectionPool::acquire(
+    const boost::asio::any_io_executor& executor) {
+  std::deque<std::unique_ptr<PooledConnection>> closed;
+  std::unique_ptr<PooledConnection> connection;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evictExpiredLocked(std::chrono::steady_clock::now(), closed);
+    // Most recently used connections are at the back and are the least
+    // likely to have been closed by the server.
+    for (auto it = m_idle.rbegin(); it != m_idle.rend();) {
+      if (!sameContext((*it)->stream.get_executor(), executor)) {
+        ++it;
+        continue;
+      }
+      auto candidate = std::move(*it);
+      it = std::make_reverse_iterator(m_idle.erase(std::next(it).base()));
+      if (isHealthy(*candidate)) {
+        connection = std::move(candidate);
+        break;
+      }
+      m_failedHealthChecks.fetch_add(1, std::memory_order_relaxed);
+      closed.push_back(std::move(candidate));
+    }
+  }
+  if (connection) {
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+  return connection;
+}
+
+void ConnectionPool::release(std::unique_ptr<PooledConnection> connection) {
+  if (!connection) {
+    return;
+  }
+  std::deque<std::unique_ptr<PooledConnection>> closed;
+  auto now = std::chrono::steady_clock::now();
+  connection->lastUsed = now;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  evictExpiredLocked(now, closed);
+  if (!m_options.enabled || m_idle.size() >= m_options.maxIdleConnections) {
+    m_discarded.fetch_add(1, std::memory_order_relaxed);
+    closed.push_back(std::move(connection));
+    return;
+  }
+  m_idle.push_back(std::move(connection));
+}
+
+std::size_t ConnectionPool::evictIdle() {
+  std::deque<std::unique_ptr<PooledConnection>> closed;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return evictExpiredLocked(std::chrono::steady_clock::now(), closed);
+}
+
+void ConnectionPool::clear() {
+  std::deque<std::unique_ptr<PooledConnection>> closed;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  closed.swap(m_idle);
+}
+
+ConnectionPoolStats ConnectionPool::stats() const {
+  ConnectionPoolStats stats;
+  stats.hits = m_hits.load(std::memory_order_relaxed);
+  stats.misses = m_misses.load(std::memory_order_relaxed);
+  stats.evictions = m_evictions.load(std::memory_order_relaxed);
+  stats.failedHealthChecks =
+      m_failedHealthChecks.load(std::memory_order_relaxed);
+  stats.discarded = m_discarded.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  stats.idle = m_idle.size();
+  return stats;
+}
+
+bool ConnectionPool::sameContext(const boost::asio::any_io_executor& lhs,
+                                 const boost::asio::any_io_executor& rhs) {
+  return &boost::asio::query(lhs, boost::asio::execution::context) ==
+         &boost::asio::query(rhs, boost::asio::execution::context);
+}
+
+bool ConnectionPool::isHealthy(PooledConnection& connection) {
+  tcp::socket& socket =
+      boost::beast::get_lowest_layer(connection.stream).socket();
+  if (!socket.is_open()) {
+    return false;
+  }
+  // An idle connection must have nothing to read. Pending bytes mean the
+  // server sent a close_notify alert or FIN while the connection was idle.
+  boost::system::error_code ec;
+  char byte;
+  socket.non_blocking(true, ec);
+  if (ec) {
+    return false;
+  }
+  std::size_t received = socket.receive(boost::asio::buffer(&byte, 1),
+                                        tcp::socket::message_peek, ec);
+  boost::system::error_code restoreEc;
+  socket.non_blocking(false, restoreEc);
+  return received == 0 && ec == boost::asio::error::would_block && !restoreEc;
+}
+
+std::size_t ConnectionPool::evictExpiredLocked(
+    std::chrono::steady_clock::time_point now,
+    std::deque<std::unique_ptr<PooledConnection>>& expired) {
+  std::size_t count = 0;
+  // The front holds the least recently used connections.
+  while (!m_idle.empty() &&
+         now - m_idle.front()->lastUsed >= m_options.idleTimeout) {
+    expired.push_back(std::move(m_idle.front()));
+    m_idle.pop_front();
+    ++count;
+  }
+  m_evictions.fetch_add(count, std::memory_order_relaxed);
+  return count;
+}
+
+}  // namespace network
+}  // namespace outline
@@ -0,0 +1,229 @@
+#include "outline/network/HappyEyeballs.h"
+
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace outline {
+namespace network {
+
+using tcp = boost::asio::ip::tcp;
+
+namespace {
+
+/**
+ * @brief State shared by the connect coroutine and the handlers of its
+ *        attempts, which may still be queued when the coroutine is gone.
+ */
+struct Race {
+  explicit Race(const boost::asio::any_io_executor& executor)
+      : wake(executor) {}
+
+  /// One socket per started attempt, in the order they were started.
+  std::vector<tcp::socket> sockets;
+  /// The coroutine sleeps on it until the next attempt is due. Finished
+  /// attempts cancel it to wake the coroutine up early.
+  boost::asio::steady_timer wake;
+  bool woken = false;
+  std::size_t failed = 0;
+  std::optional<std::size_t> winner;
+  boost::system::error_code lastError;
+};
+
+void startAttempt(const std::shared_ptr<Race>& race,
+                  const boost::asio::any_io_executor& executor,
+                  const tcp::endpoint& endpoint) {
+  const std::size_t index = race->sockets.size();
+  race->sockets.emplace_back(executor);
+  race->sockets.back().async_connect(
+      endpoint, [race, index](boost::system::error_code ec) {
+        if (!ec) {
+          // A later winner is closed with the other attempts.
+          if (!race->winner) {
+            race->winner = index;
+          }
+        } else if (!race->winner) {
+          ++race->failed;
+          race->lastError = ec;
+        }
+        race->woken = true;
+        race->wake.cancel();
+      });
+}
+
+}  // namespace
+
+HappyEyeballs::HappyEyeballs(const HappyEyeballsOptions& options)
+    : m_options(options) {}
+
+boost::asio::awaitable<tcp::socket> HappyEyeballs::connect(
+    std::string key, Results results, std::chrono::milliseconds timeout) {
+  using Clock = std::chrono::steady_clock;
+  auto executor = co_await boost::asio::this_coro::executor;
+  const std::vector<tcp::endpoint> endpoints = order(key, results);
+  if (endpoints.empty()) {
+    throw boost::system::system_error(boost::asio::error::host_not_found);
+  }
+  const bool remembered = preferred(key) == endpoints.front();
+
+  auto race = std::make_shared<Race>(executor);
+  // Pending attempts refer to their sockets, which must not move.
+  race->sockets.reserve(endpoints.size());
+  const auto deadline = timeout.count() > 0 ? Clock::now() + timeout
+                                            : Clock::time_point::max();
+  auto nextAttempt = Clock::now();
+  bool timedOut = false;
+  bool cancelled = false;
+  for (;;) {
+    if (race->winner) {
+      break;
+    }
+    const auto now = Clock::now();
+    if (now >= deadline) {
+      timedOut = true;
+      break;
+    }
+    const std::size_t started = race->sockets.size();
+    const bool allFailed = race->failed == started;
+    if (started < endpoints.size() && (allFailed || now >= nextAttempt)) {
+      startAttempt(race, executor, endpoints[started]);
+      nextAttempt = m_options.enabled ? now + m_options.attemptDelay
+                                      : Clock::time_point::max();
+      continue;
+    }
+    if (allFailed) {
+      break;
+    }
+    race->woken = false;
+    race->wake.expires_at(std::min(
+        started < endpoints.size() ? nextAttempt : Clock::time_point::max(),
+        deadline));
+    boost::system::error_code ec;
+    co_await race->wake.async_wait(
+        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    if (ec == boost::asio::error::operation_aborted && !race->woken) {
+      // The connect itself was cancelled, e.g. by coWithTimeout.
+      cancelled = true;
+      break;
+    }
+  }
+
+  m_attempts.fetch_add(race->sockets.size(), std::memory_order_relaxed);
+  m_failedAttempts.fetch_add(race->failed, std::memory_order_relaxed);
+  for (std::size_t i = 0; i < race->sockets.size(); ++i) {
+    if (i != race->winner) {
+      boost::system::error_code ignored;
+      race->sockets[i].close(ignored);
+    }
+  }
+  if (!race->winner) {
+    m_failures.fetch_add(1, std::memory_order_relaxed);
+    forget(key);
+    if (cancelled) {
+      throw boost::system::system_error(boost::asio::error::operation_aborted);
+    }
+    if (timedOut) {
+      throw boost::system::system_error(boost::asio::error::timed_out);
+    }
+    throw boost::system::system_error(race->lastError);
+  }
+
+  const std::size_t winner = *race->winner;
+  m_connects.fetch_add(1, std::memory_order_relaxed);
+  if (winner > 0) {
+    m_fallbacks.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (remembered) {
+    m_remembered.fetch_add(1, std::memory_order_relaxed);
+  }
+  remember(key, endpoints[winner]);
+  co_return std::move(race->sockets[winner]);
+}
+
+std::vector<tcp::endpoint> HappyEyeballs::order(const std::string& key,
+                                                const Results& results) const {
+  std::vector<tcp::endpoint> endpoints;
+  endpoints.reserve(results.size());
+  for (const auto& entry : results) {
+    endpoints.push_back(entry.endpoint());
+  }
+  if (!m_options.enabled || endpoints.empty()) {
+    return endpoints;
+  }
+
+  // The resolver sorts by RFC 6724, so its first entry names the family to
+  // start with unless a winner of this host is remembered.
+  const std::optional<tcp::endpoint> preferred = this->preferred(key);
+  const bool firstIsV6 = preferred ? preferred->address().is_v6()
+                                   : endpoints.front().address().is_v6();
+  std::vector<tcp::endpoint> first;
+  std::vector<tcp::endpoint> second;
+  for (const tcp::endpoint& endpoint : endpoints) {
+    if (preferred && endpoint == *preferred) {
+      continue;
+    }
+    (endpoint.address().is_v6() == firstIsV6 ? first : second)
+        .push_back(endpoint);
+  }
+  if (preferred && std::find(endpoints.begin(), endpoints.end(),
+                             *preferred) != endpoints.end()) {
+    first.insert(first.begin(), *preferred);
+  }
+
+  endpoints.clear();
+  for (std::size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+    if (i < first.size()) {
+      endpoints.push_back(first[i]);
+    }
+    if (i < second.size()) {
+      endpoints.push_back(second[i]);
+    }
+  }
+  return endpoints;
+}
+
+void HappyEyeballs::forget(const std::string& key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_preferences.erase(key);
+}
+
+HappyEyeballsStats HappyEyeballs::stats() const {
+  HappyEyeballsStats stats;
+  stats.connects = m_connects.load(std::memory_order_relaxed);
+  stats.fallbacks = m_fallbacks.load(std::memory_order_relaxed);
+  stats.remembered = m_remembered.load(std::memory_order_relaxed);
+  stats.failures = m_failures.load(std::memory_order_relaxed);
+  stats.attempts = m_attempts.load(std::memory_order_relaxed);
+  stats.failedAttempts = m_failedAttempts.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::optional<tcp::endpoint> HappyEyeballs::preferred(
+    const std::string& key) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_preferences.find(key);
+  if (it == m_preferences.end() ||
+      std::chrono::steady_clock::now() - it->second.wonAt >=
+          m_options.preferenceTtl) {
+    return std::nullopt;
+  }
+  return it->second.endpoint;
+}
+
+void HappyEyeballs::remember(const std::string& key,
+                             const tcp::endpoint& endpoint) {
+  if (!m_options.enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_preferences[key] = Preference{endpoint, std::chrono::steady_clock::now()};
+}
+
+}  // namespace network
+}  // namespace outline
@@ -0,0 +1,66 @@
+#include "outline/network/IoRuntime.h"
+
+#include <algorithm>
+
+#include <boost/asio/strand.hpp>
+
+namespace outline {
+namespace network {
+
+IoRuntime::IoRuntime(const IoRuntimeOptions& options) : m_mode(options.mode) {
+  const std::size_t threads = std::max<std::size_t>(options.threads, 1);
+  const std::size_t contexts =
+      m_mode == IoRuntimeMode::ThreadPool ? 1 : threads;
+  for (std::size_t i = 0; i < contexts; ++i) {
+    // A single threaded io_context can skip its internal locking.
+    const int concurrencyHint =
+        m_mode == IoRuntimeMode::ThreadPool ? static_cast<int>(threads) : 1;
+    m_contexts.push_back(
+        std::make_unique<boost::asio::io_context>(concurrencyHint));
+    m_workGuards.push_back(
+        boost::asio::make_work_guard(*m_contexts.back()));
+  }
+  for (std::size_t i = 0; i < threads; ++i) {
+    boost::asio::io_context& context = *m_contexts[i % contexts];
+    m_threads.emplace_back([&context]() { context.run(); });
+  }
+}
+
+IoRuntime::~IoRuntime() {
+  stop();
+}
+
+boost::asio::any_io_executor IoRuntime::nextExecutor() {
+  if (m_mode == IoRuntimeMode::ThreadPool) {
+    return boost::asio::make_strand(*m_contexts.front());
+  }
+  const std::size_t index =
+      m_next.fetch_add(1, std::memory_order_relaxed) % m_contexts.size();
+  return m_contexts[index]->get_executor();
+}
+
+void IoRuntime::stop() {
+  for (auto& workGuard : m_workGuards) {
+    workGuard.reset();
+  }
+  for (auto& context : m_contexts) {
+    context->stop();
+  }
+  for (auto& thread : m_threads) {
+    if (!thread.joinable())
+      continue;
+    if (thread.get_id() == std::this_thread::get_id())
+      thread.detach();
+    else
+      thread.join();
+  }
+}
+
+void IoRuntime::shutdown() {
+  stop();
+  m_workGuards.clear();
+  m_contexts.clear();
+}
+
+}  // namespace network
+}  // namespace outline
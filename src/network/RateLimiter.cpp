@@ -0,0 +1,88 @@
+#include "outline/network/RateLimiter.h"
+#include "outline/exceptions/OutlineExceptions.h"
+
+#include <algorithm>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace outline {
+namespace network {
+
+RateLimiter::RateLimiter(const RateLimiterOptions& options)
+    : m_options(options),
+      m_tokens(static_cast<double>(options.burst)),
+      m_refilledAt(std::chrono::steady_clock::now()) {
+  m_options.requestsPerSecond = std::max(m_options.requestsPerSecond, 1e-3);
+  m_options.burst = std::max<std::size_t>(m_options.burst, 1);
+}
+
+boost::asio::awaitable<void> RateLimiter::acquire() {
+  if (!m_options.enabled) {
+    co_return;
+  }
+  const auto started = std::chrono::steady_clock::now();
+  std::chrono::duration<double> wait{0};
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refillLocked(started);
+    if (m_tokens >= 1) {
+      m_tokens -= 1;
+      ++m_acquired;
+      co_return;
+    }
+    if (m_options.maxQueueDepth != 0 &&
+        m_waiting >= m_options.maxQueueDepth) {
+      ++m_rejected;
+      throw OutlineRateLimitedException(
+          std::to_string(m_waiting) + " requests are already waiting");
+    }
+    // The token is reserved now and becomes due once the debt of the
+    // requests ahead has been earned back.
+    wait = std::chrono::duration<double>((1 - m_tokens) /
+                                         m_options.requestsPerSecond);
+    m_tokens -= 1;
+    m_maxWaiting = std::max(m_maxWaiting, ++m_waiting);
+  }
+
+  boost::asio::steady_timer timer(
+      co_await boost::asio::this_coro::executor,
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(wait));
+  try {
+    co_await timer.async_wait(boost::asio::use_awaitable);
+  } catch (...) {
+    // A cancelled request hands its reservation back.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tokens += 1;
+    --m_waiting;
+    throw;
+  }
+  m_waits.record(std::chrono::steady_clock::now() - started);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  --m_waiting;
+  ++m_acquired;
+  ++m_delayed;
+}
+
+RateLimiterStats RateLimiter::stats() const {
+  RateLimiterStats stats;
+  stats.waits = m_waits.snapshot();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  stats.acquired = m_acquired;
+  stats.delayed = m_delayed;
+  stats.rejected = m_rejected;
+  stats.queueDepth = m_waiting;
+  stats.maxQueueDepth = m_maxWaiting;
+  return stats;
+}
+
+void RateLimiter::refillLocked(std::chrono::steady_clock::time_point now) {
+  const std::chrono::duration<double> elapsed = now - m_refilledAt;
+  m_refilledAt = now;
+  m_tokens = std::min(static_cast<double>(m_options.burst),
+                      m_tokens + elapsed.count() * m_options.requestsPerSecond);
+}
+
+}  // namespace network
+}  // namespace outline
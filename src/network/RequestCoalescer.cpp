@@ -0,0 +1,143 @@
+#include "outline/network/RequestCoalescer.h"
+
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/system/system_error.hpp>
+
+namespace outline {
+namespace network {
+
+RequestCoalescer::RequestCoalescer(const CoalescingOptions& options)
+    : m_options(options) {}
+
+boost::asio::awaitable<RequestCoalescer::Response> RequestCoalescer::run(
+    std::string key, Fetch fetch) {
+  if (!m_options.enabled) {
+    co_return co_await fetch();
+  }
+  auto executor = co_await boost::asio::this_coro::executor;
+  co_return co_await boost::asio::async_initiate<
+      decltype(boost::asio::use_awaitable),
+      void(std::exception_ptr, Response)>(
+      [&](auto handler) {
+        auto slot = boost::asio::get_associated_cancellation_slot(handler);
+        std::shared_ptr<Flight> flight;
+        std::uint64_t waiter = 0;
+        bool send = false;
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          auto& entry = m_flights[key];
+          if (!entry) {
+            entry = std::make_shared<Flight>();
+            send = true;
+            ++m_sent;
+            ++m_inFlight;
+          } else {
+            ++m_coalesced;
+          }
+          flight = entry;
+          waiter = flight->nextWaiter++;
+          flight->waiters.emplace_back(waiter, std::move(handler));
+        }
+        if (slot.is_connected()) {
+          slot.assign([this, flight, waiter](boost::asio::cancellation_type) {
+            cancel(flight, waiter);
+          });
+        }
+        if (send) {
+          // Not bound to this caller, so its cancellation does not fail the
+          // request for the others. co_spawn keeps fetch alive until the
+          // request completes, so a coroutine lambda may use its captures.
+          boost::asio::co_spawn(
+              executor, std::move(fetch),
+              [this, key, flight](std::exception_ptr error,
+                                  Response response) {
+                complete(key, flight, error, std::move(response));
+              });
+        }
+      },
+      boost::asio::use_awaitable);
+}
+
+void RequestCoalescer::invalidate() {
+  if (!m_options.enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_flights.clear();
+}
+
+CoalescingStats RequestCoalescer::stats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  CoalescingStats stats;
+  stats.sent = m_sent;
+  stats.coalesced = m_coalesced;
+  stats.inFlight = m_inFlight;
+  return stats;
+}
+
+void RequestCoalescer::complete(const std::string& key,
+                                const std::shared_ptr<Flight>& flight,
+                                std::exception_ptr error, Response response) {
+  std::vector<std::pair<std::uint64_t, Handler>> waiters;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_flights.find(key);
+    if (it != m_flights.end() && it->second == flight) {
+      m_flights.erase(it);
+    }
+    --m_inFlight;
+    waiters.swap(flight->waiters);
+  }
+  for (std::size_t i = 0; i < waiters.size(); ++i) {
+    if (i + 1 == waiters.size()) {
+      deliver(std::move(waiters[i].second), error, std::move(response));
+    } else {
+      deliver(std::move(waiters[i].second), error, response);
+    }
+  }
+}
+
+void RequestCoalescer::cancel(const std::shared_ptr<Flight>& flight,
+                              std::uint64_t waiter) {
+  Handler handler;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = flight->waiters.begin(); it != flight->waiters.end();
+         ++it) {
+      if (it->first == waiter) {
+        handler = std::move(it->second);
+        flight->waiters.erase(it);
+        break;
+      }
+    }
+  }
+  // The request already completed if the waiter is gone.
+  if (handler) {
+    deliver(std::move(handler),
+            std::make_exception_ptr(boost::system::system_error(
+                boost::asio::error::operation_aborted)),
+            Response());
+  }
+}
+
+void RequestCoalescer::deliver(Handler handler, std::exception_ptr error,
+                               Response response) {
+  auto executor = boost::asio::get_associated_executor(handler);
+  // The cancellation slot belongs to the caller's executor, so it is only
+  // cleared there, which also keeps cancel() from running inside itself.
+  boost::asio::post(executor, [handler = std::move(handler), error,
+                               response = std::move(response)]() mutable {
+    boost::asio::get_associated_cancellation_slot(handler).clear();
+    std::move(handler)(error, std::move(response));
+  });
+}
+
+}  // namespace network
+}  // namespace outline
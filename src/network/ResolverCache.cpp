@@ -0,0 +1,150 @@
+#include "outline/network/ResolverCache.h"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <memory>
+#include <optional>
+
+namespace outline {
+namespace network {
+
+using tcp = boost::asio::ip::tcp;
+
+ResolverCache::ResolverCache(const ResolverCacheOptions& options)
+    : m_options(options) {}
+
+boost::asio::awaitable<ResolverCache::Results> ResolverCache::resolve(
+    std::string host, std::string port, std::chrono::milliseconds timeout) {
+  if (!m_options.enabled) {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    co_return co_await lookup(std::move(host), std::move(port), timeout);
+  }
+
+  const std::string key = makeKey(host, port);
+  std::optional<Results> cached;
+  bool startRefresh = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+      Entry& entry = it->second;
+      auto age = std::chrono::steady_clock::now() - entry.resolvedAt;
+      if (age < m_options.ttl) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        cached = entry.results;
+      } else if (age < m_options.ttl + m_options.maxStale) {
+        m_staleHits.fetch_add(1, std::memory_order_relaxed);
+        startRefresh = !entry.refreshing;
+        entry.refreshing = true;
+        cached = entry.results;
+      }
+    }
+  }
+  if (startRefresh) {
+    auto executor = co_await boost::asio::this_coro::executor;
+    boost::asio::co_spawn(executor, refreshInBackground(host, port, timeout),
+                          boost::asio::detached);
+  }
+  if (cached) {
+    co_return *cached;
+  }
+
+  m_misses.fetch_add(1, std::memory_order_relaxed);
+  co_return co_await refresh(std::move(host), std::move(port), timeout);
+}
+
+boost::asio::awaitable<ResolverCache::Results> ResolverCache::refresh(
+    std::string host, std::string port, std::chrono::milliseconds timeout) {
+  Results results;
+  try {
+    results = co_await lookup(host, port, timeout);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(makeKey(host, port));
+    if (it != m_entries.end()) {
+      it->second.refreshing = false;
+    }
+    throw;
+  }
+  m_refreshes.fetch_add(1, std::memory_order_relaxed);
+  if (m_options.enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[makeKey(host, port)] =
+        Entry{results, std::chrono::steady_clock::now(), false};
+  }
+  co_return results;
+}
+
+void ResolverCache::invalidate(const std::string& host,
+                               const std::string& port) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.erase(makeKey(host, port));
+}
+
+ResolverCacheStats ResolverCache::stats() const {
+  ResolverCacheStats stats;
+  stats.hits = m_hits.load(std::memory_order_relaxed);
+  stats.staleHits = m_staleHits.load(std::memory_order_relaxed);
+  stats.misses = m_misses.load(std::memory_order_relaxed);
+  stats.refreshes = m_refreshes.load(std::memory_order_relaxed);
+  stats.refreshFailures = m_refreshFailures.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::string ResolverCache::makeKey(const std::string& host,
+                                   const std::string& port) {
+  return host + ":" + port;
+}
+
+boost::asio::awaitable<void> ResolverCache::refreshInBackground(
+    std::string host, std::string port, std::chrono::milliseconds timeout) {
+  try {
+    co_await refresh(std::move(host), std::move(port), timeout);
+  } catch (const std::exception&) {
+    // The stale entry keeps being served until maxStale runs out.
+    m_refreshFailures.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+boost::asio::awaitable<ResolverCache::Results> ResolverCache::lookup(
+    std::string host, std::string port, std::chrono::milliseconds timeout) {
+  auto executor = co_await boost::asio::this_coro::executor;
+  tcp::resolver resolver(executor);
+  boost::asio::steady_timer timer(executor);
+  // Shared with the timer handler, which may already be queued when the
+  // lookup completes and this frame is destroyed.
+  struct Deadline {
+    tcp::resolver* resolver;
+    bool done = false;
+    bool expired = false;
+  };
+  auto deadline = std::make_shared<Deadline>(Deadline{&resolver});
+  if (timeout.count() > 0) {
+    timer.expires_after(timeout);
+    timer.async_wait([deadline](boost::system::error_code ec) {
+      if (!ec && !deadline->done) {
+        deadline->expired = true;
+        deadline->resolver->cancel();
+      }
+    });
+  }
+  boost::system::error_code ec;
+  Results results = co_await resolver.async_resolve(
+      host, port, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+  deadline->done = true;
+  if (deadline->expired) {
+    throw boost::system::system_error(boost::asio::error::timed_out);
+  }
+  if (ec) {
+    throw boost::system::system_error(ec);
+  }
+  co_return results;
+}
+
+}  // namespace network
+}  // namespace outline
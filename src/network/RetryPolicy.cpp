@@ -0,0 +1,35 @@
+#include "outline/network/RetryPolicy.h"
+
+#include <algorithm>
+#include <random>
+
+namespace outline {
+namespace network {
+
+RetryPolicy::RetryPolicy(const RetryOptions& options) : m_options(options) {}
+
+std::chrono::milliseconds RetryPolicy::backoff(int attempt) const {
+  // Doubling stops at the cap, so large attempt numbers cannot overflow.
+  std::chrono::milliseconds ceiling = m_options.initialBackoff;
+  for (int i = 1; i < attempt && ceiling < m_options.maxBackoff; ++i) {
+    ceiling *= 2;
+  }
+  ceiling = std::min(ceiling, m_options.maxBackoff);
+  if (ceiling.count() <= 0) {
+    return std::chrono::milliseconds::zero();
+  }
+  thread_local std::mt19937_64 generator{std::random_device{}()};
+  std::uniform_int_distribution<std::chrono::milliseconds::rep> jitter(
+      0, ceiling.count());
+  return std::chrono::milliseconds(jitter(generator));
+}
+
+RetryStats RetryPolicy::stats() const {
+  RetryStats stats;
+  stats.retries = m_retries.load(std::memory_order_relaxed);
+  stats.exhausted = m_exhausted.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace network
+}  // namespace outline
@@ -0,0 +1,101 @@
+#include "outline/network/TlsSessionCache.h"
+
+namespace outline {
+namespace network {
+
+namespace {
+
+int peerIndex() {
+  static const int index =
+      SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+int cacheIndex() {
+  static const int index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+}  // namespace
+
+TlsSessionCache::TlsSessionCache(TlsSessionOptions options)
+    : m_options(std::move(options)) {}
+
+TlsSessionCache::~TlsSessionCache() = default;
+
+void TlsSessionCache::attach(boost::asio::ssl::context& context) {
+  if (!m_options.resumption) {
+    return;
+  }
+  SSL_CTX* ctx = context.native_handle();
+  SSL_CTX_set_ex_data(ctx, cacheIndex(), this);
+  SSL_CTX_set_session_cache_mode(
+      ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, &TlsSessionCache::onNewSession);
+}
+
+void TlsSessionCache::prepare(SSL* ssl, const std::string& peer) {
+  if (!m_options.resumption) {
+    return;
+  }
+  SSL_set_ex_data(ssl, peerIndex(), const_cast<std::string*>(&peer));
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_sessions.find(peer);
+  if (it != m_sessions.end()) {
+    // SSL_set_session takes its own reference.
+    SSL_set_session(ssl, it->second.get());
+  }
+}
+
+void TlsSessionCache::recordHandshake(SSL* ssl, const std::string& peer,
+                                      std::chrono::nanoseconds duration) {
+  const bool resumed = SSL_session_reused(ssl) == 1;
+  if (resumed) {
+    m_resumedHandshakes.fetch_add(1, std::memory_order_relaxed);
+    m_resumedHandshakeNs.fetch_add(duration.count(),
+                                   std::memory_order_relaxed);
+  } else {
+    m_fullHandshakes.fetch_add(1, std::memory_order_relaxed);
+    m_fullHandshakeNs.fetch_add(duration.count(), std::memory_order_relaxed);
+  }
+  if (m_options.onHandshake) {
+    m_options.onHandshake(TlsHandshakeEvent{peer, resumed, duration});
+  }
+}
+
+void TlsSessionCache::erase(const std::string& peer) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_sessions.erase(peer);
+}
+
+TlsHandshakeStats TlsSessionCache::stats() const {
+  TlsHandshakeStats stats;
+  stats.fullHandshakes = m_fullHandshakes.load(std::memory_order_relaxed);
+  stats.resumedHandshakes = m_resumedHandshakes.load(std::memory_order_relaxed);
+  stats.fullHandshakeTime = std::chrono::nanoseconds(
+      m_fullHandshakeNs.load(std::memory_order_relaxed));
+  stats.resumedHandshakeTime = std::chrono::nanoseconds(
+      m_resumedHandshakeNs.load(std::memory_order_relaxed));
+  return stats;
+}
+
+int TlsSessionCache::onNewSession(SSL* ssl, SSL_SESSION* session) {
+  auto* cache = static_cast<TlsSessionCache*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), cacheIndex()));
+  auto* peer = static_cast<std::string*>(SSL_get_ex_data(ssl, peerIndex()));
+  if (cache == nullptr || peer == nullptr) {
+    return 0;
+  }
+  cache->store(*peer, session);
+  // Returning 1 keeps the reference passed to the callback.
+  return 1;
+}
+
+void TlsSessionCache::store(const std::string& peer, SSL_SESSION* session) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_sessions[peer] = SessionPtr(session);
+}
+
+}  // namespace network
+}  // namespace outline
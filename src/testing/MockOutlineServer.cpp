@@ -0,0 +1,590 @@
+#include "outline/testing/MockOutlineServer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <boost/beast/http/read.hpp>
+#include <boost/beast/http/serializer.hpp>
+#include <boost/beast/http/write.hpp>
+#include <boost/beast/ssl/ssl_stream.hpp>
+#include <boost/json.hpp>
+
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <zlib.h>
+
+namespace outline {
+namespace testing {
+
+namespace http = boost::beast::http;
+using tcp = boost::asio::ip::tcp;
+
+namespace {
+
+/**
+ * @brief Installs a fresh EC P-256 key and a self-signed certificate for
+ *        "localhost" into the context.
+ */
+void useSelfSignedCertificate(boost::asio::ssl::context& context) {
+  std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> keyContext(
+      EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), EVP_PKEY_CTX_free);
+  EVP_PKEY* rawKey = nullptr;
+  if (!keyContext || EVP_PKEY_keygen_init(keyContext.get()) <= 0 ||
+      EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyContext.get(),
+                                             NID_X9_62_prime256v1) <= 0 ||
+      EVP_PKEY_keygen(keyContext.get(), &rawKey) <= 0) {
+    throw std::runtime_error("Unable to generate the mock server key");
+  }
+  std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(rawKey,
+                                                          EVP_PKEY_free);
+
+  std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+  if (!cert) {
+    throw std::runtime_error("Unable to create the mock server certificate");
+  }
+  X509_set_version(cert.get(), 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert.get()), 365L * 24 * 3600);
+  X509_set_pubkey(cert.get(), key.get());
+  X509_NAME* name = X509_get_subject_name(cert.get());
+  X509_NAME_add_entry_by_txt(
+      name, "CN", MBSTRING_ASC,
+      reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+  X509_set_issuer_name(cert.get(), name);
+  if (X509_sign(cert.get(), key.get(), EVP_sha256()) <= 0 ||
+      SSL_CTX_use_certificate(context.native_handle(), cert.get()) != 1 ||
+      SSL_CTX_use_PrivateKey(context.native_handle(), key.get()) != 1) {
+    throw std::runtime_error("Unable to sign the mock server certificate");
+  }
+}
+
+boost::json::object keyToJson(const AccessKey& key) {
+  boost::json::object obj{{"id", key.id},
+                          {"name", key.name},
+                          {"password", key.password},
+                          {"port", key.port},
+                          {"method", key.method},
+                          {"accessUrl", key.accessUrl}};
+  if (key.dataLimit) {
+    obj["dataLimit"] = boost::json::object{{"bytes", key.dataLimit->bytes}};
+  }
+  return obj;
+}
+
+/**
+ * @brief Reads the limit of a data limit body, which is {"bytes": N} or
+ *        {"limit": {"bytes": N}}.
+ */
+std::optional<std::int64_t> readLimit(const boost::json::object& obj) {
+  const boost::json::object* limit = &obj;
+  if (const auto* nested = obj.if_contains("limit")) {
+    limit = nested->if_object();
+  }
+  const boost::json::value* bytes =
+      limit != nullptr ? limit->if_contains("bytes") : nullptr;
+  if (bytes == nullptr || !bytes->is_int64()) {
+    return std::nullopt;
+  }
+  return bytes->as_int64();
+}
+
+/**
+ * @brief Parses the request body as a JSON object, or returns an empty one if
+ *        it is not.
+ */
+boost::json::object parseBody(const std::string& body) {
+  boost::json::error_code ec;
+  boost::json::value value = boost::json::parse(body, ec);
+  if (ec || !value.is_object()) {
+    return {};
+  }
+  return std::move(value.as_object());
+}
+
+http::response<http::string_body> makeResponse(
+    const http::request<http::string_body>& request, http::status status,
+    const boost::json::value* body) {
+  http::response<http::string_body> response(status, request.version());
+  if (body != nullptr) {
+    response.set(http::field::content_type, "application/json");
+    response.body() = boost::json::serialize(*body);
+  }
+  return response;
+}
+
+/**
+ * @brief Returns true if the Accept-Encoding header lists the coding.
+ *        Quality values are ignored.
+ */
+bool accepts(std::string_view acceptEncoding, std::string_view coding) {
+  while (!acceptEncoding.empty()) {
+    const std::size_t comma = acceptEncoding.find(',');
+    std::string_view item = acceptEncoding.substr(0, comma);
+    item = item.substr(0, item.find(';'));
+    while (!item.empty() && item.front() == ' ') {
+      item.remove_prefix(1);
+    }
+    while (!item.empty() && item.back() == ' ') {
+      item.remove_suffix(1);
+    }
+    if (item == coding) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    acceptEncoding.remove_prefix(comma + 1);
+  }
+  return false;
+}
+
+/**
+ * @brief Compresses the body in place in the gzip format, or the zlib
+ *        format for "deflate", if the request accepts one of them.
+ * @return true if the body was compressed.
+ */
+bool compressBody(const http::request<http::string_body>& request,
+                  http::response<http::string_body>& response) {
+  auto header = request[http::field::accept_encoding];
+  const std::string_view acceptEncoding(header.data(), header.size());
+  const bool gzip = accepts(acceptEncoding, "gzip");
+  if (response.body().empty() ||
+      (!gzip && !accepts(acceptEncoding, "deflate"))) {
+    return false;
+  }
+  z_stream stream{};
+  // Adding 16 to the window bits writes a gzip header instead of a zlib one.
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                   gzip ? MAX_WBITS + 16 : MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  std::string& body = response.body();
+  std::string compressed(deflateBound(&stream, body.size()) + 32, '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(body.data());
+  stream.avail_in = static_cast<uInt>(body.size());
+  stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+  stream.avail_out = static_cast<uInt>(compressed.size());
+  const int result = deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  if (result != Z_STREAM_END) {
+    return false;
+  }
+  body = std::move(compressed);
+  response.set(http::field::content_encoding, gzip ? "gzip" : "deflate");
+  response.set(http::field::vary, "Accept-Encoding");
+  return true;
+}
+
+/**
+ * @brief Writes the response in small pieces at no more than
+ *        bytesPerSecond.
+ */
+template <typename Stream>
+boost::asio::awaitable<void> writeThrottled(
+    Stream& stream, http::response<http::string_body>& response,
+    std::size_t bytesPerSecond) {
+  http::response_serializer<http::string_body> serializer(response);
+  // Small pieces keep the pace even.
+  serializer.limit(4096);
+  boost::asio::steady_timer timer(stream.get_executor());
+  auto next = std::chrono::steady_clock::now();
+  while (!serializer.is_done()) {
+    const std::size_t written = co_await http::async_write_some(
+        stream, serializer, boost::asio::use_awaitable);
+    next += std::chrono::nanoseconds(written * 1000000000ull /
+                                     bytesPerSecond);
+    timer.expires_at(next);
+    co_await timer.async_wait(boost::asio::use_awaitable);
+  }
+}
+
+std::string readString(const boost::json::object& obj, const char* field,
+                       std::string fallback) {
+  const boost::json::value* value = obj.if_contains(field);
+  if (value == nullptr || !value->is_string()) {
+    return fallback;
+  }
+  return std::string(value->as_string());
+}
+
+}  // namespace
+
+MockOutlineServer::MockOutlineServer(const MockServerOptions& options)
+    : m_options(options),
+      m_sslContext(boost::asio::ssl::context::tls_server),
+      m_context(static_cast<int>(std::max<std::size_t>(options.threads, 1))),
+      m_acceptor(m_context) {
+  useSelfSignedCertificate(m_sslContext);
+  for (std::size_t i = 0; i < options.initialKeys; ++i) {
+    AccessKey key = makeKey(std::to_string(m_nextId));
+    key.name = "key-" + key.id;
+    m_keys.emplace(m_nextId++, std::move(key));
+  }
+
+  tcp::endpoint endpoint(boost::asio::ip::make_address("127.0.0.1"),
+                         options.port);
+  m_acceptor.open(endpoint.protocol());
+  m_acceptor.set_option(tcp::acceptor::reuse_address(true));
+  m_acceptor.bind(endpoint);
+  m_acceptor.listen();
+  m_port = m_acceptor.local_endpoint().port();
+
+  boost::asio::co_spawn(m_acceptor.get_executor(), accept(),
+                        boost::asio::detached);
+  const std::size_t threads = std::max<std::size_t>(options.threads, 1);
+  for (std::size_t i = 0; i < threads; ++i) {
+    m_threads.emplace_back([this]() { m_context.run(); });
+  }
+}
+
+MockOutlineServer::~MockOutlineServer() {
+  stop();
+}
+
+std::string MockOutlineServer::apiUrl() const {
+  return "https://127.0.0.1:" + std::to_string(m_port) + "/" +
+         m_options.secret;
+}
+
+std::size_t MockOutlineServer::keyCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_keys.size();
+}
+
+MockServerStats MockOutlineServer::stats() const {
+  MockServerStats stats;
+  stats.connections = m_connections.load(std::memory_order_relaxed);
+  stats.requests = m_requests.load(std::memory_order_relaxed);
+  stats.injectedErrors = m_injectedErrors.load(std::memory_order_relaxed);
+  stats.droppedConnections =
+      m_droppedConnections.load(std::memory_order_relaxed);
+  stats.compressedResponses =
+      m_compressedResponses.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void MockOutlineServer::stop() {
+  m_context.stop();
+  for (auto& thread : m_threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  m_threads.clear();
+  boost::system::error_code ec;
+  m_acceptor.close(ec);
+}
+
+boost::asio::awaitable<void> MockOutlineServer::accept() {
+  for (;;) {
+    // Every connection gets its own strand, so a multi-threaded server never
+    // runs one session on two threads.
+    tcp::socket socket(boost::asio::make_strand(m_context));
+    boost::system::error_code ec;
+    co_await m_acceptor.async_accept(
+        socket, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    if (ec == boost::asio::error::operation_aborted || !m_acceptor.is_open()) {
+      co_return;
+    }
+    if (ec) {
+      continue;
+    }
+    m_connections.fetch_add(1, std::memory_order_relaxed);
+    auto executor = socket.get_executor();
+    boost::asio::co_spawn(executor, serve(std::move(socket)),
+                          boost::asio::detached);
+  }
+}
+
+boost::asio::awaitable<void> MockOutlineServer::serve(tcp::socket socket) {
+  boost::beast::ssl_stream<boost::beast::tcp_stream> stream(std::move(socket),
+                                                            m_sslContext);
+  boost::beast::flat_buffer buffer;
+  try {
+    co_await stream.async_handshake(boost::asio::ssl::stream_base::server,
+                                    boost::asio::use_awaitable);
+    for (;;) {
+      Request request;
+      co_await http::async_read(stream, buffer, request,
+                                boost::asio::use_awaitable);
+      m_requests.fetch_add(1, std::memory_order_relaxed);
+      if (chance(m_options.dropRate)) {
+        m_droppedConnections.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+      }
+      const auto wait = responseDelay();
+      if (wait.count() > 0) {
+        boost::asio::steady_timer timer(stream.get_executor(), wait);
+        co_await timer.async_wait(boost::asio::use_awaitable);
+      }
+
+      Response response;
+      if (chance(m_options.errorRate)) {
+        m_injectedErrors.fetch_add(1, std::memory_order_relaxed);
+        response = Response(static_cast<http::status>(m_options.errorStatus),
+                            request.version());
+      } else {
+        response = handle(request);
+      }
+      if (m_options.compression && compressBody(request, response)) {
+        m_compressedResponses.fetch_add(1, std::memory_order_relaxed);
+      }
+      response.keep_alive(request.keep_alive());
+      response.prepare_payload();
+      if (m_options.bytesPerSecond > 0) {
+        co_await writeThrottled(stream, response, m_options.bytesPerSecond);
+      } else {
+        co_await http::async_write(stream, response,
+                                   boost::asio::use_awaitable);
+      }
+      if (!response.keep_alive()) {
+        break;
+      }
+    }
+    boost::system::error_code ec;
+    co_await stream.async_shutdown(
+        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+  } catch (const std::exception&) {
+    // The client closed the connection or sent something unreadable.
+  }
+}
+
+MockOutlineServer::Response MockOutlineServer::handle(
+    const Request& request) {
+  auto reply = [&request](http::status status,
+                          const boost::json::value* body = nullptr) {
+    return makeResponse(request, status, body);
+  };
+
+  std::string_view target(request.target().data(), request.target().size());
+  target = target.substr(0, target.find('?'));
+  const std::string prefix = "/" + m_options.secret;
+  if (target.substr(0, prefix.size()) != prefix) {
+    return reply(http::status::not_found);
+  }
+  const std::string_view path = target.substr(prefix.size());
+  const http::verb verb = request.method();
+  const boost::json::object body = parseBody(request.body());
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (path == "/server" && verb == http::verb::get) {
+    boost::json::value info = boost::json::object{
+        {"name", m_serverName},
+        {"serverId", "mock-server"},
+        {"metricsEnabled", m_metricsEnabled},
+        {"createdTimestampMs", 1700000000000},
+        {"version", "1.0.0-mock"},
+        {"portForNewAccessKeys", m_portForNewAccessKeys},
+        {"hostnameForAccessKeys", m_hostname}};
+    if (m_accessKeyDataLimit) {
+      info.as_object()["accessKeyDataLimit"] =
+          boost::json::object{{"bytes", *m_accessKeyDataLimit}};
+    }
+    return reply(http::status::ok, &info);
+  }
+  if (path == "/name" && verb == http::verb::put) {
+    m_serverName = readString(body, "name", m_serverName);
+    return reply(http::status::no_content);
+  }
+  if (path == "/server/hostname-for-access-keys" && verb == http::verb::put) {
+    m_hostname = readString(body, "hostname", m_hostname);
+    return reply(http::status::no_content);
+  }
+  if (path == "/server/port-for-new-access-keys" && verb == http::verb::put) {
+    const boost::json::value* port = body.if_contains("port");
+    if (port == nullptr || !port->is_int64()) {
+      return reply(http::status::bad_request);
+    }
+    m_portForNewAccessKeys = static_cast<int>(port->as_int64());
+    return reply(http::status::no_content);
+  }
+  if (path == "/server/access-key-data-limit") {
+    if (verb == http::verb::delete_) {
+      m_accessKeyDataLimit.reset();
+      return reply(http::status::no_content);
+    }
+    if (verb == http::verb::put) {
+      m_accessKeyDataLimit = readLimit(body);
+      return reply(m_accessKeyDataLimit ? http::status::no_content
+                                        : http::status::bad_request);
+    }
+  }
+  if (path == "/metrics/enabled") {
+    if (verb == http::verb::get) {
+      boost::json::value enabled =
+          boost::json::object{{"metricsEnabled", m_metricsEnabled}};
+      return reply(http::status::ok, &enabled);
+    }
+    if (verb == http::verb::put) {
+      const boost::json::value* enabled = body.if_contains("metricsEnabled");
+      if (enabled == nullptr || !enabled->is_bool()) {
+        return reply(http::status::bad_request);
+      }
+      m_metricsEnabled = enabled->as_bool();
+      return reply(http::status::no_content);
+    }
+  }
+  if (path == "/metrics/transfer" && verb == http::verb::get) {
+    // Every key transfers a steady amount between two polls, so pollers see
+    // counters which only grow.
+    boost::json::object transferred;
+    for (const auto& [number, key] : m_keys) {
+      std::uint64_t& bytes = m_bytesTransferred[key.id];
+      bytes += (number % 16 + 1) * 1024;
+      transferred[key.id] = bytes;
+    }
+    boost::json::value metrics =
+        boost::json::object{{"bytesTransferredByUserId", transferred}};
+    return reply(http::status::ok, &metrics);
+  }
+  if (path == "/access-keys") {
+    if (verb == http::verb::get) {
+      boost::json::array keys;
+      keys.reserve(m_keys.size());
+      for (const auto& entry : m_keys) {
+        keys.push_back(keyToJson(entry.second));
+      }
+      boost::json::value list = boost::json::object{{"accessKeys", keys}};
+      return reply(http::status::ok, &list);
+    }
+    if (verb == http::verb::post) {
+      AccessKey key = makeKey(std::to_string(m_nextId));
+      key.name = readString(body, "name", key.name);
+      key.password = readString(body, "password", key.password);
+      key.method = readString(body, "method", key.method);
+      if (auto limit = readLimit(body)) {
+        key.dataLimit = DataLimit{*limit};
+      }
+      boost::json::value created = keyToJson(key);
+      m_keys.emplace(m_nextId++, std::move(key));
+      return reply(http::status::created, &created);
+    }
+  }
+  constexpr std::string_view keysPrefix = "/access-keys/";
+  if (path.substr(0, keysPrefix.size()) == keysPrefix) {
+    std::string_view rest = path.substr(keysPrefix.size());
+    const std::size_t slash = rest.find('/');
+    const std::string id(rest.substr(0, slash));
+    const std::string_view action =
+        slash == std::string_view::npos ? std::string_view()
+                                        : rest.substr(slash);
+    return handleAccessKey(request, body, id, action);
+  }
+  return reply(http::status::not_found);
+}
+
+MockOutlineServer::Response MockOutlineServer::handleAccessKey(
+    const Request& request, const boost::json::object& body,
+    const std::string& id, std::string_view action) {
+  auto reply = [&request](http::status status,
+                          const boost::json::value* body = nullptr) {
+    return makeResponse(request, status, body);
+  };
+
+  // Ids are decimal numbers; anything else names a key which does not exist.
+  std::uint64_t number = 0;
+  const auto [end, ec] = std::from_chars(id.data(), id.data() + id.size(),
+                                         number);
+  const bool validId = ec == std::errc() && end == id.data() + id.size();
+  auto it = validId ? m_keys.find(number) : m_keys.end();
+  const http::verb verb = request.method();
+
+  if (action.empty() && verb == http::verb::put) {
+    // Creates the key with this id or replaces it.
+    if (!validId) {
+      return reply(http::status::bad_request);
+    }
+    AccessKey key = makeKey(id);
+    key.name = readString(body, "name", key.name);
+    key.password = readString(body, "password", key.password);
+    key.method = readString(body, "method", key.method);
+    if (auto limit = readLimit(body)) {
+      key.dataLimit = DataLimit{*limit};
+    }
+    boost::json::value updated = keyToJson(key);
+    m_keys.insert_or_assign(number, std::move(key));
+    m_nextId = std::max(m_nextId, number + 1);
+    return reply(http::status::created, &updated);
+  }
+  if (it == m_keys.end()) {
+    return reply(http::status::not_found);
+  }
+  AccessKey& key = it->second;
+  if (action.empty()) {
+    if (verb == http::verb::get) {
+      boost::json::value found = keyToJson(key);
+      return reply(http::status::ok, &found);
+    }
+    if (verb == http::verb::delete_) {
+      m_bytesTransferred.erase(key.id);
+      m_keys.erase(it);
+      return reply(http::status::no_content);
+    }
+  } else if (action == "/name" && verb == http::verb::put) {
+    key.name = readString(body, "name", key.name);
+    return reply(http::status::no_content);
+  } else if (action == "/data-limit") {
+    if (verb == http::verb::delete_) {
+      key.dataLimit.reset();
+      return reply(http::status::no_content);
+    }
+    if (verb == http::verb::put) {
+      auto limit = readLimit(body);
+      if (!limit) {
+        return reply(http::status::bad_request);
+      }
+      key.dataLimit = DataLimit{*limit};
+      return reply(http::status::no_content);
+    }
+  }
+  return reply(http::status::not_found);
+}
+
+AccessKey MockOutlineServer::makeKey(std::string id) {
+  AccessKey key;
+  key.id = std::move(id);
+  key.password = "password-" + key.id;
+  key.port = m_portForNewAccessKeys;
+  key.method = "chacha20-ietf-poly1305";
+  key.accessUrl = "ss://mock@" + m_hostname + ":" +
+                  std::to_string(m_portForNewAccessKeys) + "/?outline=1";
+  return key;
+}
+
+bool MockOutlineServer::chance(double probability) const {
+  if (probability <= 0) {
+    return false;
+  }
+  thread_local std::mt19937_64 generator{std::random_device{}()};
+  return std::uniform_real_distribution<double>(0, 1)(generator) <
+         probability;
+}
+
+std::chrono::milliseconds MockOutlineServer::responseDelay() const {
+  if (m_options.latencyJitter.count() <= 0) {
+    return m_options.latency;
+  }
+  thread_local std::mt19937_64 generator{std::random_device{}()};
+  std::uniform_int_distribution<std::int64_t> jitter(
+      0, m_options.latencyJitter.count());
+  return m_options.latency + std::chrono::milliseconds(jitter(generator));
+}
+
+}  // namespace testing
+}  // namespace outline
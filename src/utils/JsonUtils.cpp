@@ -0,0 +1,20 @@
+#include "outline/utils/JsonUtils.h"
+
+namespace outline {
+namespace utils {
+
+boost::json::value parseJson(std::string_view body, std::string_view what,
+                             boost::json::storage_ptr storage) {
+  boost::json::error_code ec;
+  boost::json::value jv = boost::json::parse(
+      boost::json::string_view(body.data(), body.size()), ec,
+      std::move(storage));
+  if (ec) {
+    throw OutlineParseException("JSON parse error for " + std::string(what) +
+                                ": " + ec.message());
+  }
+  return jv;
+}
+
+}  // namespace utils
+}  // namespace outline
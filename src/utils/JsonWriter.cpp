@@ -0,0 +1,51 @@
+#include "outline/utils/JsonWriter.h"
+
+namespace outline {
+namespace utils {
+
+void JsonWriter::writeString(std::string_view text) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  m_out.push_back('"');
+  // Copies the runs which need no escaping in one append.
+  std::size_t runStart = 0;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    m_out.append(text.data() + runStart, i - runStart);
+    runStart = i + 1;
+    m_out.push_back('\\');
+    switch (c) {
+      case '"':
+      case '\\':
+        m_out.push_back(static_cast<char>(c));
+        break;
+      case '\b':
+        m_out.push_back('b');
+        break;
+      case '\f':
+        m_out.push_back('f');
+        break;
+      case '\n':
+        m_out.push_back('n');
+        break;
+      case '\r':
+        m_out.push_back('r');
+        break;
+      case '\t':
+        m_out.push_back('t');
+        break;
+      default:
+        m_out.append("u00");
+        m_out.push_back(kHex[c >> 4]);
+        m_out.push_back(kHex[c & 0x0F]);
+        break;
+    }
+  }
+  m_out.append(text.data() + runStart, text.size() - runStart);
+  m_out.push_back('"');
+}
+
+}  // namespace utils
+}  // namespace outline
@@ -0,0 +1,101 @@
+#include "outline/utils/RequestArena.h"
+
+#include <boost/json/serializer.hpp>
+
+#include <new>
+
+namespace outline {
+namespace utils {
+
+void* CountingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  m_allocations.fetch_add(1, std::memory_order_relaxed);
+  m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  return ::operator new(bytes, std::align_val_t(alignment));
+}
+
+void CountingResource::do_deallocate(void* p, std::size_t bytes,
+                                     std::size_t alignment) {
+  ::operator delete(p, bytes, std::align_val_t(alignment));
+}
+
+bool CountingResource::do_is_equal(
+    const boost::json::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+RequestArena::RequestArena(std::size_t bufferSize,
+                           CountingResource& upstream)
+    : m_buffer(new unsigned char[bufferSize]),
+      m_resource(m_buffer.get(), bufferSize,
+                 boost::json::storage_ptr(&upstream)),
+      m_storage(&m_resource) {}
+
+const std::string& RequestArena::serialize(const boost::json::value& value) {
+  m_body.clear();
+  boost::json::serializer serializer;
+  serializer.reset(&value);
+  char chunk[1024];
+  while (!serializer.done()) {
+    auto part = serializer.read(chunk, sizeof(chunk));
+    m_body.append(part.data(), part.size());
+  }
+  return m_body;
+}
+
+JsonWriter RequestArena::writeBody() {
+  m_body.clear();
+  return JsonWriter(m_body);
+}
+
+void RequestArena::reset() {
+  m_resource.release();
+  m_body.clear();
+}
+
+void ArenaReleaser::operator()(RequestArena* arena) const {
+  if (pool != nullptr) {
+    pool->release(arena);
+  } else {
+    delete arena;
+  }
+}
+
+ArenaPool::ArenaPool(const ArenaOptions& options) : m_options(options) {}
+
+ArenaPool::~ArenaPool() = default;
+
+ArenaLease ArenaPool::acquire() {
+  m_leases.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_idle.empty()) {
+      RequestArena* arena = m_idle.back().release();
+      m_idle.pop_back();
+      return ArenaLease(arena, ArenaReleaser{this});
+    }
+  }
+  m_arenasCreated.fetch_add(1, std::memory_order_relaxed);
+  return ArenaLease(new RequestArena(m_options.bufferSize, m_upstream),
+                    ArenaReleaser{this});
+}
+
+ArenaStats ArenaPool::stats() const {
+  ArenaStats stats;
+  stats.leases = m_leases.load(std::memory_order_relaxed);
+  stats.arenasCreated = m_arenasCreated.load(std::memory_order_relaxed);
+  stats.overflowAllocations = m_upstream.allocations();
+  stats.overflowBytes = m_upstream.bytes();
+  return stats;
+}
+
+void ArenaPool::release(RequestArena* arena) {
+  std::unique_ptr<RequestArena> owned(arena);
+  owned->reset();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_idle.size() < m_options.maxIdleArenas) {
+    m_idle.push_back(std::move(owned));
+  }
+}
+
+}  // namespace utils
+}  // namespace outline
@@ -40,3 +40,31 @@ TEST_F(AccessKeysTest, GetAccessKeysSuccess) {
   boost::json::object dataLimitObj = createResponseObj["dataLimit"].as_object();
   EXPECT_EQ(dataLimitObj["bytes"].as_int64(), params.data_limit_bytes);
 }
+
+TEST_F(AccessKeysTest, ApplyAccessKeyOperationsReportsEachItem) {
+  std::vector<outline::AccessKeyOperation> creates;
+  for (int i = 0; i < 3; ++i) {
+    outline::CreateAccessKeyParams params;
+    params.name = "auto_testing_bulk_" + std::to_string(i);
+    creates.push_back(outline::AccessKeyOperation::create(params));
+  }
+  auto created = client->applyAccessKeyOperations(creates, 2);
+  ASSERT_EQ(created.size(), 3u);
+
+  std::vector<outline::AccessKeyOperation> deletes;
+  for (const auto& result : created) {
+    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.accessKey.has_value());
+    deletes.push_back(outline::AccessKeyOperation::remove(result.accessKey->id));
+  }
+  deletes.push_back(
+      outline::AccessKeyOperation::remove("auto_testing_missing_key"));
+  auto deleted = client->applyAccessKeyOperations(deletes, 2);
+  ASSERT_EQ(deleted.size(), 4u);
+  for (std::size_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(deleted[i].success);
+  }
+  EXPECT_FALSE(deleted[3].success);
+  EXPECT_EQ(deleted[3].status, 404);
+  EXPECT_TRUE(deleted[3].error != nullptr);
+}
@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+#include <boost/json.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include "../include/outline/AccessKeyReconciler.h"
+#include "../include/outline/exceptions/OutlineExceptions.h"
+#include "../include/outline/metrics/MetricsArchive.h"
+#include "../include/outline/metrics/UsageSeries.h"
+#include "../include/outline/models/AccessKey.h"
+#include "../include/outline/models/AccessKeyStreamParser.h"
+#include "../include/outline/models/ServerInformation.h"
+#include "../include/outline/models/TransferMetrics.h"
+#include "../include/outline/utils/JsonUtils.h"
+#include "../include/outline/utils/JsonWriter.h"
+#include "../include/outline/utils/RequestArena.h"
+#include "../include/outline/utils/UrlUtils.h"
+
+TEST(ModelsTest, ParsesAccessKeys) {
+  std::string body = R"({"accessKeys":[
+      {"id":"0","name":"alice","password":"p0","port":12345,
+       "method":"chacha20-ietf-poly1305","dataLimit":{"bytes":1024},
+       "accessUrl":"ss://a"},
+      {"id":"1","name":"","password":"p1","port":12345,
+       "method":"chacha20-ietf-poly1305","accessUrl":"ss://b"}]})";
+  std::vector<outline::AccessKey> keys = outline::accessKeysFromJson(
+      outline::utils::parseJson(body, "access keys"));
+  ASSERT_EQ(keys.size(), 2u);
+  EXPECT_EQ(keys[0].id, "0");
+  EXPECT_EQ(keys[0].name, "alice");
+  EXPECT_EQ(keys[0].port, 12345);
+  ASSERT_TRUE(keys[0].dataLimit.has_value());
+  EXPECT_EQ(keys[0].dataLimit->bytes, 1024);
+  EXPECT_FALSE(keys[1].dataLimit.has_value());
+  EXPECT_EQ(keys[1].accessUrl, "ss://b");
+}
+
+TEST(ModelsTest, ParsesServerInformation) {
+  std::string body = R"({"name":"Server","serverId":"abc",
+      "metricsEnabled":true,"createdTimestampMs":1729449481512,
+      "version":"1.11.0","portForNewAccessKeys":443,
+      "hostnameForAccessKeys":"vpn.example.com"})";
+  auto info =
+      outline::utils::parseJsonAs<outline::ServerInformation>(body, "server");
+  EXPECT_EQ(info.name, "Server");
+  EXPECT_TRUE(info.metricsEnabled);
+  EXPECT_EQ(info.createdTimestampMs, 1729449481512);
+  EXPECT_EQ(info.portForNewAccessKeys, 443);
+  EXPECT_FALSE(info.accessKeyDataLimit.has_value());
+}
+
+TEST(ModelsTest, ParsesTransferMetrics) {
+  std::string body = R"({"bytesTransferredByUserId":{"0":10,"1":20}})";
+  auto metrics =
+      outline::utils::parseJsonAs<outline::TransferMetrics>(body, "metrics");
+  ASSERT_EQ(metrics.bytesTransferredByUserId.size(), 2u);
+  EXPECT_EQ(metrics.bytesTransferredByUserId.at("1"), 20u);
+}
+
+TEST(ModelsTest, InvalidStructureThrowsParseException) {
+  EXPECT_THROW(outline::utils::parseJsonAs<outline::TransferMetrics>(
+                   R"({"other":1})", "metrics"),
+               outline::OutlineParseException);
+  EXPECT_THROW(outline::utils::parseJson("{", "metrics"),
+               outline::OutlineParseException);
+}
+
+TEST(ModelsTest, StreamParserEmitsKeysAcrossChunks) {
+  std::string body = R"({"accessKeys":[
+      {"id":"0","name":"alice","port":1,"dataLimit":{"bytes":7},
+       "extra":{"name":"ignored","bytes":1}},
+      {"id":"1","name":"bob","port":2}]})";
+  std::vector<outline::AccessKey> keys;
+  outline::AccessKeyStreamParser parser(
+      [&keys](outline::AccessKey&& key) { keys.push_back(std::move(key)); });
+  for (char c : body) {
+    parser.write(std::string_view(&c, 1));
+  }
+  parser.finish();
+  ASSERT_EQ(parser.count(), 2u);
+  ASSERT_EQ(keys.size(), 2u);
+  EXPECT_EQ(keys[0].name, "alice");
+  ASSERT_TRUE(keys[0].dataLimit.has_value());
+  EXPECT_EQ(keys[0].dataLimit->bytes, 7);
+  EXPECT_EQ(keys[1].id, "1");
+  EXPECT_EQ(keys[1].port, 2);
+  EXPECT_FALSE(keys[1].dataLimit.has_value());
+}
+
+TEST(ModelsTest, StreamParserRejectsMissingKeysArray) {
+  outline::AccessKeyStreamParser parser([](outline::AccessKey&&) {});
+  parser.write(R"({"other":[]})");
+  EXPECT_THROW(parser.finish(), outline::OutlineParseException);
+}
+
+TEST(RequestArenaTest, ReusesArenasAndCountsOverflow) {
+  outline::utils::ArenaOptions options;
+  options.bufferSize = 256;
+  outline::utils::ArenaPool pool(options);
+  {
+    auto arena = pool.acquire();
+    boost::json::object obj({{"name", "alice"}}, arena->storage());
+    EXPECT_EQ(arena->serialize(obj), R"({"name":"alice"})");
+  }
+  EXPECT_EQ(pool.stats().overflowAllocations, 0u);
+  {
+    auto arena = pool.acquire();
+    std::string body = "[\"" + std::string(4096, 'x') + "\"]";
+    outline::utils::parseJson(body, "large body", arena->storage());
+  }
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.leases, 2u);
+  EXPECT_EQ(stats.arenasCreated, 1u);
+  EXPECT_GT(stats.overflowAllocations, 0u);
+}
+
+TEST(JsonWriterTest, EscapesValuesAndParsesBack) {
+  outline::utils::ArenaPool pool({});
+  auto arena = pool.acquire();
+  outline::utils::JsonWriter writer = arena->writeBody();
+  writer.beginObject().field("name", "a\"b\\c\n\x01").field("port", 443);
+  writer.field("enabled", false).key("limit").beginObject();
+  writer.field("bytes", std::int64_t{5000000000}).endObject().endObject();
+  EXPECT_EQ(writer.str(),
+            R"({"name":"a\"b\\c\n\u0001","port":443,"enabled":false,)"
+            R"("limit":{"bytes":5000000000}})");
+
+  auto value = boost::json::parse(writer.str());
+  EXPECT_EQ(boost::json::value_to<std::string>(value.as_object().at("name")),
+            "a\"b\\c\n\x01");
+  // The next body replaces the previous one.
+  outline::utils::JsonWriter next = arena->writeBody();
+  next.beginObject().field("metricsEnabled", true).endObject();
+  EXPECT_EQ(next.str(), R"({"metricsEnabled":true})");
+}
+
+TEST(UrlUtilsTest, BuildsTargetsFromRoutes) {
+  using outline::api::Endpoints;
+  using outline::api::UrlParams;
+  static_assert(Endpoints::RenameAccessKey.placeholderCount() == 1);
+  static_assert(Endpoints::RenameAccessKey.placeholder(0) == UrlParams::KeyId);
+  static_assert(Endpoints::GetMetrics.placeholderCount() == 0);
+
+  EXPECT_EQ(outline::utils::buildTarget<Endpoints::GetMetrics>("/secret"),
+            "/secret/metrics/transfer");
+  EXPECT_EQ((outline::utils::buildTarget<Endpoints::RenameAccessKey,
+                                         UrlParams::KeyId>("/secret", {"7"})),
+            "/secret/access-keys/7/name");
+  // An id cannot leave its path segment.
+  EXPECT_EQ((outline::utils::buildTarget<Endpoints::DeleteAccessKey,
+                                         UrlParams::KeyId>("", {"a/b?c d"})),
+            "/access-keys/a%2Fb%3Fc%20d");
+}
+
+TEST(UsageSeriesTest, AnswersWindowQueriesFromDeltas) {
+  using namespace std::chrono_literals;
+  outline::metrics::UsageSeries series(3);
+  auto t = outline::metrics::UsageSeries::Clock::now();
+  series.record({{{"a", 1000}}}, t);
+  series.record({{{"a", 1100}, {"b", 50}}}, t + 10s);
+  series.record({{{"a", 1300}, {"b", 80}}}, t + 20s);
+  EXPECT_EQ(series.bytesOverLast("a", 1), 200u);
+  EXPECT_EQ(series.bytesOverLast("a", 10), 300u);
+  EXPECT_EQ(series.bytesOverLast("b", 2), 80u);
+  EXPECT_DOUBLE_EQ(series.currentRate("a"), 20.0);
+
+  // A counter reset counts from zero and old intervals leave the window.
+  series.record({{{"a", 40}, {"b", 80}}}, t + 30s);
+  series.record({{{"a", 60}, {"b", 80}}}, t + 40s);
+  EXPECT_EQ(series.recordedIntervals(), 3u);
+  EXPECT_EQ(series.bytesOverLast("a", 3), 260u);
+  EXPECT_EQ(series.bytesOverLast("unknown", 3), 0u);
+}
+
+TEST(UsageSeriesTest, FreesKeysMissingForAWholeWindow) {
+  using namespace std::chrono_literals;
+  outline::metrics::UsageSeries series(2);
+  auto t = outline::metrics::UsageSeries::Clock::now();
+  series.record({{{"a", 10}, {"b", 10}}}, t);
+  for (int i = 1; i <= 3; ++i) {
+    series.record({{{"b", 10u + i}}}, t + i * 1s);
+  }
+  EXPECT_EQ(series.keyCount(), 1u);
+  EXPECT_EQ(series.bytesOverLast("a", 2), 0u);
+  EXPECT_EQ(series.bytesOverLast("b", 2), 2u);
+}
+
+TEST(MetricsArchiveTest, SumsRangesAcrossBlocksAndReopens) {
+  using namespace std::chrono_literals;
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "outline_test_archive.oma")
+          .string();
+  std::remove(path.c_str());
+  const auto t = outline::metrics::MetricsArchiveWriter::Clock::now();
+  {
+    // Two samples per block, so the queries cross block boundaries.
+    outline::metrics::MetricsArchiveWriter writer(path, {2});
+    writer.append({{{"a", 1000}}}, t);
+    writer.append({{{"a", 1100}, {"b", 50}}}, t + 10s);
+    writer.append({{{"a", 1300}, {"b", 80}}}, t + 20s);
+  }
+  {
+    outline::metrics::MetricsArchiveWriter writer(path, {2});
+    EXPECT_EQ(writer.sampleCount(), 3u);
+    // A counter reset counts from zero; a missing key transferred nothing.
+    writer.append({{{"a", 40}}}, t + 30s);
+    writer.append({{{"a", 60}, {"b", 95}}}, t + 40s);
+  }
+
+  outline::metrics::MetricsArchiveReader reader(path);
+  EXPECT_EQ(reader.sampleCount(), 5u);
+  EXPECT_EQ(reader.keys(), (std::vector<std::string>{"a", "b"}));
+  EXPECT_EQ(reader.bytesBetween("a", t, t + 1h), 360u);
+  EXPECT_EQ(reader.bytesBetween("a", t + 10s, t + 30s), 300u);
+  EXPECT_EQ(reader.bytesBetween("b", t + 15s, t + 1h), 45u);
+  EXPECT_EQ(reader.bytesBetween("unknown", t, t + 1h), 0u);
+  EXPECT_EQ(reader.bytesByKeyBetween(t, t + 1h),
+            (std::vector<std::uint64_t>{360, 95}));
+  auto series = reader.series("b", t + 20s, t + 1h);
+  ASSERT_EQ(series.size(), 3u);
+  EXPECT_EQ(series[1].second, 0u);
+  EXPECT_EQ(series[2].second, 15u);
+  std::remove(path.c_str());
+}
+
+TEST(ReconcilePlanTest, EmitsOnlyTheRequiredCalls) {
+  std::vector<outline::AccessKey> current(4);
+  current[0].id = "0";
+  current[0].name = "alice";
+  current[0].dataLimit = outline::DataLimit{1024};
+  current[1].id = "1";
+  current[1].name = "bob";
+  current[2].id = "2";
+  current[2].name = "carol";
+  current[2].dataLimit = outline::DataLimit{1024};
+  current[3].id = "3";
+  current[3].name = "stale";
+
+  std::vector<outline::DesiredAccessKey> desired = {
+      {std::nullopt, "alice", 1024},
+      {std::string("1"), "robert", 2048},
+      {std::nullopt, "carol", std::nullopt},
+      {std::nullopt, "dave", std::nullopt},
+  };
+  auto plan = outline::planReconcile(current, desired);
+  using Type = outline::AccessKeyOperationType;
+  ASSERT_EQ(plan.operations.size(), 5u);
+  EXPECT_EQ(plan.unchanged, 1u);
+  EXPECT_EQ(plan.operations[0].type, Type::Rename);
+  EXPECT_EQ(plan.operations[0].name, "robert");
+  EXPECT_EQ(plan.operations[1].type, Type::AddDataLimit);
+  EXPECT_EQ(plan.operations[1].dataLimitBytes, 2048);
+  EXPECT_EQ(plan.operations[2].type, Type::DeleteDataLimit);
+  EXPECT_EQ(plan.operations[2].accessKeyId, "2");
+  EXPECT_EQ(plan.operations[3].type, Type::Create);
+  EXPECT_EQ(plan.operations[4].type, Type::Delete);
+  EXPECT_EQ(plan.operations[4].accessKeyId, "3");
+
+  outline::ReconcileOptions keepUnlisted;
+  keepUnlisted.deleteUnlisted = false;
+  EXPECT_EQ(outline::planReconcile(current, desired, keepUnlisted)
+                .operations.size(),
+            4u);
+}
+
+TEST(ReconcilePlanTest, CreatesMissingKeysUnderTheirId) {
+  std::vector<outline::AccessKey> current(1);
+  current[0].id = "1";
+  current[0].name = "bob";
+  std::vector<outline::DesiredAccessKey> desired = {
+      {std::string("7"), "alice", std::nullopt},
+      {std::string("1"), "bob", std::nullopt},
+  };
+  auto plan = outline::planReconcile(current, desired);
+  ASSERT_EQ(plan.operations.size(), 1u);
+  EXPECT_EQ(plan.operations[0].type, outline::AccessKeyOperationType::Create);
+  EXPECT_EQ(plan.operations[0].accessKeyId, "7");
+  EXPECT_EQ(plan.unchanged, 1u);
+
+  // Once the key exists under its id the plan settles.
+  current.resize(2);
+  current[1].id = "7";
+  current[1].name = "alice";
+  EXPECT_TRUE(outline::planReconcile(current, desired).empty());
+}
+
+TEST(ReconcilePlanTest, CreatesADuplicatedMissingIdOnce) {
+  std::vector<outline::DesiredAccessKey> desired = {
+      {std::string("7"), "alice", std::nullopt},
+      {std::string("7"), "alice again", 1024},
+  };
+  auto plan = outline::planReconcile({}, desired);
+  ASSERT_EQ(plan.operations.size(), 1u);
+  EXPECT_EQ(plan.operations[0].type, outline::AccessKeyOperationType::Create);
+  EXPECT_EQ(plan.operations[0].accessKeyId, "7");
+  EXPECT_EQ(plan.operations[0].params.name, "alice");
+}
+
+TEST(ReconcilePlanTest, MatchesDuplicateNamesPairwise) {
+  std::vector<outline::AccessKey> current(2);
+  current[0].id = "0";
+  current[0].name = "shared";
+  current[1].id = "1";
+  current[1].name = "shared";
+  auto plan = outline::planReconcile(
+      current, {{std::nullopt, "shared", std::nullopt}});
+  ASSERT_EQ(plan.operations.size(), 1u);
+  EXPECT_EQ(plan.operations[0].type, outline::AccessKeyOperationType::Delete);
+  EXPECT_EQ(plan.operations[0].accessKeyId, "1");
+  EXPECT_EQ(plan.unchanged, 1u);
+}
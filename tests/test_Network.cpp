@@ -0,0 +1,564 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "../include/outline/AccessKeyReconciler.h"
+#include "../include/outline/OutlineFleet.h"
+#include "../include/outline/cache/AccessKeyCache.h"
+#include "../include/outline/metrics/ClientStats.h"
+#include "../include/outline/metrics/LatencyHistogram.h"
+#include "../include/outline/network/CircuitBreaker.h"
+#include "../include/outline/network/HappyEyeballs.h"
+#include "../include/outline/network/RateLimiter.h"
+#include "../include/outline/network/RequestCoalescer.h"
+#include "../include/outline/network/RetryPolicy.h"
+#include "../include/outline/testing/MockOutlineServer.h"
+
+TEST(RetryPolicyTest, BackoffIsCappedAndJittered) {
+  outline::network::RetryOptions options;
+  options.maxAttempts = 4;
+  options.initialBackoff = std::chrono::milliseconds(100);
+  options.maxBackoff = std::chrono::milliseconds(300);
+  outline::network::RetryPolicy policy(options);
+
+  EXPECT_TRUE(policy.shouldRetry(3));
+  EXPECT_FALSE(policy.shouldRetry(4));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_LE(policy.backoff(1), std::chrono::milliseconds(100));
+    EXPECT_LE(policy.backoff(2), std::chrono::milliseconds(200));
+    EXPECT_LE(policy.backoff(40), std::chrono::milliseconds(300));
+  }
+}
+
+TEST(CircuitBreakerTest, OpensAfterThresholdAndProbesAfterCoolDown) {
+  outline::network::CircuitBreakerOptions options;
+  options.failureThreshold = 2;
+  options.coolDown = std::chrono::milliseconds(20);
+  outline::network::CircuitBreaker breaker(options);
+
+  ASSERT_TRUE(breaker.allow());
+  breaker.recordFailure();
+  ASSERT_TRUE(breaker.allow());
+  breaker.recordFailure();
+  EXPECT_EQ(breaker.stats().state, outline::network::CircuitState::Open);
+  EXPECT_FALSE(breaker.allow());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  ASSERT_TRUE(breaker.allow());
+  // Only one probe at a time.
+  EXPECT_FALSE(breaker.allow());
+  breaker.recordSuccess();
+
+  auto stats = breaker.stats();
+  EXPECT_EQ(stats.state, outline::network::CircuitState::Closed);
+  EXPECT_EQ(stats.opened, 1u);
+  EXPECT_EQ(stats.rejected, 2u);
+  EXPECT_TRUE(breaker.allow());
+}
+
+TEST(CircuitBreakerTest, FailedProbeOpensAgain) {
+  outline::network::CircuitBreakerOptions options;
+  options.failureThreshold = 1;
+  options.coolDown = std::chrono::milliseconds(10);
+  outline::network::CircuitBreaker breaker(options);
+
+  breaker.allow();
+  breaker.recordFailure();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(breaker.allow());
+  breaker.recordFailure();
+  EXPECT_EQ(breaker.stats().state, outline::network::CircuitState::Open);
+  EXPECT_EQ(breaker.stats().opened, 2u);
+  EXPECT_FALSE(breaker.allow());
+}
+
+TEST(RateLimiterTest, DelaysRequestsBeyondTheBurst) {
+  outline::network::RateLimiterOptions options;
+  options.enabled = true;
+  options.requestsPerSecond = 100;
+  options.burst = 2;
+  options.maxQueueDepth = 3;
+  outline::network::RateLimiter limiter(options);
+  boost::asio::io_context context;
+
+  std::atomic<int> rejected{0};
+  auto started = std::chrono::steady_clock::now();
+  for (int i = 0; i < 6; ++i) {
+    boost::asio::co_spawn(
+        context,
+        [&]() -> boost::asio::awaitable<void> {
+          try {
+            co_await limiter.acquire();
+          } catch (const outline::OutlineRateLimitedException&) {
+            ++rejected;
+          }
+        },
+        boost::asio::detached);
+  }
+  context.run();
+
+  // Two requests use the burst, three wait 10, 20 and 30 ms and the sixth
+  // finds the queue full.
+  EXPECT_GE(std::chrono::steady_clock::now() - started,
+            std::chrono::milliseconds(25));
+  EXPECT_EQ(rejected.load(), 1);
+  auto stats = limiter.stats();
+  EXPECT_EQ(stats.acquired, 5u);
+  EXPECT_EQ(stats.delayed, 3u);
+  EXPECT_EQ(stats.rejected, 1u);
+  EXPECT_EQ(stats.queueDepth, 0u);
+  EXPECT_EQ(stats.maxQueueDepth, 3u);
+  EXPECT_EQ(stats.waits.count, 3u);
+}
+
+TEST(RequestCoalescerTest, SharesOneRequestUntilInvalidated) {
+  using Response = outline::network::RequestCoalescer::Response;
+  outline::network::RequestCoalescer coalescer({});
+  boost::asio::io_context context;
+
+  int fetches = 0;
+  auto fetch = [&]() -> boost::asio::awaitable<Response> {
+    const int id = ++fetches;
+    boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor,
+                                    std::chrono::milliseconds(10));
+    co_await timer.async_wait(boost::asio::use_awaitable);
+    co_return Response(200, std::to_string(id));
+  };
+  std::vector<std::string> bodies;
+  auto get = [&]() -> boost::asio::awaitable<void> {
+    auto response = co_await coalescer.run("/keys", fetch);
+    bodies.push_back(response.second);
+  };
+  for (int i = 0; i < 3; ++i) {
+    boost::asio::co_spawn(context, get, boost::asio::detached);
+  }
+  context.poll();
+  // A read after a write must not get the response of the earlier read.
+  coalescer.invalidate();
+  boost::asio::co_spawn(context, get, boost::asio::detached);
+  context.run();
+
+  EXPECT_EQ(fetches, 2);
+  EXPECT_EQ(bodies, (std::vector<std::string>{"1", "1", "1", "2"}));
+  auto stats = coalescer.stats();
+  EXPECT_EQ(stats.sent, 2u);
+  EXPECT_EQ(stats.coalesced, 2u);
+  EXPECT_EQ(stats.inFlight, 0u);
+}
+
+TEST(HappyEyeballsTest, FallsBackAndRemembersTheWinner) {
+  using tcp = boost::asio::ip::tcp;
+  boost::asio::io_context context;
+  const auto loopback = boost::asio::ip::make_address("127.0.0.1");
+  tcp::acceptor listening(context, {loopback, 0});
+  tcp::endpoint refused;
+  {
+    // Nothing listens on the port once the acceptor is closed.
+    tcp::acceptor closed(context, {loopback, 0});
+    refused = closed.local_endpoint();
+  }
+  std::vector<tcp::endpoint> endpoints{refused, listening.local_endpoint()};
+  auto results = tcp::resolver::results_type::create(
+      endpoints.begin(), endpoints.end(), "localhost", "443");
+  outline::network::HappyEyeballs racer({});
+
+  int connected = 0;
+  auto connect = [&]() -> boost::asio::awaitable<void> {
+    auto socket = co_await racer.connect("localhost:443", results,
+                                         std::chrono::seconds(5));
+    connected += socket.is_open();
+  };
+  boost::asio::co_spawn(context, connect, boost::asio::detached);
+  context.run();
+  EXPECT_EQ(racer.order("localhost:443", results).front(),
+            listening.local_endpoint());
+  context.restart();
+  boost::asio::co_spawn(context, connect, boost::asio::detached);
+  context.run();
+
+  EXPECT_EQ(connected, 2);
+  auto stats = racer.stats();
+  EXPECT_EQ(stats.connects, 2u);
+  EXPECT_EQ(stats.fallbacks, 1u);
+  EXPECT_EQ(stats.remembered, 1u);
+  EXPECT_EQ(stats.attempts, 3u);
+  EXPECT_EQ(stats.failedAttempts, 1u);
+}
+
+TEST(HappyEyeballsTest, InterleavesAddressFamilies) {
+  using tcp = boost::asio::ip::tcp;
+  std::vector<tcp::endpoint> endpoints{
+      {boost::asio::ip::make_address("2001:db8::1"), 443},
+      {boost::asio::ip::make_address("2001:db8::2"), 443},
+      {boost::asio::ip::make_address("192.0.2.1"), 443}};
+  auto results = tcp::resolver::results_type::create(
+      endpoints.begin(), endpoints.end(), "example.com", "443");
+  outline::network::HappyEyeballs racer({});
+  EXPECT_EQ(racer.order("example.com:443", results),
+            (std::vector<tcp::endpoint>{endpoints[0], endpoints[2],
+                                        endpoints[1]}));
+}
+
+TEST(AccessKeyCacheTest, ServesUntilInvalidatedByAWrite) {
+  outline::cache::AccessKeyCacheOptions options;
+  options.enabled = true;
+  outline::cache::AccessKeyCache cache(options);
+  const std::string all = outline::cache::AccessKeyCache::kAllKeys;
+
+  EXPECT_FALSE(cache.find("1").has_value());
+  cache.store("1", 200, R"({"id":"1"})", cache.generation());
+  cache.store("2", 404, "", cache.generation());
+  cache.store(all, 200, R"({"accessKeys":[]})", cache.generation());
+  cache.store("3", 500, "", cache.generation());
+  EXPECT_EQ(cache.find("1")->second, R"({"id":"1"})");
+  EXPECT_EQ(cache.find("2")->first, 404);
+  EXPECT_FALSE(cache.find("3").has_value());
+
+  // A read which started before the write must not store its response.
+  const auto generation = cache.generation();
+  cache.invalidate("1");
+  cache.store("1", 200, R"({"id":"1","name":"old"})", generation);
+  EXPECT_FALSE(cache.find("1").has_value());
+  EXPECT_FALSE(cache.find(all).has_value());
+  EXPECT_TRUE(cache.find("2").has_value());
+
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.negativeHits, 2u);
+  EXPECT_EQ(stats.misses, 4u);
+  EXPECT_EQ(stats.invalidations, 1u);
+}
+
+TEST(AccessKeyCacheTest, NegativeEntriesExpireSooner) {
+  using namespace std::chrono_literals;
+  outline::cache::AccessKeyCacheOptions options;
+  options.enabled = true;
+  options.negativeTtl = 20ms;
+  outline::cache::AccessKeyCache cache(options);
+  cache.store("1", 200, "{}", cache.generation());
+  cache.store("2", 404, "", cache.generation());
+  std::this_thread::sleep_for(50ms);
+  EXPECT_TRUE(cache.find("1").has_value());
+  EXPECT_FALSE(cache.find("2").has_value());
+}
+
+TEST(LatencyHistogramTest, PercentilesStayWithinBucketPrecision) {
+  using outline::metrics::LatencyHistogram;
+  for (std::uint64_t micros : {0ull, 15ull, 16ull, 1000ull, 123456ull}) {
+    const std::size_t index = LatencyHistogram::bucketIndex(micros);
+    EXPECT_LE(micros, LatencyHistogram::bucketUpperBound(index));
+    if (index > 0) {
+      EXPECT_GT(micros, LatencyHistogram::bucketUpperBound(index - 1));
+    }
+  }
+
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(std::chrono::microseconds(i * 100));
+  }
+  auto snapshot = histogram.snapshot();
+  EXPECT_EQ(snapshot.count, 1000u);
+  EXPECT_EQ(snapshot.maxMicros, 100000u);
+  EXPECT_NEAR(snapshot.percentile(0.5).count(), 50000, 50000 / 16);
+  EXPECT_NEAR(snapshot.percentile(0.99).count(), 99000, 99000 / 16);
+  EXPECT_EQ(snapshot.percentile(1.0).count(), 100000);
+}
+
+TEST(RequestMetricsTest, RecordsOutcomesPerEndpoint) {
+  using outline::api::EndpointId;
+  outline::metrics::RequestMetrics metrics;
+  metrics.start(EndpointId::GetAccessKeys, 0).responded(200, 512);
+  metrics.start(EndpointId::GetAccessKeys, 0).responded(200, 256);
+  metrics.start(EndpointId::RenameAccessKey, 16).responded(404, 0);
+  metrics.start(EndpointId::RenameAccessKey, 16).timedOut();
+  {
+    auto abandoned = metrics.start(EndpointId::RenameAccessKey, 16);
+    EXPECT_EQ(metrics.snapshot()[static_cast<std::size_t>(
+                                     EndpointId::RenameAccessKey)]
+                  .inFlight,
+              1);
+  }
+
+  auto stats = metrics.snapshot();
+  const auto& get = stats[static_cast<std::size_t>(EndpointId::GetAccessKeys)];
+  EXPECT_EQ(get.name, "GetAccessKeys");
+  ASSERT_EQ(get.responsesByStatus.size(), 1u);
+  EXPECT_EQ(get.responsesByStatus[0], std::make_pair(200, std::uint64_t{2}));
+  EXPECT_EQ(get.bytesReceived, 768u);
+  const auto& rename =
+      stats[static_cast<std::size_t>(EndpointId::RenameAccessKey)];
+  EXPECT_EQ(rename.responses(), 1u);
+  EXPECT_EQ(rename.timeouts, 1u);
+  EXPECT_EQ(rename.failures, 1u);
+  EXPECT_EQ(rename.bytesSent, 48u);
+  EXPECT_EQ(rename.inFlight, 0);
+  EXPECT_EQ(rename.latency.count, 3u);
+
+  outline::metrics::ClientStats clientStats;
+  clientStats.endpoints = stats;
+  const std::string text = outline::metrics::toPrometheus(clientStats);
+  EXPECT_NE(text.find("outline_client_responses_total{endpoint="
+                      "\"GetAccessKeys\",code=\"200\"} 2"),
+            std::string::npos);
+  EXPECT_NE(text.find("outline_client_request_duration_seconds_count{"
+                      "endpoint=\"RenameAccessKey\"} 3"),
+            std::string::npos);
+  EXPECT_EQ(text.find("endpoint=\"GetMetrics\""), std::string::npos);
+}
+
+TEST(TimeoutTest, SilentServerRaisesTimeout) {
+  // The kernel completes the TCP handshake into the backlog, but nothing
+  // ever accepts, so the TLS handshake never completes.
+  boost::asio::io_context context;
+  boost::asio::ip::tcp::acceptor silent(
+      context, {boost::asio::ip::make_address("127.0.0.1"), 0});
+  outline::OutlineClientOptions options;
+  options.retry.maxAttempts = 1;
+  outline::OutlineClient client(
+      "https://127.0.0.1:" + std::to_string(silent.local_endpoint().port()) +
+          "/secret",
+      "", 1, options);
+  auto started = std::chrono::steady_clock::now();
+  EXPECT_THROW(client.getServerInformation(),
+               outline::OutlineTimeoutException);
+  EXPECT_LT(std::chrono::steady_clock::now() - started,
+            std::chrono::seconds(5));
+}
+
+TEST(OutlineFleetTest, SlowServersTimeOutIndependently) {
+  outline::FleetOptions options;
+  options.serverTimeout = std::chrono::milliseconds(300);
+  options.client.retry.maxAttempts = 1;
+  // Both servers answer long after the fleet's budget.
+  outline::testing::MockServerOptions mockOptions;
+  mockOptions.latency = std::chrono::seconds(3);
+  outline::testing::MockOutlineServer first(mockOptions);
+  outline::testing::MockOutlineServer second(mockOptions);
+  outline::OutlineFleet fleet({{first.apiUrl()}, {second.apiUrl()}}, options);
+  std::atomic<int> answers{0};
+  auto started = std::chrono::steady_clock::now();
+  auto results = fleet.getServerInformationAsync(
+      [&answers](const auto&) { ++answers; }).get();
+  EXPECT_LT(std::chrono::steady_clock::now() - started,
+            std::chrono::seconds(2));
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(answers.load(), 2);
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].index, i);
+    EXPECT_FALSE(results[i].value.has_value());
+    EXPECT_THROW(std::rethrow_exception(results[i].error),
+                 outline::OutlineTimeoutException);
+  }
+}
+
+TEST(MockOutlineServerTest, ServesTheClientOffline) {
+  outline::testing::MockServerOptions mockOptions;
+  mockOptions.initialKeys = 2;
+  outline::testing::MockOutlineServer server(mockOptions);
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5);
+
+  EXPECT_EQ(client->getServerInformationTyped().name, "Mock Outline Server");
+  outline::CreateAccessKeyParams params;
+  params.name = "alice";
+  params.data_limit_bytes = 1000;
+  outline::AccessKey created = client->createAccessKeyTyped(params);
+  EXPECT_EQ(created.name, "alice");
+  ASSERT_TRUE(created.dataLimit.has_value());
+  EXPECT_EQ(created.dataLimit->bytes, 1000);
+  EXPECT_EQ(client->getAccessKeysTyped().size(), 3u);
+  EXPECT_EQ(client->getMetricsTyped().bytesTransferredByUserId.size(), 3u);
+
+  client->renameAccessKey(created.id, "bob");
+  EXPECT_EQ(client->getAccessKeyTyped(created.id).name, "bob");
+  client->deleteAccessKey(created.id);
+  EXPECT_EQ(server.keyCount(), 2u);
+  try {
+    client->getAccessKeyTyped(created.id);
+    FAIL() << "expected the deleted key to be gone";
+  } catch (const outline::OutlineServerErrorException& e) {
+    EXPECT_EQ(e.status(), 404);
+  }
+}
+
+TEST(MockOutlineServerTest, DestroysTheClientMidRequest) {
+  outline::testing::MockServerOptions mockOptions;
+  mockOptions.initialKeys = 10;
+  mockOptions.latency = std::chrono::milliseconds(500);
+  outline::testing::MockOutlineServer server(mockOptions);
+  outline::OutlineClientOptions options;
+  options.accessKeyCache.enabled = true;
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5,
+                                               options);
+
+  // Coalesced, cached and measured requests and a write are all suspended
+  // on the server when the client goes away.
+  auto keys = client->getAccessKeysTypedAsync();
+  auto sameKeys = client->getAccessKeysTypedAsync();
+  auto info = client->getServerInformationAsync();
+  auto rename = client->renameAccessKeyAsync("0", "alice");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  client.reset();
+
+  // The abandoned calls fail instead of hanging.
+  EXPECT_ANY_THROW(keys.get());
+  EXPECT_ANY_THROW(sameKeys.get());
+  EXPECT_ANY_THROW(info.get());
+  EXPECT_ANY_THROW(rename.get());
+}
+
+TEST(MockOutlineServerTest, ReconcilesAgainstTheServerNotTheCache) {
+  outline::testing::MockOutlineServer server;
+  outline::OutlineClientOptions options;
+  options.accessKeyCache.enabled = true;
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5,
+                                               options);
+  auto other = outline::OutlineClient::create(server.apiUrl(), "", 5);
+  outline::AccessKeyReconciler reconciler(*client);
+  std::vector<outline::DesiredAccessKey> desired = {
+      {std::string("42"), "alice", std::nullopt}};
+
+  auto result = reconciler.apply(desired);
+  ASSERT_EQ(result.results.size(), 1u);
+  EXPECT_TRUE(result.results[0].success);
+  EXPECT_EQ(client->getAccessKeysTyped().size(), 1u);  // now cached
+  EXPECT_TRUE(reconciler.plan(desired).empty());
+
+  // A key added behind the client's back is seen despite the cached list.
+  other->createAccessKeyTyped({});
+  auto plan = reconciler.plan(desired);
+  ASSERT_EQ(plan.operations.size(), 1u);
+  EXPECT_EQ(plan.operations[0].type, outline::AccessKeyOperationType::Delete);
+}
+
+TEST(MockOutlineServerTest, ReusesPooledConnections) {
+  outline::testing::MockOutlineServer server;
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5);
+
+  for (int i = 0; i < 4; ++i) {
+    client->getServerInformationTyped();
+  }
+
+  auto stats = client->connectionPoolStats();
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.idle, 1u);
+  EXPECT_EQ(server.stats().connections, 1u);
+}
+
+TEST(MockOutlineServerTest, ResumesTlsSessions) {
+  outline::testing::MockOutlineServer server;
+  outline::OutlineClientOptions options;
+  // Every request opens a new connection and handshakes again.
+  options.connectionPool.enabled = false;
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5,
+                                               options);
+
+  for (int i = 0; i < 3; ++i) {
+    client->getServerInformationTyped();
+  }
+
+  auto stats = client->tlsHandshakeStats();
+  EXPECT_EQ(stats.fullHandshakes, 1u);
+  EXPECT_EQ(stats.resumedHandshakes, 2u);
+  EXPECT_EQ(server.stats().connections, 3u);
+}
+
+TEST(MockOutlineServerTest, ServesStaleResolutionsWhileRefreshing) {
+  outline::testing::MockOutlineServer server;
+  outline::OutlineClientOptions options;
+  // Every request connects, and so resolves the host.
+  options.connectionPool.enabled = false;
+  options.dns.ttl = std::chrono::milliseconds(200);
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5,
+                                               options);
+
+  client->getServerInformationTyped();
+  client->getServerInformationTyped();
+  auto stats = client->resolverCacheStats();
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.hits, 1u);
+
+  // An expired entry is served at once and refreshed in the background.
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  client->getServerInformationTyped();
+  for (int i = 0; i < 100 && client->resolverCacheStats().refreshes < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  stats = client->resolverCacheStats();
+  EXPECT_EQ(stats.staleHits, 1u);
+  EXPECT_EQ(stats.refreshes, 2u);
+  client->getServerInformationTyped();
+  EXPECT_EQ(client->resolverCacheStats().hits, 2u);
+
+  // An explicit refresh makes an expired entry fresh again.
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  client->refreshResolution().get();
+  client->getServerInformationTyped();
+  stats = client->resolverCacheStats();
+  EXPECT_EQ(stats.refreshes, 3u);
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.staleHits, 1u);
+  EXPECT_EQ(stats.misses, 1u);
+}
+
+TEST(MockOutlineServerTest, ServerAddressChangesDropCachedKeys) {
+  outline::testing::MockServerOptions mockOptions;
+  mockOptions.initialKeys = 2;
+  outline::testing::MockOutlineServer server(mockOptions);
+  outline::OutlineClientOptions options;
+  options.accessKeyCache.enabled = true;
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5,
+                                               options);
+
+  // Cached keys carry access URLs built from the host name and the port.
+  auto keys = client->getAccessKeysTyped();
+  client->getAccessKeyTyped(keys[0].id);
+  EXPECT_EQ(client->accessKeyCacheStats().entries, 2u);
+  client->setHostName("vpn.example.com");
+  EXPECT_EQ(client->accessKeyCacheStats().entries, 0u);
+
+  client->getAccessKeysTyped();
+  client->setDefaultPort(23456);
+  EXPECT_EQ(client->accessKeyCacheStats().entries, 0u);
+}
+
+TEST(MockOutlineServerTest, InjectsErrors) {
+  outline::testing::MockServerOptions mockOptions;
+  mockOptions.errorRate = 1;
+  mockOptions.errorStatus = 503;
+  outline::testing::MockOutlineServer server(mockOptions);
+  outline::OutlineClientOptions options;
+  options.retry.maxAttempts = 1;
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5,
+                                               options);
+
+  try {
+    client->getServerInformation();
+    FAIL() << "expected an injected error";
+  } catch (const outline::OutlineServerErrorException& e) {
+    EXPECT_EQ(e.status(), 503);
+  }
+  EXPECT_EQ(server.stats().injectedErrors, 1u);
+}
+
+TEST(MockOutlineServerTest, InflatesCompressedResponses) {
+  outline::testing::MockServerOptions mockOptions;
+  mockOptions.initialKeys = 500;
+  mockOptions.compression = true;
+  outline::testing::MockOutlineServer server(mockOptions);
+  outline::OutlineClientOptions options;
+  options.compression.enabled = true;
+  auto client = outline::OutlineClient::create(server.apiUrl(), "", 5,
+                                               options);
+
+  EXPECT_EQ(client->getAccessKeysTyped().size(), 500u);
+  std::size_t streamed = client->getAccessKeysStream(
+      [](outline::AccessKey&&) {});
+  EXPECT_EQ(streamed, 500u);
+  EXPECT_EQ(client->getMetricsTyped().bytesTransferredByUserId.size(), 500u);
+
+  auto stats = client->compressionStats();
+  EXPECT_EQ(stats.compressedResponses, 3u);
+  EXPECT_EQ(server.stats().compressedResponses, 3u);
+  EXPECT_LT(stats.compressedBytes * 4, stats.inflatedBytes);
+}